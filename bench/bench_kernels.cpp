@@ -0,0 +1,42 @@
+#include "benchmark.hpp"
+#include "geometry_kernels.hpp"
+#include <random>
+#include <vector>
+
+// The kernels by input size. Snap buckets and clicks in the game hold a
+// handful of items; the larger sizes show the cost per item.
+void runKernelBenchmarks(BenchRunner &runner) {
+  if (!runner.suiteEnabled("kernels/"))
+    return;
+
+  const size_t counts[] = {2, 4, 8, 16, 64, 1024};
+  const size_t largest = 1024;
+
+  // Points and 3x3 rectangles over a 100x100 area; nothing is near the
+  // probes, so every item is tested
+  std::mt19937 rng(runner.seed());
+  std::uniform_real_distribution<float> coord(0.0f, 100.0f);
+  std::vector<float> x(largest), y(largest);
+  std::vector<float> width(largest, 3.0f), height(largest, 3.0f);
+  std::vector<uint32_t> key(largest);
+  for (size_t i = 0; i < largest; ++i) {
+    x[i] = coord(rng);
+    y[i] = coord(rng);
+    key[i] = static_cast<uint32_t>(i);
+  }
+  const Vector2 outside = {-50.0f, -50.0f};
+
+  for (size_t count : counts) {
+    nlohmann::json params = {{"count", count}};
+    runner.run("kernels/min_key_within", params, [&] {
+      uint32_t k = GeometryKernels::minKeyWithin(
+          x.data(), y.data(), key.data(), count, outside, 10.0f, 0);
+      doNotOptimize(k);
+    });
+    runner.run("kernels/first_containing", params, [&] {
+      size_t hit = GeometryKernels::firstContaining(
+          x.data(), y.data(), width.data(), height.data(), count, outside);
+      doNotOptimize(hit);
+    });
+  }
+}
@@ -0,0 +1,101 @@
+#include "benchmark.hpp"
+#include "frame_arena.hpp"
+#include "level_manager.hpp"
+#include "ui_utils.hpp"
+#include <memory>
+
+// Gives the benchmarks access to the level's private helpers.
+struct LevelBenchmark {
+  static Pin *findSnapTarget(const ElectronicsLevel &level, Pin *source,
+                             float radius) {
+    return level.findSnapTarget(source, radius);
+  }
+  static void updateSpatialIndex(ElectronicsLevel &level) {
+    level.updateSpatialIndex();
+  }
+  static void updateSpatialEntry(ElectronicsLevel &level,
+                                 const ElectronicComponent &obj) {
+    level.updateSpatialEntry(obj);
+  }
+  static int countVisible(const ElectronicsLevel &level, Rectangle view) {
+    int n = 0;
+    level.component_index.query(view, [&](uint32_t) { n++; });
+    level.wire_index.query(view, [&](uint32_t) { n++; });
+    level.cross_wire_index.query(view, [&](uint32_t) { n++; });
+    return n;
+  }
+  static size_t findSnapTargets(const ElectronicsLevel &level,
+                                float radius) {
+    ArenaVector<ElectronicsLevel::SnapPair> snaps{
+        ArenaAllocator<ElectronicsLevel::SnapPair>(frameArena())};
+    level.findSnapTargets(radius, snaps);
+    return snaps.size();
+  }
+  static bool hasConnection(const ElectronicsLevel &level, Pin *a, Pin *b) {
+    return level.hasConnection(a, b);
+  }
+};
+
+void runLevelBenchmarks(BenchRunner &runner) {
+  if (!runner.suiteEnabled("level/") &&
+      !runner.suiteEnabled("components/"))
+    return;
+
+  const float snapRadius = 10.0f * safeScreenScale;
+
+  for (int parts : BENCH_SIZES) {
+    auto level = std::make_unique<ElectronicsLevel>();
+    level->loadBoard(makeBenchBoard(runner, parts));
+    const auto &objects = level->getObjects();
+
+    nlohmann::json params = {{"parts", objects.size()},
+                             {"wires", level->getConnections().size()}};
+
+    // The source pin has no partner in range: the spatial index finds
+    // nothing near it.
+    LevelBenchmark::updateSpatialIndex(*level);
+    Pin *lonely = &objects.back()->pins[1];
+    objects.back()->position = {-1e6f, -1e6f};
+    objects.back()->update();
+    LevelBenchmark::updateSpatialEntry(*level, *objects.back());
+    runner.run("level/find_snap_target", params, [&] {
+      Pin *p = LevelBenchmark::findSnapTarget(*level, lonely, snapRadius);
+      doNotOptimize(p);
+    });
+
+    // Worst case again: a pair that is not wired, so every wire is scanned.
+    Pin *a = &objects.front()->pins[0];
+    runner.run("level/has_connection", params, [&] {
+      bool found = LevelBenchmark::hasConnection(*level, a, lonely);
+      doNotOptimize(found);
+    });
+
+    // A snap query for every pin, one at a time through the spatial index
+    runner.run("level/snap_each_pin", params, [&] {
+      int hits = 0;
+      for (auto &obj : objects)
+        for (auto &pin : obj->pins)
+          hits += LevelBenchmark::findSnapTarget(*level, &pin, snapRadius) !=
+                  nullptr;
+      doNotOptimize(hits);
+    });
+
+    // What updateLevel() does on mouse release
+    runner.run("level/snap_all_pins", params, [&] {
+      frameArena().reset();
+      size_t hits = LevelBenchmark::findSnapTargets(*level, snapRadius);
+      doNotOptimize(hits);
+    });
+
+    // What drawLevel() culls against: one 1080p screen of the board
+    runner.run("level/visible_query", params, [&] {
+      int n = LevelBenchmark::countVisible(*level, {0, 0, 1920, 1080});
+      doNotOptimize(n);
+    });
+
+    runner.run("components/update", params, [&] {
+      for (auto &obj : objects)
+        obj->update();
+    });
+  }
+}
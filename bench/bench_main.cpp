@@ -0,0 +1,87 @@
+#include "benchmark.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static void printUsage() {
+  fprintf(stderr,
+          "usage: voltquest_bench [--filter <substring>] [--out <file.json>]\n"
+          "                       [--min-time <seconds>] [--seed <n>]\n");
+}
+
+static nlohmann::json buildContext(const BenchOptions &options) {
+#if defined(__clang__)
+  std::string compiler = std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+  std::string compiler = std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+  std::string compiler = "msvc " + std::to_string(_MSC_VER);
+#else
+  std::string compiler = "unknown";
+#endif
+
+#ifdef NDEBUG
+  const char *build = "release";
+#else
+  const char *build = "debug";
+#endif
+
+  return {
+      {"timestamp", static_cast<long long>(std::time(nullptr))},
+      {"compiler", compiler},
+      {"build", build},
+      {"hardware_threads", std::thread::hardware_concurrency()},
+      {"seed", options.seed},
+      {"min_time_s", options.min_time},
+  };
+}
+
+int main(int argc, char **argv) {
+  BenchOptions options;
+  std::string outPath;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--filter" && hasValue) {
+      options.filter = argv[++i];
+    } else if (arg == "--out" && hasValue) {
+      outPath = argv[++i];
+    } else if (arg == "--min-time" && hasValue) {
+      options.min_time = std::atof(argv[++i]);
+    } else if (arg == "--seed" && hasValue) {
+      options.seed =
+          static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  BenchRunner runner(options);
+  runSimulationBenchmarks(runner);
+  runLevelBenchmarks(runner);
+  runTextureBenchmarks(runner);
+  runKernelBenchmarks(runner);
+
+  nlohmann::json report = {
+      {"context", buildContext(options)},
+      {"benchmarks", runner.results()},
+  };
+
+  if (outPath.empty()) {
+    std::cout << report.dump(2) << '\n';
+  } else {
+    std::ofstream out(outPath);
+    if (!out.is_open()) {
+      fprintf(stderr, "Failed to open %s\n", outPath.c_str());
+      return 1;
+    }
+    out << report.dump(2) << '\n';
+  }
+  return 0;
+}
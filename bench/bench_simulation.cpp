@@ -0,0 +1,210 @@
+#include "benchmark.hpp"
+#include "circuit_generator.hpp"
+#include "level_manager.hpp"
+#include "simulation/electronics_simulation.hpp"
+#include "simulation/parameter_sweep.hpp"
+#include "simulation/solution_cache.hpp"
+#include "simulation/tolerance_analysis.hpp"
+#include "thread_pool.hpp"
+#include <string>
+#include <vector>
+
+// Reaches into the solver pipeline so each stage can be timed on its own.
+// Every island of the board goes through the stage in turn.
+struct SimulationBenchmark {
+  static void clear(ElectronicsSimulation &sim) { sim.clearCache(); }
+  static void buildNets(ElectronicsSimulation &sim,
+                        const ElectronicsLevel &level) {
+    std::vector<uint32_t> parts, wires;
+    std::vector<ElectronicsSimulation::Island> replaced;
+    sim.clearCache();
+    sim.collectChanges(level.getBoardState(), parts, wires, replaced);
+    sim.groupIslands(level.getBoardState(), parts, wires);
+    sim.orderIslands();
+  }
+  static void buildPattern(ElectronicsSimulation &sim) {
+    for (ElectronicsSimulation::Island &island : sim.islands)
+      ElectronicsSimulation::buildPattern(island, sim.solver_backend);
+  }
+  static void stamp(ElectronicsSimulation &sim) {
+    for (ElectronicsSimulation::Island &island : sim.islands)
+      ElectronicsSimulation::stampMatrix(island);
+  }
+  static bool factorize(ElectronicsSimulation &sim) {
+    bool ok = true;
+    for (ElectronicsSimulation::Island &island : sim.islands)
+      ok &= island.matrix.n == 0 || island.factor.factorize(island.matrix);
+    return ok;
+  }
+  static void triangularSolve(ElectronicsSimulation &sim,
+                              std::vector<double> &x) {
+    for (ElectronicsSimulation::Island &island : sim.islands) {
+      if (island.matrix.n == 0)
+        continue;
+      x = island.rhs;
+      island.factor.solve(x);
+    }
+  }
+};
+
+// `tiles` independent circuits side by side, `parts` in all
+static BoardState makeTiledBoard(const BenchRunner &runner, int parts,
+                                 int tiles) {
+  BoardState board;
+  for (int t = 0; t < tiles; ++t) {
+    CircuitGeneratorOptions options;
+    options.topology = CircuitTopology::RandomPlanar;
+    options.parts = parts / tiles;
+    options.wire_density = 0.5f;
+    options.seed = runner.seed() + t;
+    BoardState tile = generateCircuit(options);
+
+    uint32_t base = static_cast<uint32_t>(board.components.size());
+    for (size_t id = 0; id < tile.components.size(); ++id)
+      board.components.push_back(tile.components[id]);
+    for (size_t id = 0; id < tile.connections.size(); ++id) {
+      ConnectionRecord wire = tile.connections[id];
+      wire.component_a += base;
+      wire.component_b += base;
+      board.connections.push_back(wire);
+    }
+  }
+  return board;
+}
+
+void runSimulationBenchmarks(BenchRunner &runner) {
+  if (!runner.suiteEnabled("simulation/"))
+    return;
+
+  for (int parts : BENCH_SIZES) {
+    ElectronicsLevel level;
+    level.loadBoard(makeBenchBoard(runner, parts));
+    const auto &objects = level.getObjects();
+    const auto &connections = level.getConnections();
+
+    ElectronicsSimulation sim;
+    sim.build(level.getBoardState());
+    sim.solve();
+
+    nlohmann::json params = {
+        {"parts", objects.size()},
+        {"wires", connections.size()},
+        {"unknowns", sim.unknownCount()},
+        {"nnz_matrix", sim.matrixNonZeros()},
+        {"nnz_factor", sim.factorNonZeros()},
+    };
+
+    runner.run("simulation/build_nets", params, [&] {
+      SimulationBenchmark::buildNets(sim, level);
+    });
+    runner.run("simulation/ordering_symbolic", params,
+               [&] { SimulationBenchmark::buildPattern(sim); });
+    runner.run("simulation/stamp", params,
+               [&] { SimulationBenchmark::stamp(sim); });
+    runner.run("simulation/factor", params, [&] {
+      bool ok = SimulationBenchmark::factorize(sim);
+      doNotOptimize(ok);
+    });
+
+    std::vector<double> x;
+    runner.run("simulation/triangular_solve", params, [&] {
+      SimulationBenchmark::triangularSolve(sim, x);
+      doNotOptimize(x.front());
+    });
+
+    // Full operating point: stamp, factor and solve until LED states settle
+    runner.run("simulation/build_and_solve", params, [&] {
+      SimulationBenchmark::clear(sim);
+      sim.build(level.getBoardState());
+      sim.solve();
+    });
+
+    // The same by conjugate gradient, which the automatic backend picks
+    // for islands past ITERATIVE_MIN_FILL
+    ElectronicsSimulation iterative;
+    iterative.setSolverBackend(ElectronicsSimulation::SolverBackend::Iterative);
+    runner.run("simulation/build_and_solve_iterative", params, [&] {
+      SimulationBenchmark::clear(iterative);
+      iterative.build(level.getBoardState());
+      iterative.solve();
+    });
+
+    // One resistor edited on a board of 16 separate circuits: only its
+    // island is regrouped, refactored and solved
+    if (parts >= 160) {
+      BoardState tiled = makeTiledBoard(runner, parts, 16);
+      ElectronicsSimulation edited;
+      edited.build(tiled);
+      edited.solve();
+      uint32_t resistor = 0;
+      while (tiled.components[resistor].label != ComponentLabel::Resistor)
+        ++resistor;
+      ComponentRecord rec = tiled.components[resistor];
+      float nominal = rec.resistance;
+
+      nlohmann::json editParams = {
+          {"parts", tiled.components.size()},
+          {"islands", edited.islandCount()},
+          {"threads", threadPool().size() + 1},
+      };
+      runner.run("simulation/edit_one_island", editParams, [&] {
+        rec.resistance = rec.resistance == nominal ? 2.0f * nominal : nominal;
+        tiled.components.set(resistor, rec);
+        edited.build(tiled);
+        edited.solve();
+        doNotOptimize(edited.lastSolvedIslands());
+      });
+      // The same edit and its undo, taken from a solution cache after the
+      // first round trip
+      SolutionCache cache;
+      edited.setSolutionCache(&cache);
+      runner.run("simulation/edit_one_island_cached", editParams, [&] {
+        rec.resistance = rec.resistance == nominal ? 2.0f * nominal : nominal;
+        tiled.components.set(resistor, rec);
+        edited.build(tiled);
+        edited.solve();
+        doNotOptimize(edited.lastCacheHits());
+      });
+      edited.setSolutionCache(nullptr);
+
+      runner.run("simulation/solve_all_islands", editParams, [&] {
+        SimulationBenchmark::clear(edited);
+        edited.build(tiled);
+        edited.solve();
+        doNotOptimize(edited.lastSolvedIslands());
+      });
+    }
+
+    // Inspector sweep of the first battery's voltage, on the thread pool
+    const BoardState &board = level.getBoardState();
+    ParameterSweep::Spec spec;
+    spec.points = 64;
+    for (uint32_t id = 0; id < board.components.size(); ++id) {
+      if (board.components[id].label == ComponentLabel::Battery) {
+        spec.component_id = id;
+        spec.to = 2.0f * board.components[id].voltage;
+        spec.probes.push_back(id);
+        break;
+      }
+    }
+    nlohmann::json sweepParams = params;
+    sweepParams["points"] = spec.points;
+    sweepParams["threads"] = threadPool().size() + 1;
+    runner.run("simulation/sweep", sweepParams, [&] {
+      ParameterSweep::Result result = ParameterSweep::run(sim, spec);
+      doNotOptimize(result.max_current);
+    });
+
+    // Monte Carlo over resistor tolerances
+    ToleranceAnalysis::Options tolerance;
+    tolerance.trials = 64;
+    nlohmann::json toleranceParams = params;
+    toleranceParams["trials"] = tolerance.trials;
+    toleranceParams["threads"] = threadPool().size() + 1;
+    runner.run("simulation/tolerance", toleranceParams, [&] {
+      ToleranceAnalysis::Report report =
+          ToleranceAnalysis::run(sim, board, tolerance);
+      doNotOptimize(report.trials_with_damage);
+    });
+  }
+}
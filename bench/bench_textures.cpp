@@ -0,0 +1,27 @@
+#include "benchmark.hpp"
+#include "texture_manager.hpp"
+#include <string>
+
+#ifndef VOLTQUEST_RESOURCE_DIR
+#define VOLTQUEST_RESOURCE_DIR "resources"
+#endif
+
+void runTextureBenchmarks(BenchRunner &runner) {
+  const char *images[] = {"battery", "led", "resistor"};
+  const float scales[] = {1.0f, 2.0f};
+
+  for (const char *image : images) {
+    std::string path = std::string(VOLTQUEST_RESOURCE_DIR) +
+                       "/assets/images/" + image + ".svg";
+
+    for (float scale : scales) {
+      // Parse + rasterize only; the GPU upload needs a window
+      SVGRaster raster;
+      nlohmann::json params = {{"image", image}, {"scale", scale}};
+      runner.run("textures/rasterize_svg", params, [&] {
+        TextureManager::RasterizeSVG(path, scale, raster);
+        doNotOptimize(raster.width);
+      });
+    }
+  }
+}
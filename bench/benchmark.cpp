@@ -0,0 +1,81 @@
+#include "benchmark.hpp"
+#include "circuit_generator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+bool BenchRunner::enabled(const std::string &name) const {
+  return options.filter.empty() ||
+         name.find(options.filter) != std::string::npos;
+}
+
+bool BenchRunner::suiteEnabled(const std::string &prefix) const {
+  // Only the part of the filter up to its first '/' has to fit the end of
+  // the prefix; a filter without one may match anywhere in a name
+  const std::string &filter = options.filter;
+  size_t slash = filter.find('/');
+  if (slash == std::string::npos)
+    return true;
+  size_t head = slash + 1;
+  return prefix.size() >= head &&
+         prefix.compare(prefix.size() - head, head, filter, 0, head) == 0;
+}
+
+void BenchRunner::run(const std::string &name, const nlohmann::json &params,
+                      const std::function<void()> &fn) {
+  if (!enabled(name))
+    return;
+
+  using Clock = std::chrono::steady_clock;
+  fn(); // warm-up: caches, lazily sized scratch buffers
+
+  std::vector<double> samples;
+  double total = 0.0;
+  while (static_cast<int>(samples.size()) < options.max_samples &&
+         (total < options.min_time ||
+          static_cast<int>(samples.size()) < options.min_samples)) {
+    auto start = Clock::now();
+    fn();
+    auto end = Clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    samples.push_back(ns);
+    total += ns * 1e-9;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  double mean = 0.0;
+  for (double s : samples)
+    mean += s;
+  mean /= samples.size();
+  double var = 0.0;
+  for (double s : samples)
+    var += (s - mean) * (s - mean);
+  double stddev = std::sqrt(var / samples.size());
+
+  nlohmann::json result = {
+      {"name", name},
+      {"params", params},
+      {"samples", samples.size()},
+      {"min_ns", samples.front()},
+      {"median_ns", samples[samples.size() / 2]},
+      {"mean_ns", mean},
+      {"stddev_ns", stddev},
+      {"max_ns", samples.back()},
+  };
+  results_json.push_back(result);
+
+  fprintf(stderr, "%-40s %-28s median %12.0f ns  (%zu samples)\n",
+          name.c_str(), params.dump().c_str(), samples[samples.size() / 2],
+          samples.size());
+}
+
+BoardState makeBenchBoard(const BenchRunner &runner, int parts) {
+  CircuitGeneratorOptions options;
+  options.topology = CircuitTopology::RandomPlanar;
+  options.parts = parts;
+  options.wire_density = 0.5f;
+  options.seed = runner.seed();
+  return generateCircuit(options);
+}
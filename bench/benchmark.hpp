@@ -0,0 +1,68 @@
+#ifndef VOLTQUEST_BENCHMARK_HPP
+#define VOLTQUEST_BENCHMARK_HPP
+
+#include "board_history.hpp"
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+struct BenchOptions {
+  std::string filter;     // run only cases whose name contains this
+  double min_time = 0.2;  // seconds of samples per case
+  int min_samples = 5;
+  int max_samples = 100000;
+  uint32_t seed = 1;      // every generated board derives from this
+};
+
+// Times benchmark cases and collects the results as JSON.
+class BenchRunner {
+public:
+  explicit BenchRunner(const BenchOptions &opts) : options(opts) {}
+
+  // Suites check this before doing expensive setup for a case.
+  bool enabled(const std::string &name) const;
+  // Whether any case named `prefix`... (e.g. "level/") can pass the filter.
+  // Suites check this rather than enabled(prefix), which a filter naming
+  // one of their cases fails.
+  bool suiteEnabled(const std::string &prefix) const;
+
+  // Calls fn() once to warm up, then times individual calls until both
+  // min_time and min_samples are reached. `params` describe the case (part
+  // count, matrix size, ...) and are copied into the result.
+  void run(const std::string &name, const nlohmann::json &params,
+           const std::function<void()> &fn);
+
+  uint32_t seed() const { return options.seed; }
+  const nlohmann::json &results() const { return results_json; }
+
+private:
+  BenchOptions options;
+  nlohmann::json results_json = nlohmann::json::array();
+};
+
+// Keeps the optimizer from discarding a result the benchmark never reads.
+template <typename T> inline void doNotOptimize(const T &value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "g"(&value) : "memory");
+#else
+  static volatile unsigned char sink;
+  sink = *reinterpret_cast<const volatile unsigned char *>(&value);
+  (void)sink;
+#endif
+}
+
+// Part counts every scaling benchmark runs at
+inline constexpr int BENCH_SIZES[] = {10, 100, 1000, 10000};
+
+// Random planar board of resistors, LEDs and batteries, generated from the
+// runner's seed
+BoardState makeBenchBoard(const BenchRunner &runner, int parts);
+
+// Suites
+void runSimulationBenchmarks(BenchRunner &runner);
+void runLevelBenchmarks(BenchRunner &runner);
+void runTextureBenchmarks(BenchRunner &runner);
+void runKernelBenchmarks(BenchRunner &runner);
+
+#endif // VOLTQUEST_BENCHMARK_HPP
@@ -0,0 +1,232 @@
+#ifndef BOARD_CHUNKS_HPP
+#define BOARD_CHUNKS_HPP
+
+#include "board_history.hpp"
+#include "raylib.h"
+#include "spatial_grid.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Grid coordinates of a chunk, packed into one integer
+using ChunkKey = uint64_t;
+
+// Fixed-size spatial partition of a board's records. A component belongs to
+// the chunk holding its position; a wire belongs to a chunk when both of its
+// ends do, and is a cross wire of both chunks otherwise. Kept up to date by
+// diffing the records against the board it last described, so an edit only
+// moves the ids it changed.
+class BoardChunks {
+public:
+  static constexpr float CHUNK_SIZE = 4096.0f; // world units
+
+  // Ids in each list are ascending
+  struct Chunk {
+    std::vector<uint32_t> components;
+    std::vector<uint32_t> wires;       // both ends in this chunk
+    std::vector<uint32_t> cross_wires; // one end in another chunk
+    // Changes whenever one of its components does; never reused
+    uint64_t revision = 0;
+  };
+
+  static ChunkKey keyAt(Vector2 world);
+  static Rectangle bounds(ChunkKey key);
+  // Calls fn(key) for every chunk overlapping `area`, empty or not
+  template <typename Fn> static void forEachKeyIn(Rectangle area, Fn &&fn);
+
+  void sync(const BoardState &board);
+
+  // nullptr for chunks without components or wires
+  const Chunk *find(ChunkKey key) const;
+
+  // Calls fn(wire id) for every wire between two live components that
+  // touches component `id`
+  template <typename Fn> void forEachWireOf(uint32_t id, Fn &&fn) const;
+  // The same, but also wires whose other end is gone or never existed
+  template <typename Fn> void forEachWireRecordOf(uint32_t id, Fn &&fn) const;
+
+private:
+  static ChunkKey pack(int x, int y) {
+    return (uint64_t)(uint32_t)x << 32 | (uint32_t)y;
+  }
+  static bool wireValid(const BoardState &board, uint32_t wire);
+
+  void fileComponent(const BoardState &board, uint32_t id, bool add);
+  void fileWire(const BoardState &board, uint32_t wire, bool add);
+  Chunk &touch(ChunkKey key);
+  void dropIfEmpty(ChunkKey key);
+
+  std::unordered_map<ChunkKey, Chunk> by_key;
+  BoardState synced; // the board the chunks describe
+  uint64_t revisions = 0;
+  // Live wire records by component, either end
+  std::vector<std::vector<uint32_t>> wires_of;
+};
+
+template <typename Fn>
+void BoardChunks::forEachKeyIn(Rectangle area, Fn &&fn) {
+  int x0 = (int)std::floor(area.x / CHUNK_SIZE);
+  int y0 = (int)std::floor(area.y / CHUNK_SIZE);
+  int x1 = (int)std::floor((area.x + area.width) / CHUNK_SIZE);
+  int y1 = (int)std::floor((area.y + area.height) / CHUNK_SIZE);
+  for (int y = y0; y <= y1; ++y)
+    for (int x = x0; x <= x1; ++x)
+      fn(pack(x, y));
+}
+
+template <typename Fn>
+void BoardChunks::forEachWireRecordOf(uint32_t id, Fn &&fn) const {
+  if (id >= wires_of.size())
+    return;
+  for (uint32_t wire : wires_of[id])
+    fn(wire);
+}
+
+template <typename Fn>
+void BoardChunks::forEachWireOf(uint32_t id, Fn &&fn) const {
+  forEachWireRecordOf(id, [&](uint32_t wire) {
+    if (wireValid(synced, wire))
+      fn(wire);
+  });
+}
+
+// A SpatialGrid per chunk, so memory follows the chunks that hold items,
+// not the largest id. Items are filed under the chunk the caller names and
+// keep their global ids; each chunk's grid numbers its own items densely.
+class ChunkedGrid {
+public:
+  void clear() {
+    parts.clear();
+    slot_of.clear();
+  }
+
+  // Inserts `id` under `chunk`, or moves it there
+  void update(uint32_t id, ChunkKey chunk, Rectangle bounds);
+  // A chunk's grid goes with its last item
+  void remove(uint32_t id);
+  size_t size() const { return slot_of.size(); }
+
+  // Calls fn(id) once for every item whose bounds overlap `area`, in no
+  // particular order. Doesn't allocate.
+  template <typename Fn> void query(Rectangle area, Fn &&fn) const;
+
+private:
+  struct Part {
+    SpatialGrid grid;
+    Rectangle extent = {0.0f, 0.0f, 0.0f, 0.0f}; // covers every item
+    std::vector<uint32_t> ids;                   // by slot
+    std::vector<uint32_t> free_slots;
+  };
+  struct Slot {
+    ChunkKey chunk;
+    uint32_t slot;
+  };
+
+  std::unordered_map<ChunkKey, Part> parts;
+  std::unordered_map<uint32_t, Slot> slot_of;
+};
+
+template <typename Fn>
+void ChunkedGrid::query(Rectangle area, Fn &&fn) const {
+  for (const auto &[key, part] : parts) {
+    if (!CheckCollisionRecs(part.extent, area))
+      continue;
+    part.grid.query(area, [&](uint32_t slot) { fn(part.ids[slot]); });
+  }
+}
+
+// The component records of evicted chunks, one page per chunk in a
+// temporary file that goes away with the level. A page is current while
+// its chunk's revision is the one it was written at; paging in reads it
+// instead of the board. Thread-safe.
+class ChunkPageFile {
+public:
+  struct Entry {
+    uint32_t id;
+    ComponentRecord record;
+  };
+
+  ChunkPageFile() = default;
+  ~ChunkPageFile();
+  ChunkPageFile(const ChunkPageFile &) = delete;
+  ChunkPageFile &operator=(const ChunkPageFile &) = delete;
+
+  void write(ChunkKey key, uint64_t revision, const BoardState &board,
+             const std::vector<uint32_t> &ids);
+  // False when there is no current page for the chunk
+  bool read(ChunkKey key, uint64_t revision, std::vector<Entry> &out);
+  size_t pageCount();
+
+private:
+  struct Page {
+    long offset;
+    uint32_t capacity; // entries
+    uint32_t count;
+    uint64_t revision;
+  };
+
+  bool open(); // the file is made by the first write
+
+  std::mutex mutex;
+  std::FILE *file = nullptr;
+  bool failed = false;
+  long end = 0;
+  std::unordered_map<ChunkKey, Page> pages;
+  std::vector<Entry> buffer; // reused by write()
+};
+
+// Builds the live components of chunks on the shared thread pool, so paging
+// a chunk in doesn't stall the frame. Jobs read the chunk's page if it has a
+// current one and an O(1) copy of the board otherwise; results name the
+// board generation they were built from, so the caller can drop results
+// that an edit has made stale. Jobs still running when the loader goes
+// away finish into state they share with it.
+class ChunkLoader {
+public:
+  struct Result {
+    ChunkKey key;
+    uint64_t generation;
+    std::vector<std::shared_ptr<ElectronicComponent>> objects;
+  };
+
+  ChunkLoader();
+
+  ChunkLoader(const ChunkLoader &) = delete;
+  ChunkLoader &operator=(const ChunkLoader &) = delete;
+
+  // Main thread only
+  void request(ChunkKey key, uint64_t generation,
+               const BoardChunks::Chunk &chunk, const BoardState &board);
+  bool pending(ChunkKey key) const { return in_flight.count(key) != 0; }
+  // Moves every finished job into `out`
+  void collect(std::vector<Result> &out);
+  // Builds a chunk now, on the calling thread
+  std::vector<std::shared_ptr<ElectronicComponent>>
+  load(ChunkKey key, const BoardChunks::Chunk &chunk, const BoardState &board);
+  // Writes an evicted chunk to the page file
+  void pageOut(ChunkKey key, const BoardChunks::Chunk &chunk,
+               const BoardState &board);
+  size_t pageCount() { return shared->pages.pageCount(); }
+
+private:
+  struct Shared {
+    ChunkPageFile pages;
+    std::mutex mutex; // guards `done`
+    std::vector<Result> done;
+  };
+
+  static std::vector<std::shared_ptr<ElectronicComponent>>
+  build(Shared &shared, ChunkKey key, uint64_t revision,
+        const BoardState &board, const std::vector<uint32_t> &ids);
+
+  std::shared_ptr<Shared> shared;
+  std::unordered_set<ChunkKey> in_flight;
+};
+
+#endif // BOARD_CHUNKS_HPP
@@ -0,0 +1,82 @@
+#ifndef BOARD_HISTORY_HPP
+#define BOARD_HISTORY_HPP
+
+#include "game_objects/electronic_components/electronics_base.hpp"
+#include "persistent_vector.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+// Plain-data description of one component, indexed by component id.
+struct ComponentRecord {
+  bool alive = false;
+  ComponentLabel label = ComponentLabel::Battery;
+  Vector2 position = {0.0f, 0.0f};
+  float voltage = 0.0f;
+  float current = 0.0f;
+  float resistance = 0.0f;
+
+  bool operator==(const ComponentRecord &o) const {
+    return alive == o.alive && label == o.label &&
+           position.x == o.position.x && position.y == o.position.y &&
+           voltage == o.voltage && current == o.current &&
+           resistance == o.resistance;
+  }
+};
+
+// Plain-data description of one wire, indexed by connection id.
+struct ConnectionRecord {
+  bool alive = false;
+  uint32_t component_a = 0;
+  int16_t pin_a = -1;
+  uint32_t component_b = 0;
+  int16_t pin_b = -1;
+
+  bool operator==(const ConnectionRecord &o) const {
+    return alive == o.alive && component_a == o.component_a &&
+           pin_a == o.pin_a && component_b == o.component_b &&
+           pin_b == o.pin_b;
+  }
+};
+
+// Snapshot of a live component's persistent state
+ComponentRecord makeComponentRecord(const ElectronicComponent &obj);
+
+// The live component `id` described by `rec`, with its colliders placed.
+// nullptr for kinds that have no game object. Safe on worker threads once
+// the textures are loaded.
+std::shared_ptr<ElectronicComponent>
+makeComponentFromRecord(const ComponentRecord &rec, uint32_t id);
+
+// A full board, stored as two persistent vectors. Copies are O(1) and share
+// every unchanged node with the version they were copied from.
+struct BoardState {
+  PersistentVector<ComponentRecord> components;
+  PersistentVector<ConnectionRecord> connections;
+};
+
+class BoardHistory {
+public:
+  static constexpr size_t MAX_DEPTH = 256;
+
+  // Starts a new timeline at `initial`, dropping all undo/redo steps.
+  void reset(const BoardState &initial);
+
+  // Pushes `state` as the newest step and clears the redo branch.
+  void commit(const BoardState &state);
+
+  bool canUndo() const { return !undo_stack.empty(); }
+  bool canRedo() const { return !redo_stack.empty(); }
+
+  // Both return the state to restore, or nullptr when there is none.
+  const BoardState *undo();
+  const BoardState *redo();
+
+private:
+  BoardState current;
+  std::deque<BoardState> undo_stack;
+  std::deque<BoardState> redo_stack;
+};
+
+#endif // BOARD_HISTORY_HPP
@@ -0,0 +1,36 @@
+#ifndef CIRCUIT_GENERATOR_HPP
+#define CIRCUIT_GENERATOR_HPP
+
+#include "board_history.hpp"
+#include <cstdint>
+#include <string>
+
+// Procedural boards for benchmarks, soak tests and solver validation. The
+// same options and seed always produce the same board.
+enum class CircuitTopology : uint8_t {
+  ResistorLadder, // R-2R ladder driven by one battery
+  ResistorMesh,   // square grid of resistors, battery across the corners
+  LedArray,       // parallel branches of current-limiting resistor + LED
+  SeriesParallel, // random series/parallel tree of resistors
+  RandomPlanar,   // triangulated jittered grid of mixed parts
+};
+
+struct CircuitGeneratorOptions {
+  CircuitTopology topology = CircuitTopology::ResistorMesh;
+  int parts = 100; // total components, batteries included
+  // Meshes and random planar netlists: fraction of the optional edges (the
+  // ones not needed to keep the board connected) that get a part, in [0, 1].
+  // The fixed topologies ignore it.
+  float wire_density = 1.0f;
+  uint32_t seed = 1;
+  float battery_voltage = 9.0f;
+};
+
+const char *circuitTopologyName(CircuitTopology topology);
+bool parseCircuitTopology(const std::string &name, CircuitTopology &out);
+
+// Builds the board as records that ElectronicsLevel::loadBoard() and
+// saveLevelFile() accept.
+BoardState generateCircuit(const CircuitGeneratorOptions &options);
+
+#endif // CIRCUIT_GENERATOR_HPP
@@ -0,0 +1,48 @@
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Reports files written below the watched directories, on a thread of its
+// own: inotify on Linux, modification times polled elsewhere. Each changed
+// file is reported once per burst of writes.
+class FileWatcher {
+public:
+  // Called on the watcher thread
+  using Handler = std::function<void(const std::string &path)>;
+
+  explicit FileWatcher(Handler handler) : handler(std::move(handler)) {}
+  ~FileWatcher();
+
+  FileWatcher(const FileWatcher &) = delete;
+  FileWatcher &operator=(const FileWatcher &) = delete;
+
+  // Watches `dir` and everything below it, including directories created
+  // later. Starts the thread on first use.
+  bool watch(const std::string &dir);
+
+private:
+  void run();
+  void addTree(const std::string &dir);
+  void scan(bool report); // polling fallback
+
+  Handler handler;
+  std::thread worker;
+  std::atomic<bool> stopping{false};
+  std::mutex mutex; // guards the members below
+
+  int inotify_fd = -1;
+  std::unordered_map<int, std::string> dirs; // by inotify watch descriptor
+
+  std::vector<std::string> roots;
+  std::unordered_map<std::string, std::filesystem::file_time_type> stamps;
+};
+
+#endif // FILE_WATCHER_HPP
@@ -0,0 +1,71 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Linear allocator for data that only lives for one frame: UI strings,
+// inspector lines, scratch lists. Allocation is a pointer bump and reset()
+// releases everything at once. A frame that outgrows the arena is served
+// from extra blocks, and the next reset() grows the arena to fit, so steady
+// frames never touch the global heap.
+class FrameArena {
+public:
+  static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+  explicit FrameArena(size_t capacity = DEFAULT_CAPACITY);
+
+  void *allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+  // printf into the arena; valid until the next reset()
+  const char *format(const char *fmt, ...)
+#if defined(__GNUC__)
+      __attribute__((format(printf, 2, 3)))
+#endif
+      ;
+
+  void reset();
+
+  size_t used() const { return offset; }
+  size_t capacity() const { return size; }
+
+private:
+  std::unique_ptr<char[]> data;
+  size_t size = 0;
+  size_t offset = 0;
+
+  std::vector<std::unique_ptr<char[]>> overflow;
+  size_t overflow_bytes = 0;
+};
+
+// The main thread's arena, reset at the start of every frame
+FrameArena &frameArena();
+
+// Lets standard containers live in an arena. Memory is only reclaimed by
+// FrameArena::reset(), so containers must not outlive the frame.
+template <typename T> struct ArenaAllocator {
+  using value_type = T;
+
+  FrameArena *arena;
+
+  explicit ArenaAllocator(FrameArena &arena) : arena(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *, size_t) {}
+
+  template <typename U> bool operator==(const ArenaAllocator<U> &o) const {
+    return arena == o.arena;
+  }
+  template <typename U> bool operator!=(const ArenaAllocator<U> &o) const {
+    return arena != o.arena;
+  }
+};
+
+template <typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif // FRAME_ARENA_HPP
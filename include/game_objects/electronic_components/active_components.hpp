@@ -13,6 +13,8 @@ struct Led : public ElectronicComponent {
   ComponentLabel label = ComponentLabel::Led;
 
   const Texture2D &component_texture = TextureManager::Get("led");
+  const Texture2D &impostor_atlas = TextureManager::Get("impostors");
+  const Rectangle &impostor_region = TextureManager::GetRegion("impostors/led");
 
   static constexpr float BASE_WIDTH = 60.0f;
   static constexpr float BASE_HEIGHT = 180.0f;
@@ -71,7 +73,29 @@ struct Led : public ElectronicComponent {
         {position.x, position.y, texture_box.width, texture_box.height},
         {0.0f, 0.0f}, 0.0f, WHITE);
     drawPins();
+    drawSelection();
+  }
+
+  // Same frame of the sprite sheet, from the impostor atlas
+  void drawImpostor() override {
+    Rectangle src = {impostor_region.x + texture_box.x * IMPOSTOR_SCALE,
+                     impostor_region.y + texture_box.y * IMPOSTOR_SCALE,
+                     texture_box.width * IMPOSTOR_SCALE,
+                     texture_box.height * IMPOSTOR_SCALE};
+    DrawTexturePro(
+        impostor_atlas, src,
+        {position.x, position.y, texture_box.width, texture_box.height},
+        {0.0f, 0.0f}, 0.0f, WHITE);
+    drawSelection();
+  }
+
+  Color blockColor() const override {
+    return powered   ? Color{255, 174, 0, 255}
+           : damaged ? Color{162, 48, 48, 255}
+                     : Color{217, 217, 217, 255};
+  }
 
+  void drawSelection() const {
     if (is_active) {
       DrawRectangleLinesEx(
           Rectangle{
@@ -0,0 +1,26 @@
+#ifndef COMPONENT_FACTORY_HPP
+#define COMPONENT_FACTORY_HPP
+
+#include "active_components.hpp"
+#include "electronics_base.hpp"
+#include "passive_components.hpp"
+#include "power_sources.hpp"
+#include <memory>
+
+// Creates a default-configured component of the given kind, or nullptr for
+// kinds that have no game object yet.
+inline std::shared_ptr<ElectronicComponent> makeComponent(ComponentLabel label,
+                                                          Vector2 pos) {
+  switch (label) {
+  case ComponentLabel::Battery:
+    return std::make_shared<Battery>(pos);
+  case ComponentLabel::Led:
+    return std::make_shared<Led>(pos);
+  case ComponentLabel::Resistor:
+    return std::make_shared<Resistor>(pos);
+  default:
+    return nullptr;
+  }
+}
+
+#endif // COMPONENT_FACTORY_HPP
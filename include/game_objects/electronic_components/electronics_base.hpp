@@ -1,11 +1,22 @@
 #ifndef ELECTRONICS_BASE_HPP
 #define ELECTRONICS_BASE_HPP
+#include "../../input_manager.hpp"
 #include "../../ui_utils.hpp"
 #include "../movable_object.hpp"
 #include "raylib.h"
 #include <cstdint>
 #include <vector>
 
+// How much of a part to draw, chosen by the level from its size on screen
+enum class DrawDetail : uint8_t {
+  Full,     // sprite, decorations, pin highlights
+  Impostor, // one quad from the impostor atlas
+  Block,    // a flat rectangle in the part's color
+};
+
+// Resolution of the "impostors" atlas relative to the full sprites
+constexpr float IMPOSTOR_SCALE = 0.5f;
+
 enum class PinType : uint8_t { Power, Ground, Input, Output, BiDirectional };
 
 enum class ComponentLabel : uint8_t {
@@ -26,7 +37,8 @@ private:
   float current = 0.0f;
   bool is_connected = false;
   int16_t index = -1;
-  int16_t node_id = -1;
+  int32_t node_id = -1;
+  uint32_t owner_id = 0;
 
 public:
   Pin(Vector2 relPos, PinType pinType)
@@ -46,6 +58,22 @@ public:
 
   PinType getPinType() const { return type; }
 
+  // Identifies the pin as pin `pin_index` of component `component_id`.
+  void setOwner(uint32_t component_id, int16_t pin_index) {
+    owner_id = component_id;
+    index = pin_index;
+  }
+  uint32_t getOwnerId() const { return owner_id; }
+  int16_t getIndex() const { return index; }
+
+  // Simulation results, written by ElectronicsSimulation
+  void setNodeId(int32_t id) { node_id = id; }
+  int32_t getNodeId() const { return node_id; }
+  void setVoltage(float v) { voltage = v; }
+  float getVoltage() const { return voltage; }
+  void setCurrent(float i) { current = i; }
+  float getCurrent() const { return current; }
+
   Color getColor() const {
     return (type == PinType::Power)    ? RED
            : (type == PinType::Ground) ? BLACK
@@ -57,6 +85,7 @@ public:
   }
 
   float getColliderSize() const { return collider_size; }
+  Rectangle getCollider() const { return collider; }
 
   void updateCollider(const Vector2 &componentPos) {
     collider.x = componentPos.x + relative_position.x - (collider.width / 2.0f);
@@ -65,17 +94,21 @@ public:
   }
 
   bool isHovered() const {
-    return (CheckCollisionPointRec(GetMousePosition(), collider));
+    return (CheckCollisionPointRec(InputManager::GetCachedMousePos(),
+                                   collider));
   }
 };
 
 struct ElectronicComponent : public MovableObject {
   float voltage;
   float current;
-  float resistance;
+  float resistance = 0.0f;
   bool powered = false;
   bool damaged = false;
+  // On a closed loop through a battery, written by ElectronicsSimulation
+  bool battery_connected = false;
   ComponentLabel label;
+  uint32_t id = 0; // assigned by the level, stable across undo/redo
   std::vector<Pin> pins;
 
   ElectronicComponent(ComponentLabel component_label, Vector2 pos = {0, 0},
@@ -94,6 +127,24 @@ struct ElectronicComponent : public MovableObject {
     }
   };
 
+  // Stand-ins for draw() when the part is small on screen
+  virtual void drawImpostor() { draw(); }
+  virtual Color blockColor() const { return LIGHTGRAY; }
+
+  void drawAtDetail(DrawDetail detail) {
+    switch (detail) {
+    case DrawDetail::Full:
+      draw();
+      break;
+    case DrawDetail::Impostor:
+      drawImpostor();
+      break;
+    case DrawDetail::Block:
+      DrawRectangleRec(getCollider(), blockColor());
+      break;
+    }
+  }
+
   virtual ~ElectronicComponent() = default;
 };
 
@@ -101,11 +152,14 @@ class Connection {
 private:
   Pin *pin0 = nullptr;
   Pin *pin1 = nullptr;
+  uint32_t id = 0;
 
 public:
-  Connection(Pin *a, Pin *b) : pin0(a), pin1(b) {}
+  Connection(Pin *a, Pin *b, uint32_t connection_id = 0)
+      : pin0(a), pin1(b), id(connection_id) {}
 
   Pin *getPin(int index) const { return (index == 0) ? pin0 : pin1; }
+  uint32_t getId() const { return id; }
 
   Pin *other(const Pin *p) const {
     if (p == pin0)
@@ -115,13 +169,17 @@ public:
     return nullptr;
   }
 
-  void draw() const {
+  // Below full detail the wire is a single thin line
+  void draw(DrawDetail detail = DrawDetail::Full) const {
     if (!pin0 || !pin1)
       return;
+    drawWire(pin0->getCenterPosition(), pin1->getCenterPosition(),
+             pin1->getColor(), detail);
+  }
 
-    Vector2 a = pin0->getCenterPosition();
-    Vector2 b = pin1->getCenterPosition();
-
+  // Also used for wires whose parts aren't live objects
+  static void drawWire(Vector2 a, Vector2 b, Color wireColor,
+                       DrawDetail detail = DrawDetail::Full) {
     // Distance based visibility
     constexpr float DRAW_THRESHOLD = 20.0f; // base pixels
     float threshold = DRAW_THRESHOLD * safeScreenScale;
@@ -136,7 +194,10 @@ public:
     }
 
     // Draw visual wire
-    Color wireColor = pin1->getColor();
+    if (detail != DrawDetail::Full) {
+      DrawLineV(a, b, wireColor);
+      return;
+    }
 
     DrawLineEx(a, b, 8.0f * safeScreenScale, BLACK);     // Outline
     DrawLineEx(a, b, 6.0f * safeScreenScale, wireColor); // Inner
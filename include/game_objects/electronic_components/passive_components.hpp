@@ -10,6 +10,9 @@
 struct Resistor : public ElectronicComponent {
 
   const Texture2D &component_texture = TextureManager::Get("resistor");
+  const Texture2D &impostor_atlas = TextureManager::Get("impostors");
+  const Rectangle &impostor_region =
+      TextureManager::GetRegion("impostors/resistor");
   // Base dimensions and offsets as constants
   static constexpr float BASE_WIDTH = 215.0f;
   static constexpr float BASE_HEIGHT = 45.0f;
@@ -86,6 +89,21 @@ struct Resistor : public ElectronicComponent {
     DrawRectangleRec(BAND4, GOLD);
     drawPins();
 
+    drawSelection();
+  }
+
+  void drawImpostor() override {
+    DrawTexturePro(impostor_atlas, impostor_region,
+                   {position.x, position.y,
+                    static_cast<float>(component_texture.width),
+                    static_cast<float>(component_texture.height)},
+                   {0.0f, 0.0f}, 0.0f, WHITE);
+    drawSelection();
+  }
+
+  Color blockColor() const override { return Color{243, 180, 78, 255}; }
+
+  void drawSelection() const {
     if (is_active) {
       DrawRectangleLinesEx(
           Rectangle{position.x - BASE_SELECTION_OFFSET,
@@ -98,6 +116,6 @@ struct Resistor : public ElectronicComponent {
     }
   }
 
-  bool isBatteryConnected();
+  bool isBatteryConnected() const { return battery_connected; }
 };
 #endif
@@ -10,6 +10,9 @@
 struct Battery : public ElectronicComponent {
 
   const Texture2D &component_texture = TextureManager::Get("battery");
+  const Texture2D &impostor_atlas = TextureManager::Get("impostors");
+  const Rectangle &impostor_region =
+      TextureManager::GetRegion("impostors/battery");
 
   // Base dimensions and offsets as constants
   static constexpr float BASE_WIDTH = 110.0f;
@@ -62,6 +65,21 @@ struct Battery : public ElectronicComponent {
 
     drawPins();
 
+    drawSelection();
+  }
+
+  void drawImpostor() override {
+    DrawTexturePro(impostor_atlas, impostor_region,
+                   {position.x, position.y,
+                    static_cast<float>(component_texture.width),
+                    static_cast<float>(component_texture.height)},
+                   {0.0f, 0.0f}, 0.0f, WHITE);
+    drawSelection();
+  }
+
+  Color blockColor() const override { return Color{59, 59, 59, 255}; }
+
+  void drawSelection() const {
     if (is_active) {
       DrawRectangleLinesEx(
           Rectangle{position.x - BASE_SELECTION_OFFSET,
@@ -74,7 +92,7 @@ struct Battery : public ElectronicComponent {
     }
   }
 
-  bool isBatteryConnected();
+  bool isBatteryConnected() const { return battery_connected; }
 };
 
 #endif
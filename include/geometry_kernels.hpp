@@ -0,0 +1,26 @@
+#ifndef GEOMETRY_KERNELS_HPP
+#define GEOMETRY_KERNELS_HPP
+
+#include "raylib.h"
+#include <cstddef>
+#include <cstdint>
+
+// Hit tests over many points or rectangles at once, on structure-of-arrays
+// input. Callers bucket the items first, so each call sees only a handful:
+// a snap bucket or the parts under a click.
+namespace GeometryKernels {
+
+// Index of the first rectangle containing `point`, by the rules of
+// CheckCollisionPointRec(); `count` if there is none
+size_t firstContaining(const float *x, const float *y, const float *width,
+                       const float *height, size_t count, Vector2 point);
+
+// Smallest key[i] whose point lies within `radius` of `center`, ignoring
+// keys equal to `skip`; UINT32_MAX if there is none
+uint32_t minKeyWithin(const float *x, const float *y, const uint32_t *key,
+                      size_t count, Vector2 center, float radius,
+                      uint32_t skip);
+
+} // namespace GeometryKernels
+
+#endif // GEOMETRY_KERNELS_HPP
@@ -0,0 +1,24 @@
+#ifndef HOT_RELOAD_HPP
+#define HOT_RELOAD_HPP
+
+#include <string>
+
+class ElectronicsLevel;
+
+// Picks up changed SVGs and the open level file while the game runs. A
+// FileWatcher thread re-rasterizes or re-parses just the changed files, and
+// Apply() swaps the results in between frames, so a frame never sees half
+// of a reload.
+struct HotReload {
+  // Watches `resourceDir` for the rest of the run
+  static void Start(const std::string &resourceDir);
+  static void Stop();
+
+  // The level whose board follows `path`; nullptr stops following
+  static void WatchLevel(ElectronicsLevel *level, const std::string &path);
+
+  // Main thread, at a frame boundary
+  static void Apply();
+};
+
+#endif // HOT_RELOAD_HPP
@@ -4,14 +4,49 @@
 #define INPUT_MANAGER_HPP
 #include "game_objects/movable_object.hpp"
 #include "raylib.h"
+#include <bitset>
+#include <cstdint>
+
+// Keyboard keys are raylib KeyboardKey codes, all of which are below this
+constexpr int INPUT_MAX_KEYS = 512;
+constexpr int INPUT_MAX_MOUSE_BUTTONS = 7;
+
+// Everything the game reads from the mouse and keyboard in one frame. Live
+// play samples raylib into it; replays feed recorded frames instead, so a
+// session runs the same way every time.
+struct InputFrame {
+  Vector2 mouse = {0, 0};
+  uint8_t mouse_buttons = 0; // one bit per MouseButton held down
+  float wheel = 0.0f;         // mouse wheel movement this frame
+  std::bitset<INPUT_MAX_KEYS> keys; // held down
+};
 
 namespace InputManager {
+// The mouse in the level's world space, set once per frame by
+// updateMousePos(). Dragging and pin hover use this position.
 Vector2 GetCachedMousePos();
 MovableObject *GetActiveSelection();
 
 void ClearActiveSelection();
-void updateMousePos();
+void updateMousePos(const Camera2D &camera);
 void updateDragInputs(MovableObject &gameObject);
+
+// Starts a frame from live raylib input, or from a recorded frame. Pressed
+// and released are edges against the previous frame.
+void beginFrame();
+void beginFrame(const InputFrame &frame);
+const InputFrame &currentFrame();
+
+// Same meaning as the raylib functions, answered from the current frame
+Vector2 GetMousePosition();
+Vector2 GetMouseDelta();
+float GetMouseWheelMove();
+bool IsKeyDown(int key);
+bool IsKeyPressed(int key);
+bool IsKeyReleased(int key);
+bool IsMouseButtonDown(int button);
+bool IsMouseButtonPressed(int button);
+bool IsMouseButtonReleased(int button);
 } // namespace InputManager
 
 #endif
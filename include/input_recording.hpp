@@ -0,0 +1,52 @@
+#ifndef INPUT_RECORDING_HPP
+#define INPUT_RECORDING_HPP
+
+#include "board_history.hpp"
+#include "input_manager.hpp"
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Binary input recording of one level session (all integers little-endian):
+//
+//   "VQINPUT" '\0', u32 version, i32 screen width, i32 screen height,
+//   f32 camera target x, y, offset x, y, rotation and zoom, u8 streaming
+//   (both version 3 and later), u32 length + level JSON of the starting
+//   board, then until end of file
+//   one record per frame: f32 mouse x, f32 mouse y, u8 mouse buttons,
+//   f32 mouse wheel (version 2 and later), u16 key count, u16 key codes
+//   held down.
+//
+// Frames are streamed as they happen, so a recording cut short by a crash
+// still replays up to its last complete frame.
+
+constexpr uint32_t INPUT_RECORDING_VERSION = 3;
+
+struct InputRecording {
+  int screen_width = 0;
+  int screen_height = 0;
+  // A level entered warm from the cache keeps where it was looking
+  Camera2D camera = {{0.0f, 0.0f}, {0.0f, 0.0f}, 0.0f, 1.0f};
+  bool streaming = false;
+  BoardState initial_board;
+  std::vector<InputFrame> frames;
+};
+
+class InputRecorder {
+public:
+  bool open(const std::string &path, const BoardState &initial_board,
+            const Camera2D &camera, bool streaming);
+  void write(const InputFrame &frame);
+  void close();
+  bool isOpen() const { return file.is_open(); }
+  size_t frameCount() const { return frames; }
+
+private:
+  std::ofstream file;
+  std::string buffer; // reused for each frame's record
+  size_t frames = 0;
+};
+
+bool loadInputRecording(const std::string &path, InputRecording &out);
+
+#endif // INPUT_RECORDING_HPP
@@ -0,0 +1,85 @@
+#ifndef LEVEL_CACHE_HPP
+#define LEVEL_CACHE_HPP
+
+#include "level_manager.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The level files under resources/levels, one folder per chapter:
+//
+//   levels/01_basics/01_first_light.json
+//
+// Chapters and levels are ordered by name. Read from the loose folder, as
+// the resource pack can't be listed.
+struct LevelCatalog {
+  struct Chapter {
+    std::string name;
+    std::vector<std::string> levels; // paths
+  };
+  std::vector<Chapter> chapters;
+
+  static LevelCatalog scan(const std::string &root);
+  // For menus: the file or folder name without its order prefix
+  static std::string displayName(const std::string &path);
+};
+
+// Levels ready to play without loading: the ones played last, kept warm,
+// and the ones the menus expect next, built on the thread pool while the
+// player is still choosing. A warm level is a whole ElectronicsLevel with
+// its board loaded, solved and paged in around the view, so entering one
+// costs nothing and leaving keeps its edits. At most CAPACITY are kept; the
+// least recently used goes first.
+class LevelCache {
+public:
+  static constexpr size_t CAPACITY = 4;
+
+  LevelCache() = default;
+  LevelCache(const LevelCache &) = delete;
+  LevelCache &operator=(const LevelCache &) = delete;
+
+  // Main thread. Replaces the levels waiting to be built with `paths`, most
+  // likely first; warm ones are skipped and a build in progress finishes.
+  void preload(const std::vector<std::string> &paths);
+
+  // Main thread, every menu frame: loads the textures every level shares
+  // on the first call, collects a finished build and starts the next.
+  void update();
+
+  // The level at `path` ("" for an empty board), taken out of the cache.
+  // Waits for it if it is being built and loads it now if it isn't warm;
+  // nullptr when the file doesn't load.
+  std::unique_ptr<ElectronicsLevel> acquire(const std::string &path);
+  // Takes a level back after play, as the most recently used
+  void release(const std::string &path,
+               std::unique_ptr<ElectronicsLevel> level);
+
+  bool isWarm(const std::string &path) const;
+  size_t size() const { return warm.size(); }
+  // Drops every level, after waiting for a build in progress
+  void clear();
+
+private:
+  struct Entry {
+    std::string path;
+    std::unique_ptr<ElectronicsLevel> level;
+  };
+  struct Job; // shared with its pool task
+
+  // Touches nothing outside the level, so it can run on the pool: the
+  // window size is read on the main thread and passed in
+  static std::unique_ptr<ElectronicsLevel> build(const std::string &path,
+                                                 const ViewSize &view);
+  void insert(const std::string &path,
+              std::unique_ptr<ElectronicsLevel> level);
+  void collect(bool wait);
+  void loadTextures();
+
+  std::vector<Entry> warm; // most recently used first
+  std::vector<std::string> queued;
+  std::shared_ptr<Job> job;
+  bool textures_loaded = false;
+};
+
+#endif // LEVEL_CACHE_HPP
@@ -0,0 +1,29 @@
+#ifndef LEVEL_FILE_HPP
+#define LEVEL_FILE_HPP
+
+#include "board_history.hpp"
+#include <string>
+
+// JSON level format:
+//
+// {
+//   "format": "voltquest-level", "version": 1,
+//   "components": [{"id": 0, "type": "battery", "x": 100, "y": 100,
+//                   "voltage": 9.0, "current": 0.02, "resistance": 0.0}],
+//   "wires": [{"from": [0, 0], "to": [1, 1]}]   // [component id, pin]
+// }
+//
+// Only live records are written; ids are compacted on load.
+
+constexpr int LEVEL_FILE_VERSION = 1;
+
+const char *componentTypeName(ComponentLabel label);
+bool parseComponentType(const std::string &name, ComponentLabel &out);
+
+std::string serializeBoard(const BoardState &board);
+bool parseBoard(const std::string &text, BoardState &out);
+
+bool saveLevelFile(const std::string &path, const BoardState &board);
+bool loadLevelFile(const std::string &path, BoardState &out);
+
+#endif // LEVEL_FILE_HPP
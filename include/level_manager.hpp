@@ -2,11 +2,31 @@
 #define LEVEL_MANAGER_H
 
 #include "../include/game_objects/electronic_components/electronics_base.hpp"
+#include "board_chunks.hpp"
+#include "board_history.hpp"
+#include "frame_arena.hpp"
 #include "raylib.h"
+#include "simulation/electronics_simulation.hpp"
+#include "simulation/parameter_sweep.hpp"
+#include "simulation/probe_trace.hpp"
+#include "spatial_grid.hpp"
 #include "ui_manager.hpp"
+#include "ui_utils.hpp"
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+// What laying out a board needs of the window it is shown in
+struct ViewSize {
+  float width = 0.0f;
+  float height = 0.0f;
+  float scale = 1.0f; // safeScreenScale
+  // The game window's; main thread only
+  static ViewSize ofWindow();
+};
+
 class ElectronicsLevel {
 private:
   std::vector<std::shared_ptr<ElectronicComponent>> objects;
@@ -16,18 +36,195 @@ private:
   bool is_placing_wire = false;
   std::shared_ptr<ElectronicComponent> wireStartObject = nullptr;
   Pin *wireStartPin = nullptr;
+  // Drops the selection and wire placement, but not the InputManager's
+  // drag, which only the main thread may touch
+  void deselect();
+
+  // Undo/redo: board_state mirrors the live board as persistent records and
+  // is committed to history after every finished edit.
+  BoardState board_state;
+  BoardHistory history;
+  std::vector<std::shared_ptr<ElectronicComponent>> objects_by_id;
+
+  // Rebuilt and re-solved only after an edit changed the board
+  ElectronicsSimulation simulation;
+
+  // Inspector sweep of the selected part; shown until the board changes
+  ParameterSweep sweep;
+  uint64_t sweep_generation = 0;
+  bool sweepable(const ElectronicComponent &obj) const;
+  void startSweep(const ElectronicComponent &obj);
+  // Returns false when there's no finished sweep of the selected part
+  bool drawSweepPlot(const Rectangle &area);
+
+  // Probed parts, sampled from their pins once per frame and plotted in the
+  // inspector when selected. `probe_window` is the plotted span in samples.
+  std::vector<ProbeTrace> probes;
+  uint64_t probe_window;
+  ProbeTrace *probeOf(uint32_t component_id);
+  void toggleProbe(const ElectronicComponent &obj);
+  void sampleProbes();
+  void drawProbePlot(const Rectangle &area, const ProbeTrace &probe);
+
+  // The board lives in world space under a pannable, zoomable camera; the
+  // side panel stays in screen space. `view` is read from the window at the
+  // start of every step, or handed to prepare().
+  Camera2D camera = {{0.0f, 0.0f}, {0.0f, 0.0f}, 0.0f, 1.0f};
+  ViewSize view;
+  void setView(const ViewSize &size);
+  void updateCamera();
+  Rectangle visibleWorldRect() const;
+
+  // World bounds of live components and of wires, filed by chunk, so
+  // drawing and hit tests only visit what is near. Edits update the ids
+  // they changed, found by diffing the board against `indexed`; paging a
+  // chunk adds or drops its entries; a dragged part is moved in place.
+  // Rebuilt whole only when the live scene or the screen scale is
+  // replaced. Parts are drawn and picked in id order, which doesn't depend
+  // on when streaming made them live.
+  ChunkedGrid component_index;
+  ChunkedGrid wire_index;       // wires within a chunk, while it is resident
+  ChunkedGrid cross_wire_index; // wires between chunks, always
+  BoardState indexed;
+  bool spatial_dirty = true;
+  void updateSpatialIndex();
+  void updateSpatialEntry(const ElectronicComponent &obj);
+  void indexComponent(uint32_t id);
+  void indexWire(uint32_t id);
+  bool overPanel();
+
+  // Wires are drawn from these, so wires to parts that aren't live still
+  // show. The indexed wires' shapes, by connection id.
+  struct WireShape {
+    Vector2 a;
+    Vector2 b;
+    Color color;
+  };
+  std::unordered_map<uint32_t, WireShape> wire_shapes;
+  WireShape wireShape(const ConnectionRecord &rec) const;
+
+  // Chunk streaming. With it on, only components in chunks near the view
+  // are live objects; the others exist as records only, which is all the
+  // solver needs. Chunks are paged in on the thread pool ahead of the view,
+  // or at once when about to show, and written to the loader's page file
+  // and dropped once far away.
+  bool streaming = false;
+  BoardChunks chunks;
+  bool chunks_dirty = true;
+  uint64_t board_generation = 0; // bumped by every board change
+  std::unordered_set<ChunkKey> resident;
+  ChunkLoader chunk_loader;
+  void boardChanged();
+  void ensureChunks();
+  // `dragged` is the part the InputManager drags, if any
+  void updateChunks(const ElectronicComponent *dragged);
+  bool chunkPinned(ChunkKey key, const ElectronicComponent *dragged) const;
+  void pageIn(ChunkKey key);
+  void installChunk(std::vector<std::shared_ptr<ElectronicComponent>> &live);
+  void evictChunk(ChunkKey key);
+  void linkWiresOf(const std::vector<uint32_t> &component_ids);
+  // Rebuilds the live objects from board_state
+  void reloadLiveScene();
+
+  // Side panel geometry, shared by its input handling and drawing. Cached
+  // and rebuilt only when the screen size changes.
+  static constexpr int INSPECTOR_MAX_LINES = 4;
+  struct PanelLayout {
+    Rectangle bounds;
+    Rectangle buttons[3];
+    float buttonOutline;
+    int buttonFontSize;
+    Vector2 wireHint;
+    Vector2 dividerStart;
+    Vector2 dividerEnd;
+    Vector2 inspectorLines[INSPECTOR_MAX_LINES];
+    int titleFontSize;
+    int valueFontSize;
+    Rectangle sweepButton;
+    Rectangle probeButton;
+    Rectangle sweepPlot;
+    Rectangle resetButton;
+  };
+  PanelLayout panel_layout;
+  LayoutStamp panel_layout_stamp;
+  const PanelLayout &panelLayout();
+  void updateComponentsPanel();
 
   Pin *findSnapTarget(Pin *source, float radius) const;
+  struct SnapPair {
+    Pin *pin;
+    Pin *target;
+  };
+  void findSnapTargets(float radius, ArenaVector<SnapPair> &out) const;
   bool hasConnection(Pin *a, Pin *b) const;
+  Pin *findPin(uint32_t component_id, int16_t pin_index) const;
+
+  void addObject(const std::shared_ptr<ElectronicComponent> &obj);
+  void removeObject(size_t index);
+  void addConnection(Pin *a, Pin *b);
+  void recordObject(const ElectronicComponent &obj);
+  void commitHistory();
+  void restoreState(const BoardState &target);
+
+  friend struct LevelBenchmark;
 
 public:
   ElectronicsLevel();
   ~ElectronicsLevel();
 
+  // One frame: stepLevel() then drawLevel()
   void processLevel();
+  // Input, edits and simulation without drawing (headless replays)
+  void stepLevel();
   void resetLevel();
-  void loadTextures();
+  void undo();
+  void redo();
+  // Drops the selection, a wire being placed and the drag in progress.
+  // Main thread, before playing a level built elsewhere.
+  void clearSelection();
+  // Starts a fresh undo history at the current board
+  void clearHistory();
+
+  // Replaces the board with `state` and starts a fresh undo history.
+  // Loading leaves input state alone, so it can run on any thread while
+  // nothing else uses the level.
+  void loadBoard(const BoardState &state);
+  bool loadFromFile(const std::string &path);
+  bool saveToFile(const std::string &path) const;
+  // Changes the board to `state` as one undoable edit. Only the parts and
+  // wires that differ are rebuilt.
+  void applyBoard(const BoardState &state);
+
+  // Off by default, so tools keep the whole board live
+  void setStreaming(bool enabled);
+  bool isStreaming() const { return streaming; }
+  size_t residentChunkCount() const { return resident.size(); }
+
+  const Camera2D &getCamera() const { return camera; }
+  void setCamera(const Camera2D &view_camera) { camera = view_camera; }
+
+  // Live components: with streaming on, only those near the view
+  const std::vector<std::shared_ptr<ElectronicComponent>> &getObjects() const {
+    return objects;
+  }
+  const std::vector<Connection> &getConnections() const {
+    return connections;
+  }
+  const BoardState &getBoardState() const { return board_state; }
+  // The sprites every level shares. Main thread, once, before any level
+  // creates components.
+  static void loadTextures();
+  // The work of the first frame, done ahead of time: pages in the chunks
+  // around a view of `size`, solves the board and indexes it. Reads no
+  // window or input state, so it can run on any thread while nothing else
+  // uses the level.
+  void prepare(const ViewSize &size);
   void updateLevel();
+  void updateSimulation();
+  // Builds and solves the board if it changed since the last solve
+  bool solveBoard();
+  // Records the last solve in solverTelemetry() and the profiler overlay
+  void recordSolverStats();
   void drawLevel();
   void drawComponentsPanel();
 };
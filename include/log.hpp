@@ -0,0 +1,91 @@
+#ifndef LOG_HPP
+#define LOG_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// Asynchronous logger. A LOG_* statement formats its message on the calling
+// thread straight into a slot of a fixed lock-free queue; a background
+// thread writes the queue to stdout in batches, one write per batch.
+// Statements work from any thread and never block or allocate: when the
+// queue is full the message is dropped and counted.
+//
+//   LOG_WARN("Failed to open SVG file: %s", path.c_str());
+//
+// Each record keeps its level, time and call site, written as
+//
+//   12.345 WARN texture_manager.cpp:53 Failed to open SVG file: ...
+//
+// Statements below VOLTQUEST_LOG_LEVEL compile to nothing, arguments
+// included, so debug logging in hot loops costs nothing in builds that
+// don't want it. Each statement rate limits itself: past BURST messages in
+// a second the rest are counted and the count is reported by the next
+// message from the same statement.
+
+#define VQ_LOG_LEVEL_DEBUG 0
+#define VQ_LOG_LEVEL_INFO 1
+#define VQ_LOG_LEVEL_WARN 2
+#define VQ_LOG_LEVEL_ERROR 3
+
+#ifndef VOLTQUEST_LOG_LEVEL
+#define VOLTQUEST_LOG_LEVEL VQ_LOG_LEVEL_INFO
+#endif
+
+namespace Log {
+
+enum class Level : uint8_t { Debug, Info, Warn, Error };
+
+static constexpr uint32_t BURST = 10;
+static constexpr uint64_t BURST_WINDOW_NS = 1000000000ull;
+
+// One per statement, static, so it needs no initialization at run time
+struct Site {
+  Level level;
+  const char *file;
+  int line;
+  std::atomic<uint64_t> window_start_ns{0};
+  std::atomic<uint32_t> window_count{0};
+  std::atomic<uint32_t> suppressed{0};
+};
+
+void write(Site &site, const char *format, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+// Blocks until every message logged before the call is written
+void flush();
+
+// Messages lost to a full queue
+uint64_t droppedCount();
+
+} // namespace Log
+
+#define VQ_LOG_AT(level, ...)                                                  \
+  do {                                                                         \
+    static ::Log::Site vq_log_site{level, __FILE__, __LINE__};                 \
+    ::Log::write(vq_log_site, __VA_ARGS__);                                    \
+  } while (0)
+
+#if VOLTQUEST_LOG_LEVEL <= VQ_LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) VQ_LOG_AT(::Log::Level::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if VOLTQUEST_LOG_LEVEL <= VQ_LOG_LEVEL_INFO
+#define LOG_INFO(...) VQ_LOG_AT(::Log::Level::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if VOLTQUEST_LOG_LEVEL <= VQ_LOG_LEVEL_WARN
+#define LOG_WARN(...) VQ_LOG_AT(::Log::Level::Warn, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#define LOG_ERROR(...) VQ_LOG_AT(::Log::Level::Error, __VA_ARGS__)
+
+#endif // LOG_HPP
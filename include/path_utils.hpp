@@ -5,6 +5,7 @@
 
 void initBasePath();
 std::string getResourcePath(const std::string &relativePath);
+std::string getResourcePackPath();
 
 static std::string basePath;
 
@@ -21,4 +22,9 @@ inline std::string getResourcePath(const std::string &relativePath) {
       .string();
 }
 
+// resources/ packed by voltquest_pack, next to the resources folder
+inline std::string getResourcePackPath() {
+  return (std::filesystem::path(basePath) / "resources.vqpack").string();
+}
+
 #endif // !PATH_UTILS_H
@@ -0,0 +1,147 @@
+#ifndef PERSISTENT_VECTOR_HPP
+#define PERSISTENT_VECTOR_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Immutable 32-way trie with structural sharing.
+//
+// Copying a PersistentVector is O(1) (it only copies the root pointer), and
+// set()/push_back() copy just the path from the root to the touched leaf, so
+// two versions share every node that did not change between them. diff()
+// exploits that sharing to visit only the leaves that differ.
+template <typename T> class PersistentVector {
+private:
+  static constexpr unsigned BITS = 5;
+  static constexpr size_t WIDTH = size_t(1) << BITS;
+  static constexpr size_t MASK = WIDTH - 1;
+
+  struct Node {
+    std::array<std::shared_ptr<const Node>, WIDTH> children{}; // branches
+    std::array<T, WIDTH> values{};                              // leaves
+  };
+  using NodePtr = std::shared_ptr<const Node>;
+
+  NodePtr root;
+  size_t count = 0;
+  unsigned shift = 0; // BITS * (depth - 1); 0 means root is a leaf
+
+  size_t capacity() const { return root ? WIDTH << shift : 0; }
+
+  static NodePtr setIn(const NodePtr &node, unsigned level, size_t index,
+                       const T &value) {
+    auto copy = node ? std::make_shared<Node>(*node) : std::make_shared<Node>();
+    if (level == 0) {
+      copy->values[index & MASK] = value;
+    } else {
+      size_t slot = (index >> level) & MASK;
+      copy->children[slot] =
+          setIn(copy->children[slot], level - BITS, index, value);
+    }
+    return copy;
+  }
+
+  // Reports every index stored under `node` (used when the other side has no
+  // counterpart for it).
+  template <typename Fn>
+  static void visitAll(const NodePtr &node, unsigned level, size_t base,
+                       size_t limit, Fn &fn) {
+    if (!node)
+      return;
+    if (level == 0) {
+      for (size_t i = 0; i < WIDTH && base + i < limit; ++i)
+        fn(base + i);
+      return;
+    }
+    for (size_t i = 0; i < WIDTH; ++i) {
+      size_t child_base = base + (i << level);
+      if (child_base >= limit)
+        break;
+      visitAll(node->children[i], level - BITS, child_base, limit, fn);
+    }
+  }
+
+  // Indices below `common` exist in both versions; the rest up to `limit`
+  // exist in only one of them and are always reported.
+  template <typename Fn>
+  static void diffNodes(const NodePtr &a, const NodePtr &b, unsigned level,
+                        size_t base, size_t common, size_t limit, Fn &fn) {
+    if (a == b)
+      return; // shared subtree, nothing changed underneath
+    if (!a || !b) {
+      visitAll(a ? a : b, level, base, limit, fn);
+      return;
+    }
+    if (level == 0) {
+      for (size_t i = 0; i < WIDTH && base + i < limit; ++i) {
+        if (base + i >= common || !(a->values[i] == b->values[i]))
+          fn(base + i);
+      }
+      return;
+    }
+    for (size_t i = 0; i < WIDTH; ++i) {
+      size_t child_base = base + (i << level);
+      if (child_base >= limit)
+        break;
+      diffNodes(a->children[i], b->children[i], level - BITS, child_base,
+                common, limit, fn);
+    }
+  }
+
+  // Wraps `node` in single-child branches until it sits at `target` shift, so
+  // two versions of different depth can be walked side by side.
+  static NodePtr liftTo(NodePtr node, unsigned from, unsigned target) {
+    while (node && from < target) {
+      auto parent = std::make_shared<Node>();
+      parent->children[0] = std::move(node);
+      node = std::move(parent);
+      from += BITS;
+    }
+    return node;
+  }
+
+public:
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  const T &operator[](size_t index) const {
+    const Node *node = root.get();
+    for (unsigned level = shift; level > 0; level -= BITS)
+      node = node->children[(index >> level) & MASK].get();
+    return node->values[index & MASK];
+  }
+
+  void set(size_t index, const T &value) {
+    if (index >= count)
+      return;
+    root = setIn(root, shift, index, value);
+  }
+
+  void push_back(const T &value) {
+    if (count == capacity() && root) {
+      auto parent = std::make_shared<Node>();
+      parent->children[0] = root;
+      root = parent;
+      shift += BITS;
+    }
+    root = setIn(root, shift, count, value);
+    ++count;
+  }
+
+  // Calls fn(index) for every index whose value differs between the two
+  // versions, including indices present in only one of them. Subtrees that
+  // are shared by both versions are skipped without being visited.
+  template <typename Fn> void diff(const PersistentVector &other, Fn fn) const {
+    unsigned level = shift > other.shift ? shift : other.shift;
+    size_t common = count < other.count ? count : other.count;
+    size_t limit = count > other.count ? count : other.count;
+    NodePtr a = liftTo(root, shift, level);
+    NodePtr b = liftTo(other.root, other.shift, level);
+    diffNodes(a, b, level, 0, common, limit, fn);
+  }
+};
+
+#endif // PERSISTENT_VECTOR_HPP
@@ -0,0 +1,102 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Frame profiler. Scoped zones are timed into a per-thread lock-free ring
+// buffer that the main thread drains once per frame, feeding the overlay
+// (F3) and a rolling trace that can be written as Chrome trace-event JSON
+// (F4, open in chrome://tracing or Perfetto).
+//
+// Builds without VOLTQUEST_PROFILER compile every zone and call to nothing.
+//
+//   void ElectronicsLevel::drawLevel() {
+//     PROFILE_ZONE("drawLevel");
+//     ...
+//   }
+//
+// Zone names must be string literals: only the pointer is recorded.
+//
+// Profiler builds also replace global operator new to count heap
+// allocations per frame, shown in the overlay.
+
+#define VQ_PROFILE_CONCAT_INNER(a, b) a##b
+#define VQ_PROFILE_CONCAT(a, b) VQ_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef VOLTQUEST_PROFILER
+
+namespace Profiler {
+
+uint64_t nowNs();
+void record(const char *name, uint64_t start_ns, uint64_t end_ns);
+
+class Zone {
+public:
+  explicit Zone(const char *name) : name(name), start_ns(nowNs()) {}
+  ~Zone() { record(name, start_ns, nowNs()); }
+
+  Zone(const Zone &) = delete;
+  Zone &operator=(const Zone &) = delete;
+
+private:
+  const char *name;
+  uint64_t start_ns;
+};
+
+// Main thread, once per frame: closes the current frame and drains every
+// thread's buffer.
+void endFrame();
+
+// F3 toggles the overlay, F4 exports the trace
+void updateControls();
+
+// Must run between BeginDrawing() and EndDrawing()
+void drawOverlay();
+bool overlayVisible();
+void setOverlayVisible(bool visible);
+// Main thread: lines shown under the zones until replaced, such as the
+// last solver run
+void setOverlayNotes(const std::vector<std::string> &notes);
+
+// Writes the retained trace (the last few thousand frames) to `path`
+bool exportTrace(const std::string &path);
+
+// Milliseconds of the last finished frame, and of `name` within it
+double lastFrameMs();
+double lastZoneMs(const char *name);
+
+// Global operator new calls, counted on every thread: in total, and during
+// the last finished frame
+uint64_t allocationCount();
+uint64_t lastFrameAllocations();
+
+} // namespace Profiler
+
+#define PROFILE_ZONE(name)                                                     \
+  ::Profiler::Zone VQ_PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_FRAME() ::Profiler::endFrame()
+
+#else
+
+namespace Profiler {
+inline void endFrame() {}
+inline void updateControls() {}
+inline void drawOverlay() {}
+inline bool overlayVisible() { return false; }
+inline void setOverlayVisible(bool) {}
+inline void setOverlayNotes(const std::vector<std::string> &) {}
+inline bool exportTrace(const std::string &) { return false; }
+inline double lastFrameMs() { return 0.0; }
+inline double lastZoneMs(const char *) { return 0.0; }
+inline uint64_t allocationCount() { return 0; }
+inline uint64_t lastFrameAllocations() { return 0; }
+} // namespace Profiler
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+
+#endif // VOLTQUEST_PROFILER
+
+#endif // PROFILER_HPP
@@ -0,0 +1,89 @@
+#ifndef RESOURCE_PACK_HPP
+#define RESOURCE_PACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The resources/ tree packed into one indexed archive by voltquest_pack, so
+// startup maps a single file instead of opening many small ones. SVGs can
+// also be stored pre-rasterized at common screen scales.
+//
+// Layout (little-endian, read in place from the mapping):
+//
+//   "VQPACK" '\0' '\0', u32 version, u32 entry count, then the entry table
+//   sorted by (name hash, kind, scale) and 16-byte aligned entry data.
+//
+// Entries are found by the FNV-1a hash of their path relative to
+// resources/, e.g. "assets/images/led.svg".
+
+constexpr uint32_t RESOURCE_PACK_VERSION = 1;
+
+enum class ResourceKind : uint32_t {
+  File = 0,   // the file's bytes as they are on disk
+  Raster = 1, // an SVG rasterized to RGBA8 at one scale
+};
+
+struct ResourcePackEntry {
+  uint64_t name_hash;
+  uint64_t offset; // from the start of the pack
+  uint64_t size;
+  ResourceKind kind;
+  uint32_t scale_milli; // rasters: scale * 1000, rounded
+  uint32_t width;       // rasters: size in pixels
+  uint32_t height;
+};
+static_assert(sizeof(ResourcePackEntry) == 40, "entries are read in place");
+
+struct ResourcePack {
+  struct View {
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+  };
+
+  struct RasterView {
+    const unsigned char *pixels = nullptr; // RGBA8, rows packed
+    int width = 0;
+    int height = 0;
+  };
+
+  // Maps `packPath` and serves files under `resourceRoot` from it. False,
+  // and the loose files are used, if there is no valid pack.
+  static bool Mount(const std::string &packPath,
+                    const std::string &resourceRoot);
+  static void Unmount();
+  static bool IsMounted();
+
+  // `path` as returned by getResourcePath(). Views point into the mapping
+  // and stay valid until Unmount().
+  static bool Find(const std::string &path, View &out);
+  static bool FindRaster(const std::string &path, float scale,
+                         RasterView &out);
+
+  // The loose file at `path` changed after the pack was built, so lookups
+  // of it miss from now on and callers read the file instead
+  static void Shadow(const std::string &path);
+
+  static uint64_t HashName(const std::string &name);
+  static uint32_t ScaleMilli(float scale);
+};
+
+// Builds a pack in memory; used by voltquest_pack
+class ResourcePackWriter {
+public:
+  void addFile(const std::string &name, std::vector<unsigned char> bytes);
+  void addRaster(const std::string &name, float scale, int width,
+                 int height, std::vector<unsigned char> pixels);
+  bool write(const std::string &path) const;
+  size_t entryCount() const { return items.size(); }
+
+private:
+  struct Item {
+    ResourcePackEntry entry;
+    std::vector<unsigned char> bytes;
+  };
+  std::vector<Item> items;
+};
+
+#endif // RESOURCE_PACK_HPP
@@ -1,9 +1,16 @@
 #ifndef SCREEN_MANAGER_H
 #define SCREEN_MANAGER_H
 #include "raylib.h"
+#include <string>
 void updateLayout();
 void drawStartMenu();
 void drawOptionsMenu();
 void drawCurrentScreen();
+// Records the input of every level session to `path` (overwritten each time)
+void setInputRecordingPath(const std::string &path);
+// Level file to play instead of an empty board; edits to it are reloaded
+void setLevelPath(const std::string &path);
+// Drops the level being played and the warm ones; before the window closes
+void unloadLevels();
 void drawOptionsMenu();
 #endif
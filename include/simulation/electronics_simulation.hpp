@@ -1,31 +1,240 @@
 #ifndef ELECTRONICS_SIMULATION_HPP
 #define ELECTRONICS_SIMULATION_HPP
 
+#include "../board_history.hpp"
 #include "../game_objects/electronic_components/electronics_base.hpp"
+#include "solution_cache.hpp"
+#include "solver_telemetry.hpp"
+#include "sparse_cg.hpp"
+#include "sparse_ldl.hpp"
 #include <memory>
 #include <vector>
 
+// DC operating point of the board.
+//
+// Every part is a two-terminal element between the nets of its two pins.
+// Batteries are stamped as their Norton equivalent (source current in
+// parallel with the internal resistance) and LEDs as a piecewise-linear
+// diode, so the nodal matrix is symmetric positive definite and is solved
+// with a sparse LDL^T factorization. Islands whose factor would fill in past
+// ITERATIVE_MIN_FILL, such as large meshes, are solved by preconditioned
+// conjugate gradient instead, warm-started from their last solution.
+//
+// Parts joined by wires and other parts form an island, an independent
+// circuit with its own matrix and factorization. Islands are solved in
+// parallel. A rebuild diffs the board against the last one and regroups
+// only the islands of changed parts and wires; the others keep their
+// factorization and results, so an edit only re-solves what it touched.
+//
+// Only parts on a closed loop through a battery enter the matrix. The rest
+// carry no current: their nets take their voltages from the loops they
+// hang off, so dangling and floating parts can't make the matrix singular.
+//
+// With a SolutionCache set, every island that needs a solve is first put in
+// canonical form: nets are relabelled by colour refinement on the net graph
+// and parts sorted by kind, value and nets, so the same circuit built in
+// another order or place gives the same form. A cached form skips the
+// solve; others are stored once solved.
+//
+// The netlist is read from the board's records, not from live components,
+// so parts that are paged out still take part in the solve.
 class ElectronicsSimulation {
 public:
-  void build(const std::vector<std::shared_ptr<ElectronicComponent>> &objects,
-             const std::vector<Wire> &node_edges);
+  // Units used by the electrical model
+  static constexpr double RESISTANCE_UNIT = 1000.0; // resistance is in kOhm
+  static constexpr double MIN_RESISTANCE = 1e-3;    // Ohm
+  static constexpr double BATTERY_INTERNAL_RESISTANCE = 0.5; // Ohm
+  static constexpr double LED_ON_RESISTANCE = 5.0;           // Ohm
+  static constexpr double LED_OFF_CONDUCTANCE = 1e-9;        // S
+  static constexpr double LED_MIN_CURRENT = 1e-4;            // A, visibly lit
+  static constexpr double LED_DAMAGE_FACTOR = 2.0; // x rated current
+  static constexpr double RESISTOR_TOLERANCE = 0.05; // the gold fourth band
+  static constexpr int MAX_ITERATIONS = 32;
+  // Predicted factor nonzeros from which an island is solved iteratively
+  // by the automatic backend, about 24 MB of direct factor
+  static constexpr size_t ITERATIVE_MIN_FILL = 2u << 20;
+  // Pins of a component that take part in the netlist
+  static constexpr int PINS_PER_ELEMENT = 2;
 
+  // Rebuilds the netlist. Unchanged islands keep their last solve.
+  void build(const BoardState &board);
+
+  // Solves the islands changed since the last solve
   void solve();
 
+  // Copies the last solve's pin voltages and currents and the LED state of
+  // component `obj.id` onto the live object
+  void applyResults(ElectronicComponent &obj) const;
+
+  // Sets the swept parameter of component `id`, a battery's voltage or a
+  // resistor's resistance (kOhm), for the next solve(). Meant for copies of
+  // a built simulation, which share its symbolic factorization; false for
+  // parts without such a parameter.
+  bool setParameter(uint32_t id, float value);
+
+  // Results of the last solve by component id, 0 for parts not simulated:
+  // current from pin 0 to pin 1, and the island of connected parts (-1)
+  double componentCurrent(uint32_t id) const;
+  int32_t islandOf(uint32_t id) const;
+  // LED state of the last solve; false for other parts
+  bool componentPowered(uint32_t id) const;
+  bool componentDamaged(uint32_t id) const;
+  // Whether the part lies on a closed loop through a battery, as of the
+  // last build
+  bool onClosedLoop(uint32_t id) const;
+
+  // Cache of solved islands consulted by build(); none by default. Copies
+  // share it but don't store what they solve after setParameter().
+  void setSolutionCache(SolutionCache *cache) { solution_cache = cache; }
+
+  enum class SolverBackend {
+    Automatic, // by predicted fill-in, see ITERATIVE_MIN_FILL
+    Direct,
+    Iterative,
+  };
+  // For the islands of later builds
+  void setSolverBackend(SolverBackend backend) { solver_backend = backend; }
+
   // Explicit invalidation hook
   void markDirty() { dirty = true; }
+  bool isDirty() const { return dirty; }
+
+  size_t nodeCount() const;
+  size_t unknownCount() const;
+  size_t elementCount() const;
+  size_t matrixNonZeros() const;
+  size_t factorNonZeros() const;
+  size_t islandCount() const { return islands.size(); }
+  size_t iterativeIslandCount() const;
+
+  // Sizes, stage times, iterations and residuals of the last build() and
+  // solve()
+  const SolveStats &lastSolveStats() const { return last_stats; }
+  // Estimates the condition number of every directly factored island not
+  // yet estimated, a few substitutions each, and stores the largest in
+  // lastSolveStats()
+  void estimateCondition();
+
+  // Of the last solve: islands solved, and the most LED iterations any of
+  // them took
+  size_t lastSolvedIslands() const { return last_stats.islands_solved; }
+  // Islands the last build took from the solution cache
+  size_t lastCacheHits() const { return last_stats.cache_hits; }
+  int lastIterations() const { return last_stats.iterations; }
+  // Most conjugate gradient iterations any island took in the last solve
+  int lastKrylovIterations() const { return last_stats.krylov_iterations; }
 
 private:
+  struct Element {
+    uint32_t component_id = 0;
+    ComponentLabel kind = ComponentLabel::Resistor;
+    float voltage = 0.0f;       // source voltage or LED forward drop
+    float resistance = 0.0f;    // kOhm
+    float rated_current = 0.0f; // A, LEDs
+    int32_t node_a = -1; // island net of pin 0
+    int32_t node_b = -1; // island net of pin 1
+    int32_t row_a = -1;  // matrix row of node_a, -1 for the reference net
+    int32_t row_b = -1;
+    int32_t slot_aa = -1; // positions of the element's stamp in matrix
+    int32_t slot_bb = -1;
+    int32_t slot_ab = -1;
+    int32_t slot_ba = -1;
+    bool live = false; // on a closed loop through a battery
+    bool led_on = false;
+    // Results of the last solve
+    double current = 0.0; // from pin 0 to pin 1
+    bool powered = false;
+    bool damaged = false;
+  };
+
+  struct Island {
+    std::vector<Element> elements; // by component id
+    std::vector<uint32_t> wires;   // connection ids
+    int32_t net_count = 0;
+    int32_t first_net = 0; // board-wide id of the island's net 0
+    uint64_t shape = 0;    // hash of the parts and wiring, not their values
+    // Canonical form, while it matches the values: the netlist, its hash,
+    // net -> canonical net and canonical position -> element
+    std::vector<uint32_t> form;
+    uint64_t form_hash = 0;
+    std::vector<int32_t> canonical_net;
+    std::vector<int32_t> canonical_element;
+    std::vector<int32_t> node_unknown; // net -> matrix row, -1 for reference
+    SparseMatrix matrix;
+    SparseLDL factor;
+    // Solved by conjugate gradient instead of the factor, from `solution`,
+    // the last one, by matrix row
+    bool iterative = false;
+    SparseCG krylov;
+    std::vector<double> solution;
+    int krylov_iterations = 0;
+    std::vector<double> rhs;
+    std::vector<double> node_voltage;
+    std::vector<double> loop_voltage; // relative to each loop, scratch
+    // Nets in the order voltages spread to them from the reference, and
+    // the element each is reached through
+    std::vector<int32_t> reach_net;
+    std::vector<int32_t> reach_element;
+    bool solved = false;
+    int iterations = 0;
+    // Telemetry: pattern analysis times until the next solve counts them,
+    // and of the last solve. condition is -1 while it awaits an estimate
+    // and 0 when it has none.
+    double ordering_ms = 0.0;
+    double symbolic_ms = 0.0;
+    double numeric_ms = 0.0;
+    double solve_ms = 0.0;
+    double residual = 0.0;
+    double condition = 0.0;
+    std::vector<double> rhs_copy; // scratch
+  };
+
+  struct ElementRef {
+    int32_t island = -1;
+    int32_t index = -1;
+  };
+
   // ---- Cached topology (valid only when !dirty) ----
-  std::vector<Pin *> all_pins; // non-owning
+  std::vector<ElementRef> element_of; // by component id
+  std::vector<Island> islands;
+  SolutionCache *solution_cache = nullptr;
+  SolverBackend solver_backend = SolverBackend::Automatic;
+  std::vector<uint32_t> pending; // islands to solve, scratch
+  BoardState built_board;        // the board of the last build
+  // Live wires with a pin on no live part, sorted
+  std::vector<uint32_t> dangling_wires;
+  bool built = false;
   bool dirty = true;
+  SolveStats last_stats;
 
   // ---- Internal pipeline ----
   void clearCache();
-  void
-  fetchPins(const std::vector<std::shared_ptr<ElectronicComponent>> &objects);
-  void buildNodes(const std::vector<Wire> &node_edges);
-  void stampMatrix();
+  void collectChanges(const BoardState &board, std::vector<uint32_t> &parts,
+                      std::vector<uint32_t> &wires,
+                      std::vector<Island> &replaced);
+  void groupIslands(const BoardState &board,
+                    const std::vector<uint32_t> &parts,
+                    const std::vector<uint32_t> &wires);
+  void reuseIslands(std::vector<Island> &previous);
+  void orderIslands();
+  void prepareIslands();
+  static void buildNodes(Island &island);
+  static void markLiveElements(Island &island);
+  static void buildPattern(Island &island, SolverBackend backend);
+  static void stampMatrix(Island &island);
+  static void canonicalize(Island &island);
+  static bool loadCached(Island &island, SolutionCache &cache);
+  static void storeCached(const Island &island, SolutionCache &cache);
+  void solveIsland(Island &island) const;
+  bool solveMatrix(Island &island) const;
+  static double estimateIslandCondition(Island &island);
+  static bool updateLedStates(Island &island);
+  static void spreadVoltages(Island &island);
+  static void storeResults(Island &island);
+
+  static double elementCurrent(const Island &island, const Element &e);
+
+  friend struct SimulationBenchmark;
 };
 
 #endif // ELECTRONICS_SIMULATION_HPP
@@ -0,0 +1,58 @@
+#ifndef PARAMETER_SWEEP_HPP
+#define PARAMETER_SWEEP_HPP
+
+#include "electronics_simulation.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Solves the board at evenly spaced values of one part's parameter (see
+// ElectronicsSimulation::setParameter()) in the background. The points are
+// split across the thread pool; each worker solves its own copy of the
+// built simulation, so all of them reuse its symbolic factorization and
+// only refactor numerically.
+class ParameterSweep {
+public:
+  static constexpr size_t MAX_PROBES = 4;
+
+  struct Spec {
+    uint32_t component_id = 0;
+    float from = 0.0f;
+    float to = 0.0f;
+    int points = 0;
+    // Parts whose current is recorded at every point
+    std::vector<uint32_t> probes;
+  };
+
+  struct Result {
+    Spec spec;
+    std::vector<float> values;               // by point
+    std::vector<std::vector<float>> currents; // A, by probe, then point
+    float min_current = 0.0f;
+    float max_current = 0.0f;
+  };
+
+  ParameterSweep() = default;
+  ~ParameterSweep() { cancel(); }
+
+  ParameterSweep(const ParameterSweep &) = delete;
+  ParameterSweep &operator=(const ParameterSweep &) = delete;
+
+  // Main thread only. `sim` must be built; it is copied, so it can change
+  // while the sweep runs. Replaces the running or finished sweep.
+  void start(const ElectronicsSimulation &sim, Spec spec);
+  void cancel();
+  bool running() const;
+  // The last finished sweep, or nullptr
+  const Result *result();
+
+  // Runs a sweep on the calling thread and the pool, returning when done
+  static Result run(const ElectronicsSimulation &sim, Spec spec);
+
+private:
+  struct Job;
+  std::shared_ptr<Job> job;
+  std::unique_ptr<Result> finished;
+};
+
+#endif // PARAMETER_SWEEP_HPP
@@ -0,0 +1,68 @@
+#ifndef PROBE_TRACE_HPP
+#define PROBE_TRACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// History of one probed part: the voltage across its pins and the current
+// through it, one sample per record(). Level 0 keeps the last CAPACITY
+// samples; every level above keeps the min and max of DECIMATION buckets of
+// the one below, in a ring of CAPACITY as well. Memory is fixed however
+// long the probe runs (about 128 KB), the oldest detail going first, and
+// envelope() reads O(columns) buckets whatever the window.
+class ProbeTrace {
+public:
+  enum class Channel : uint8_t { Voltage, Current };
+  static constexpr size_t CHANNELS = 2;
+  static constexpr size_t LEVELS = 8;
+  static constexpr size_t CAPACITY = 1024; // buckets per level
+  static constexpr uint64_t DECIMATION = 4;
+  // Samples the coarsest level spans
+  static constexpr uint64_t HISTORY = CAPACITY * (uint64_t(1) << 14);
+  static_assert(DECIMATION == 4 && LEVELS == 8, "HISTORY is 4^7 buckets");
+
+  // min > max when no sample fell in it
+  struct Span {
+    float min;
+    float max;
+  };
+
+  explicit ProbeTrace(uint32_t component_id = 0);
+
+  uint32_t componentId() const { return component_id; }
+
+  // Doesn't allocate
+  void record(float voltage, float current);
+  void clear();
+
+  uint64_t sampleCount() const { return samples; }
+
+  // Min and max of `channel` over the last `window` samples, split into
+  // `columns` equal parts, oldest first. History older than the coarsest
+  // level keeps is left empty.
+  void envelope(Channel channel, uint64_t window, Span *out,
+                size_t columns) const;
+
+private:
+  struct Bucket {
+    Span span[CHANNELS];
+  };
+  struct Level {
+    uint64_t count = 0; // buckets ever completed
+    Bucket pending;     // the one being filled from the level below
+    uint64_t pending_count = 0;
+  };
+
+  void push(size_t level, const Bucket &bucket);
+  const Bucket &bucket(size_t level, uint64_t index) const {
+    return buckets[level * CAPACITY + index % CAPACITY];
+  }
+
+  uint32_t component_id;
+  std::vector<Bucket> buckets; // LEVELS rings of CAPACITY
+  Level levels[LEVELS];
+  uint64_t samples = 0;
+};
+
+#endif // PROBE_TRACE_HPP
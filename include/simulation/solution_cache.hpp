@@ -0,0 +1,61 @@
+#ifndef SOLUTION_CACHE_HPP
+#define SOLUTION_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Operating points of recently solved islands, keyed by their canonical
+// netlist (see ElectronicsSimulation). An island built again, by undo or as
+// a copy elsewhere on a board or in another level, takes its results from
+// here instead of being factorized.
+//
+// Entries are evicted least recently used first once their netlists and
+// results pass the byte budget. Safe to share between threads.
+class SolutionCache {
+public:
+  static constexpr size_t DEFAULT_BUDGET = 16u << 20; // bytes
+
+  struct Entry {
+    std::vector<uint32_t> form;  // the canonical netlist, compared in full
+    std::vector<double> voltage; // V, by canonical net
+    std::vector<uint8_t> led_on; // by canonical element
+  };
+
+  explicit SolutionCache(size_t budget = DEFAULT_BUDGET) : budget(budget) {}
+
+  // Copies the results stored for `form` into `out`; false on a miss
+  bool find(uint64_t hash, const std::vector<uint32_t> &form, Entry &out);
+  // Replaces any entry for the same hash
+  void store(uint64_t hash, Entry entry);
+  void clear();
+
+  size_t size() const;
+  size_t bytes() const;
+  size_t hits() const;
+  size_t misses() const;
+
+private:
+  struct Slot {
+    uint64_t hash;
+    Entry entry;
+  };
+
+  static size_t sizeOf(const Entry &entry);
+
+  mutable std::mutex mutex;
+  std::list<Slot> slots; // most recently used first
+  std::unordered_map<uint64_t, std::list<Slot>::iterator> by_hash;
+  size_t budget;
+  size_t used = 0;
+  size_t hit_count = 0;
+  size_t miss_count = 0;
+};
+
+// Shared by the levels
+SolutionCache &solutionCache();
+
+#endif // SOLUTION_CACHE_HPP
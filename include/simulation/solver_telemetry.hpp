@@ -0,0 +1,70 @@
+#ifndef SOLVER_TELEMETRY_HPP
+#define SOLVER_TELEMETRY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Statistics of one build() and solve() of ElectronicsSimulation, to tell
+// why a board is slow or unstable. Stage times are summed over the islands
+// that went through the stage, so with islands solved in parallel they can
+// add up to more than the wall time.
+struct SolveStats {
+  uint64_t sequence = 0; // numbered by SolverTelemetry::record()
+  size_t islands = 0;
+  size_t islands_solved = 0;
+  size_t cache_hits = 0;
+  size_t iterative_islands = 0;
+  size_t nodes = 0;    // nets
+  size_t branches = 0; // parts in the netlist
+  size_t unknowns = 0;
+  size_t matrix_nonzeros = 0;
+  size_t factor_nonzeros = 0; // after fill-in; preconditioners if iterative
+  double build_ms = 0.0;      // wall time of build()
+  double ordering_ms = 0.0;
+  double symbolic_ms = 0.0;
+  double numeric_ms = 0.0; // factorizations and preconditioners
+  double solve_ms = 0.0;   // substitutions and CG
+  double total_ms = 0.0;   // wall time of solve()
+  int iterations = 0;      // LED state iterations, most of any island
+  int krylov_iterations = 0;
+  // Worst normwise backward error |b - Ax| / (|A||x| + |b|), in the
+  // infinity norm, of the last matrix solve of any island
+  double residual = 0.0;
+  // Largest estimated 1-norm condition number of a directly factored
+  // island; 0 until ElectronicsSimulation::estimateCondition()
+  double condition = 0.0;
+};
+
+// The last CAPACITY solves, for the inspector, the profiler overlay and
+// JSON export. Main thread only; records don't allocate.
+class SolverTelemetry {
+public:
+  static constexpr size_t CAPACITY = 256;
+
+  SolverTelemetry() : ring(CAPACITY) {}
+
+  void record(const SolveStats &stats);
+  void clear();
+
+  size_t size() const { return count; }
+  // 0 is the oldest
+  const SolveStats &at(size_t i) const;
+  // nullptr before the first record
+  const SolveStats *latest() const;
+
+  std::string toJson() const;
+  bool exportJson(const std::string &path) const;
+
+private:
+  std::vector<SolveStats> ring;
+  size_t next = 0; // slot of the next record
+  size_t count = 0;
+  uint64_t next_sequence = 1;
+};
+
+// Shared by the levels
+SolverTelemetry &solverTelemetry();
+
+#endif // SOLVER_TELEMETRY_HPP
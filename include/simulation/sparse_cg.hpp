@@ -0,0 +1,59 @@
+#ifndef SPARSE_CG_HPP
+#define SPARSE_CG_HPP
+
+#include "sparse_ldl.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Conjugate gradient for symmetric positive definite systems, preconditioned
+// with a zero fill-in incomplete Cholesky factor, IC(0). Everything it keeps
+// is the size of the matrix, so memory grows linearly with the circuit
+// where a direct factor grows with its fill-in.
+//
+// analyze() takes the pattern once; factorize() builds the preconditioner
+// for new values on it, and solve() iterates from the guess it is given,
+// so a solve close to the last one takes few iterations.
+class SparseCG {
+public:
+  static constexpr int MAX_ITERATIONS = 5000;
+  static constexpr double TOLERANCE = 1e-12; // residual relative to b
+
+  void analyze(const SparseMatrix &A);
+
+  // Returns false when the incomplete factor breaks down (a pivot that
+  // isn't positive), which can't happen for nodal conductance matrices.
+  bool factorize(const SparseMatrix &A);
+
+  // Solves A x = b starting from x. Returns false when the residual isn't
+  // within TOLERANCE after MAX_ITERATIONS.
+  bool solve(const SparseMatrix &A, const std::vector<double> &b,
+             std::vector<double> &x);
+
+  // Of the last solve
+  int iterations() const { return last_iterations; }
+
+  size_t preconditionerNonZeros() const { return l_row.size(); }
+
+private:
+  // Overwrites v with M^-1 v
+  void precondition(std::vector<double> &v) const;
+
+  int32_t n = 0;
+  // Lower triangle of the incomplete factor by column, diagonal first, and
+  // the position of each entry in A's values
+  std::vector<int32_t> l_ptr;
+  std::vector<int32_t> l_row;
+  std::vector<int32_t> l_source;
+  std::vector<double> l_val;
+  std::vector<int32_t> where; // row -> position in a column, scratch
+  int last_iterations = 0;
+
+  // Iteration vectors
+  std::vector<double> r;
+  std::vector<double> z;
+  std::vector<double> p;
+  std::vector<double> ap;
+};
+
+#endif // SPARSE_CG_HPP
@@ -0,0 +1,72 @@
+#ifndef SPARSE_LDL_HPP
+#define SPARSE_LDL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Square sparse matrix in compressed sparse column form. The solver matrices
+// are symmetric and store both triangles.
+struct SparseMatrix {
+  int32_t n = 0;
+  std::vector<int32_t> col_ptr; // n + 1 entries
+  std::vector<int32_t> row_idx; // sorted within each column
+  std::vector<double> values;
+
+  size_t nonZeros() const { return row_idx.size(); }
+
+  // Position of (row, col) in values/row_idx, or -1 if not in the pattern.
+  int32_t find(int32_t row, int32_t col) const;
+};
+
+// Result of the symbolic phase: depends only on the sparsity pattern, so it
+// can be shared by any number of numeric factorizations of that pattern.
+struct LDLSymbolic {
+  int32_t n = 0;
+  std::vector<int32_t> perm;     // new index -> old index
+  std::vector<int32_t> perm_inv; // old index -> new index
+  std::vector<int32_t> parent;   // elimination tree
+  std::vector<int32_t> col_ptr;  // column pointers of L
+};
+
+// Sparse LDL^T factorization for symmetric positive definite systems.
+// analyze() orders the matrix (reverse Cuthill-McKee) and computes the
+// elimination tree; factorize() can then be called again and again with new
+// values on the same pattern. Copies share the symbolic analysis and can
+// factorize on different threads.
+class SparseLDL {
+public:
+  void analyze(const SparseMatrix &A);
+  bool analyzed() const { return symbolic != nullptr; }
+
+  // Returns false on a zero pivot (singular matrix).
+  bool factorize(const SparseMatrix &A);
+
+  // Overwrites b with the solution of A x = b.
+  void solve(std::vector<double> &b);
+
+  // Nonzeros of L, known once analyzed
+  size_t factorNonZeros() const;
+  // Milliseconds the last analyze() spent ordering, and on the rest
+  double orderingMs() const { return ordering_ms; }
+  double symbolicMs() const { return symbolic_ms; }
+
+private:
+  std::shared_ptr<const LDLSymbolic> symbolic;
+  double ordering_ms = 0.0;
+  double symbolic_ms = 0.0;
+
+  // Numeric factor and scratch space. analyze() only sizes what grows
+  // with n, so the fill it predicts can be checked before it is allocated;
+  // factorize() sizes the rest.
+  std::vector<int32_t> li;
+  std::vector<double> lx;
+  std::vector<double> d;
+  std::vector<int32_t> lnz;
+  std::vector<int32_t> flag;
+  std::vector<int32_t> pattern;
+  std::vector<double> y;
+};
+
+#endif // SPARSE_LDL_HPP
@@ -0,0 +1,46 @@
+#ifndef TOLERANCE_ANALYSIS_HPP
+#define TOLERANCE_ANALYSIS_HPP
+
+#include "../board_history.hpp"
+#include "electronics_simulation.hpp"
+#include <cstdint>
+#include <vector>
+
+// Monte Carlo analysis of part tolerances: solves the board many times with
+// every resistor drawn uniformly within RESISTOR_TOLERANCE of its value,
+// and counts how often each LED ends up lit or damaged.
+//
+// Trials run in fixed blocks on the thread pool. Each block solves its own
+// copy of the built simulation, sharing its symbolic factorization, and
+// draws from its own random stream seeded by (seed, block), so a report
+// only depends on the seed and the trial count, not on the thread count.
+struct ToleranceAnalysis {
+  struct Options {
+    int trials = 1000;
+    uint32_t seed = 1;
+  };
+
+  struct LedStats {
+    uint32_t component_id = 0;
+    bool nominal_powered = false; // at the parts' exact values
+    bool nominal_damaged = false;
+    int powered = 0; // trials
+    int damaged = 0;
+    float min_current = 0.0f; // A
+    float max_current = 0.0f;
+    double mean_current = 0.0;
+  };
+
+  struct Report {
+    int trials = 0;
+    int trials_with_damage = 0; // any LED damaged
+    int trials_all_powered = 0; // every LED lit
+    std::vector<LedStats> leds; // by component id
+  };
+
+  // `sim` must be built from `board` and solved
+  static Report run(const ElectronicsSimulation &sim, const BoardState &board,
+                    const Options &options);
+};
+
+#endif // TOLERANCE_ANALYSIS_HPP
@@ -0,0 +1,102 @@
+#ifndef SPATIAL_GRID_HPP
+#define SPATIAL_GRID_HPP
+
+#include "raylib.h"
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over axis-aligned bounds, keyed by small integer ids. Items
+// are filed under every cell their bounds touch, so a query only visits the
+// cells it overlaps. Items spanning more than OVERSIZED_CELLS cells (long
+// wires) are kept in a separate list that every query tests directly.
+class SpatialGrid {
+public:
+  static constexpr int OVERSIZED_CELLS = 64;
+
+  explicit SpatialGrid(float cell_size = 256.0f) : cell_size(cell_size) {}
+
+  void clear();
+
+  // Inserts `id`, or moves it to `bounds` if it is already in the grid
+  void update(uint32_t id, Rectangle bounds);
+  void remove(uint32_t id);
+  bool contains(uint32_t id) const {
+    return id < entries.size() && entries[id].alive;
+  }
+
+  // Calls fn(id) once for every item whose bounds overlap `area`, in no
+  // particular order. Doesn't allocate.
+  template <typename Fn> void query(Rectangle area, Fn &&fn) const;
+
+private:
+  struct CellRange {
+    int x0, y0, x1, y1;
+    bool operator==(const CellRange &o) const {
+      return x0 == o.x0 && y0 == o.y0 && x1 == o.x1 && y1 == o.y1;
+    }
+    int64_t count() const { return (int64_t)(x1 - x0 + 1) * (y1 - y0 + 1); }
+  };
+
+  struct Entry {
+    Rectangle bounds;
+    CellRange cells;
+    bool alive = false;
+    bool oversized = false;
+  };
+
+  static uint64_t cellKey(int x, int y) {
+    return (uint64_t)(uint32_t)x << 32 | (uint32_t)y;
+  }
+  CellRange cellRange(Rectangle bounds) const;
+  void unlink(uint32_t id);
+  void link(uint32_t id);
+  // Marks `id` as reported by the current query; false if it already was
+  bool visit(uint32_t id) const;
+
+  float cell_size;
+  std::vector<Entry> entries; // by id
+  std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+  std::vector<uint32_t> oversized;
+
+  // Items filed under several cells are reported once per query
+  mutable std::vector<uint32_t> visited;
+  mutable uint32_t query_stamp = 0;
+};
+
+template <typename Fn> void SpatialGrid::query(Rectangle area, Fn &&fn) const {
+  if (++query_stamp == 0) {
+    std::fill(visited.begin(), visited.end(), 0);
+    query_stamp = 1;
+  }
+  visited.resize(entries.size());
+
+  auto test = [&](uint32_t id) {
+    if (visit(id) && CheckCollisionRecs(entries[id].bounds, area))
+      fn(id);
+  };
+
+  for (uint32_t id : oversized)
+    test(id);
+
+  CellRange range = cellRange(area);
+  if (range.count() > (int64_t)cells.size()) {
+    // Zoomed far out: fewer occupied cells than cells in view
+    for (const auto &[key, ids] : cells)
+      for (uint32_t id : ids)
+        test(id);
+    return;
+  }
+  for (int y = range.y0; y <= range.y1; ++y) {
+    for (int x = range.x0; x <= range.x1; ++x) {
+      auto it = cells.find(cellKey(x, y));
+      if (it == cells.end())
+        continue;
+      for (uint32_t id : it->second)
+        test(id);
+    }
+  }
+}
+
+#endif // SPATIAL_GRID_HPP
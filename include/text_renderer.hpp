@@ -0,0 +1,34 @@
+#ifndef TEXT_RENDERER_HPP
+#define TEXT_RENDERER_HPP
+
+#include "raylib.h"
+#include <string>
+
+// UI text. A TTF font is baked into an atlas once per pixel size, and the
+// atlases are rebaked when the screen scale changes. Static labels are
+// shaped once and their glyph runs cached. Every glyph quad is queued until
+// Flush(), which submits each font atlas as a single batch.
+//
+// Falls back to raylib's default font when no TTF is installed.
+struct TextRenderer {
+  // Optional; without a usable TTF the default font is used
+  static void Init(const std::string &fontPath);
+
+  // Shaped on every call: for text that changes from frame to frame
+  static void Draw(const char *text, Vector2 pos, int fontSize, Color color);
+  static float Measure(const char *text, int fontSize);
+
+  // Cached by text and size: for labels drawn again and again with the
+  // same text
+  static void DrawLabel(const char *text, Vector2 pos, int fontSize,
+                        Color color);
+  static float MeasureLabel(const char *text, int fontSize);
+
+  // Submits the queued text. Call before EndDrawing(), and before drawing
+  // anything that has to cover text.
+  static void Flush();
+
+  static void UnloadAll();
+};
+
+#endif // TEXT_RENDERER_HPP
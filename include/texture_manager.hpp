@@ -4,11 +4,54 @@
 #include "raylib.h"
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+
+// CPU-side RGBA8 pixels of a rasterized SVG
+struct SVGRaster {
+  std::vector<unsigned char> pixels;
+  int width = 0;
+  int height = 0;
+};
+
+struct SVGAtlasEntry {
+  std::string name; // region name for GetRegion()
+  std::string filePath;
+};
+
+// A texture built again from changed files, waiting for Replace()
+struct TextureRebuild {
+  std::string name;
+  SVGRaster raster;
+  std::vector<std::pair<std::string, Rectangle>> regions; // atlas entries
+  bool atlas = false;
+};
 
 struct TextureManager {
   static void LoadSVG(const std::string &name, const std::string &filePath,
                       float scale = 1.0f);
 
+  // Rasterizes several SVGs side by side into the one texture `name`, so
+  // sprites drawn from it share a single batch. Each entry's rectangle in
+  // the texture is GetRegion(entry.name).
+  static void LoadSVGAtlas(const std::string &name,
+                           const std::vector<SVGAtlasEntry> &entries,
+                           float scale = 1.0f);
+  static const Rectangle &GetRegion(const std::string &name);
+
+  // Parses and rasterizes an SVG without touching the GPU, so it can run
+  // without a window (tools, benchmarks).
+  static bool RasterizeSVG(const std::string &filePath, float scale,
+                           SVGRaster &out);
+
+  // Hot reload: rasterizes every texture made from `filePath` again. Safe
+  // off the main thread.
+  static void Rebuild(const std::string &filePath,
+                      std::vector<TextureRebuild> &out);
+  // Main thread: swaps a rebuilt texture in. References returned by Get()
+  // and GetRegion() stay valid and see the new pixels.
+  static void Replace(const TextureRebuild &rebuild);
+
   static Texture2D &Get(const std::string &name);
   static bool Exists(const std::string &name);
   static void UnloadAll();
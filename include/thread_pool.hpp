@@ -0,0 +1,47 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for CPU-bound background work such as
+// simulation sweeps. Threads start with the first task.
+class ThreadPool {
+public:
+  // 0 picks one thread per hardware thread, less one for the main thread
+  explicit ThreadPool(size_t threads = 0);
+  // Drops tasks that haven't started and waits for the running ones
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void submit(std::function<void()> task);
+
+  // Calls fn(i) for every i in [0, count) on the pool and the calling
+  // thread, and returns once all calls have finished. Called from a pool
+  // task or loop body, it runs every call on the calling thread.
+  void parallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+  size_t size() const { return thread_count; }
+
+private:
+  void run();
+
+  size_t thread_count;
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::deque<std::function<void()>> tasks;
+  bool stopping = false;
+};
+
+// Shared by the game's background jobs
+ThreadPool &threadPool();
+
+#endif // THREAD_POOL_HPP
@@ -22,10 +22,10 @@ void drawUIRect(float outlineSize, float roundness, const Rectangle &bounds);
 void drawUIButton(const UIButton &button);
 void drawImage(const std::string &name, const Rectangle &bounds);
 void drawUIPanel(const Rectangle &bounds);
-void drawUIText(int fontSize, const Vector2 &textPos, const std::string &text,
+void drawUIText(int fontSize, const Vector2 &textPos, const char *text,
                 const Color &textColor);
 void drawUITextCentered(int fontSize, const Rectangle &bounds,
-                        const std::string &text, const Color &textColor);
+                        const char *text, const Color &textColor);
 
 // Input Functions
 bool isUIButtonPressed(const UIButton &button);
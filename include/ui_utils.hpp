@@ -2,6 +2,7 @@
 #define UI_UTILS_HPP
 
 #include "../include/settings.hpp"
+#include <cstdint>
 
 // Constants
 constexpr float baseWidth = 1920.0f;
@@ -12,11 +13,31 @@ inline float screenScaleX = 1.0f;
 inline float screenScaleY = 1.0f;
 inline float safeScreenScale = 1.0f;
 
+// Bumped whenever the scale is recalculated; cached layouts compare against
+// it to know when to rebuild
+inline uint32_t layoutGeneration = 0;
+
 // Inline function to calculate scale
 inline void calculateScreenScale() {
   screenScaleX = static_cast<float>(globalSettings.screenWidth) / baseWidth;
   screenScaleY = static_cast<float>(globalSettings.screenHeight) / baseHeight;
   safeScreenScale = (screenScaleX + screenScaleY) / 2.0f;
+  ++layoutGeneration;
 }
 
+// Remembers which screen size a cached layout was built for
+struct LayoutStamp {
+  bool valid = false;
+  uint32_t generation = 0;
+
+  // True, once, when the cached layout is missing or out of date
+  bool refresh() {
+    if (valid && generation == layoutGeneration)
+      return false;
+    valid = true;
+    generation = layoutGeneration;
+    return true;
+  }
+};
+
 #endif // UI_UTILS_HPP
@@ -2,5 +2,7 @@
 #define WINDOW_MANAGER_H
 
 void createWindow();
+// Once per frame: picks up window resizes and rescales the UI
+void updateWindowSize();
 
 #endif
@@ -0,0 +1,30 @@
+#include "../include/profiler.hpp"
+
+#ifdef VOLTQUEST_PROFILER
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Counting replacements for the global allocation functions; the array and
+// nothrow forms forward to these by default. Kept apart from profiler.cpp
+// so the profiler's own inlined allocations aren't paired against them.
+static std::atomic<uint64_t> allocation_count{0};
+
+void *operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+// Defined here so that linking the profiler pulls this object, and with it
+// the replacements, out of the static library
+uint64_t Profiler::allocationCount() {
+  return allocation_count.load(std::memory_order_relaxed);
+}
+
+#endif // VOLTQUEST_PROFILER
@@ -0,0 +1,339 @@
+#include "../include/board_chunks.hpp"
+#include "../include/log.hpp"
+#include "../include/profiler.hpp"
+#include "../include/thread_pool.hpp"
+
+#include <algorithm>
+
+ChunkKey BoardChunks::keyAt(Vector2 world) {
+  return pack((int)std::floor(world.x / CHUNK_SIZE),
+              (int)std::floor(world.y / CHUNK_SIZE));
+}
+
+Rectangle BoardChunks::bounds(ChunkKey key) {
+  int x = (int32_t)(uint32_t)(key >> 32);
+  int y = (int32_t)(uint32_t)key;
+  return {x * CHUNK_SIZE, y * CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE};
+}
+
+static void insertSorted(std::vector<uint32_t> &ids, uint32_t id) {
+  auto it = std::lower_bound(ids.begin(), ids.end(), id);
+  if (it == ids.end() || *it != id)
+    ids.insert(it, id);
+}
+
+static void eraseSorted(std::vector<uint32_t> &ids, uint32_t id) {
+  auto it = std::lower_bound(ids.begin(), ids.end(), id);
+  if (it != ids.end() && *it == id)
+    ids.erase(it);
+}
+
+bool BoardChunks::wireValid(const BoardState &board, uint32_t wire) {
+  if (wire >= board.connections.size())
+    return false;
+  const ConnectionRecord &c = board.connections[wire];
+  size_t count = board.components.size();
+  return c.alive && c.component_a < count && c.component_b < count &&
+         board.components[c.component_a].alive &&
+         board.components[c.component_b].alive;
+}
+
+void BoardChunks::sync(const BoardState &board) {
+  std::vector<uint32_t> changed_parts;
+  std::vector<uint32_t> changed_wires;
+  synced.components.diff(board.components, [&](size_t id) {
+    changed_parts.push_back(static_cast<uint32_t>(id));
+  });
+  synced.connections.diff(board.connections, [&](size_t id) {
+    changed_wires.push_back(static_cast<uint32_t>(id));
+  });
+  if (changed_parts.empty() && changed_wires.empty()) {
+    synced = board;
+    return;
+  }
+  PROFILE_ZONE("BoardChunks::sync");
+
+  // Wires that may move: the changed ones and those of changed parts. A
+  // wire a changed part has gained is a changed wire itself.
+  std::vector<uint32_t> refile = changed_wires;
+  for (uint32_t id : changed_parts)
+    forEachWireRecordOf(id, [&](uint32_t wire) { refile.push_back(wire); });
+  std::sort(refile.begin(), refile.end());
+  refile.erase(std::unique(refile.begin(), refile.end()), refile.end());
+
+  // Out under the old records, back in under the new ones
+  for (uint32_t wire : refile)
+    fileWire(synced, wire, false);
+  for (uint32_t id : changed_parts)
+    fileComponent(synced, id, false);
+
+  auto link = [&](const BoardState &state, uint32_t wire, bool add) {
+    if (wire >= state.connections.size())
+      return;
+    const ConnectionRecord &c = state.connections[wire];
+    if (!c.alive)
+      return;
+    for (uint32_t end : {c.component_a, c.component_b}) {
+      if (wires_of.size() <= end)
+        wires_of.resize(end + 1);
+      if (add)
+        insertSorted(wires_of[end], wire);
+      else
+        eraseSorted(wires_of[end], wire);
+    }
+  };
+  for (uint32_t wire : changed_wires) {
+    link(synced, wire, false);
+    link(board, wire, true);
+  }
+
+  synced = board;
+  for (uint32_t id : changed_parts)
+    fileComponent(synced, id, true);
+  for (uint32_t wire : refile)
+    fileWire(synced, wire, true);
+}
+
+BoardChunks::Chunk &BoardChunks::touch(ChunkKey key) { return by_key[key]; }
+
+void BoardChunks::dropIfEmpty(ChunkKey key) {
+  auto it = by_key.find(key);
+  if (it != by_key.end() && it->second.components.empty() &&
+      it->second.wires.empty() && it->second.cross_wires.empty())
+    by_key.erase(it);
+}
+
+void BoardChunks::fileComponent(const BoardState &board, uint32_t id,
+                                bool add) {
+  if (id >= board.components.size() || !board.components[id].alive)
+    return;
+  ChunkKey key = keyAt(board.components[id].position);
+  if (add) {
+    Chunk &chunk = touch(key);
+    insertSorted(chunk.components, id);
+    chunk.revision = ++revisions;
+    return;
+  }
+  auto it = by_key.find(key);
+  if (it == by_key.end())
+    return;
+  eraseSorted(it->second.components, id);
+  it->second.revision = ++revisions;
+  dropIfEmpty(key);
+}
+
+void BoardChunks::fileWire(const BoardState &board, uint32_t wire, bool add) {
+  if (!wireValid(board, wire))
+    return;
+  const ConnectionRecord &c = board.connections[wire];
+  ChunkKey a = keyAt(board.components[c.component_a].position);
+  ChunkKey b = keyAt(board.components[c.component_b].position);
+  auto file = [&](ChunkKey key, std::vector<uint32_t> Chunk::*list) {
+    if (add) {
+      insertSorted(touch(key).*list, wire);
+      return;
+    }
+    auto it = by_key.find(key);
+    if (it == by_key.end())
+      return;
+    eraseSorted(it->second.*list, wire);
+    dropIfEmpty(key);
+  };
+  if (a == b) {
+    file(a, &Chunk::wires);
+  } else {
+    file(a, &Chunk::cross_wires);
+    file(b, &Chunk::cross_wires);
+  }
+}
+
+const BoardChunks::Chunk *BoardChunks::find(ChunkKey key) const {
+  auto it = by_key.find(key);
+  return it == by_key.end() ? nullptr : &it->second;
+}
+
+// Per-chunk grids
+
+void ChunkedGrid::update(uint32_t id, ChunkKey chunk, Rectangle bounds) {
+  auto it = slot_of.find(id);
+  if (it != slot_of.end() && it->second.chunk != chunk) {
+    remove(id);
+    it = slot_of.end();
+  }
+
+  if (it == slot_of.end()) {
+    Part &part = parts[chunk];
+    uint32_t slot;
+    if (!part.free_slots.empty()) {
+      slot = part.free_slots.back();
+      part.free_slots.pop_back();
+      part.ids[slot] = id;
+    } else {
+      slot = static_cast<uint32_t>(part.ids.size());
+      part.ids.push_back(id);
+    }
+    if (part.ids.size() == part.free_slots.size() + 1)
+      part.extent = bounds; // its first item
+    it = slot_of.emplace(id, Slot{chunk, slot}).first;
+  }
+
+  Part &part = parts[chunk];
+  part.grid.update(it->second.slot, bounds);
+  float x0 = std::min(part.extent.x, bounds.x);
+  float y0 = std::min(part.extent.y, bounds.y);
+  float x1 = std::max(part.extent.x + part.extent.width,
+                      bounds.x + bounds.width);
+  float y1 = std::max(part.extent.y + part.extent.height,
+                      bounds.y + bounds.height);
+  part.extent = {x0, y0, x1 - x0, y1 - y0};
+}
+
+void ChunkedGrid::remove(uint32_t id) {
+  auto it = slot_of.find(id);
+  if (it == slot_of.end())
+    return;
+  auto found = parts.find(it->second.chunk);
+  Part &part = found->second;
+  part.grid.remove(it->second.slot);
+  part.free_slots.push_back(it->second.slot);
+  slot_of.erase(it);
+  if (part.free_slots.size() == part.ids.size())
+    parts.erase(found); // its last item
+}
+
+// Page file
+
+ChunkPageFile::~ChunkPageFile() {
+  if (file)
+    std::fclose(file);
+}
+
+bool ChunkPageFile::open() {
+  if (file || failed)
+    return file != nullptr;
+  file = std::tmpfile();
+  if (!file) {
+    failed = true;
+    LOG_WARN("No chunk page file; evicted chunks page in from the board");
+  }
+  return file != nullptr;
+}
+
+void ChunkPageFile::write(ChunkKey key, uint64_t revision,
+                          const BoardState &board,
+                          const std::vector<uint32_t> &ids) {
+  PROFILE_ZONE("ChunkPageFile::write");
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!open())
+    return;
+
+  buffer.clear();
+  for (uint32_t id : ids) {
+    if (id < board.components.size())
+      buffer.push_back({id, board.components[id]});
+  }
+
+  // A page is rewritten in place while it fits
+  auto it = pages.find(key);
+  Page page = it != pages.end() ? it->second : Page{end, 0, 0, 0};
+  if (page.capacity < buffer.size()) {
+    page.offset = end;
+    page.capacity = static_cast<uint32_t>(buffer.size());
+    end += static_cast<long>(page.capacity * sizeof(Entry));
+  }
+  if (std::fseek(file, page.offset, SEEK_SET) != 0 ||
+      std::fwrite(buffer.data(), sizeof(Entry), buffer.size(), file) !=
+          buffer.size()) {
+    LOG_WARN("Failed to write a chunk page");
+    pages.erase(key);
+    return;
+  }
+  page.count = static_cast<uint32_t>(buffer.size());
+  page.revision = revision;
+  pages[key] = page;
+}
+
+bool ChunkPageFile::read(ChunkKey key, uint64_t revision,
+                         std::vector<Entry> &out) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = pages.find(key);
+  if (it == pages.end() || it->second.revision != revision)
+    return false;
+  out.resize(it->second.count);
+  return std::fseek(file, it->second.offset, SEEK_SET) == 0 &&
+         std::fread(out.data(), sizeof(Entry), out.size(), file) ==
+             out.size();
+}
+
+size_t ChunkPageFile::pageCount() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return pages.size();
+}
+
+// Loader
+
+ChunkLoader::ChunkLoader() : shared(std::make_shared<Shared>()) {}
+
+std::vector<std::shared_ptr<ElectronicComponent>>
+ChunkLoader::build(Shared &shared, ChunkKey key, uint64_t revision,
+                   const BoardState &board, const std::vector<uint32_t> &ids) {
+  PROFILE_ZONE("ChunkLoader::pageIn");
+  std::vector<std::shared_ptr<ElectronicComponent>> objects;
+  std::vector<ChunkPageFile::Entry> page;
+  if (shared.pages.read(key, revision, page)) {
+    objects.reserve(page.size());
+    for (const ChunkPageFile::Entry &entry : page) {
+      if (auto obj = makeComponentFromRecord(entry.record, entry.id))
+        objects.push_back(std::move(obj));
+    }
+    return objects;
+  }
+
+  objects.reserve(ids.size());
+  for (uint32_t id : ids) {
+    if (id >= board.components.size())
+      continue;
+    if (auto obj = makeComponentFromRecord(board.components[id], id))
+      objects.push_back(std::move(obj));
+  }
+  return objects;
+}
+
+void ChunkLoader::request(ChunkKey key, uint64_t generation,
+                          const BoardChunks::Chunk &chunk,
+                          const BoardState &board) {
+  if (!in_flight.insert(key).second)
+    return;
+  threadPool().submit([shared = shared, key, generation,
+                       revision = chunk.revision, board,
+                       ids = chunk.components] {
+    Result result{key, generation, build(*shared, key, revision, board, ids)};
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    shared->done.push_back(std::move(result));
+  });
+}
+
+void ChunkLoader::collect(std::vector<Result> &out) {
+  size_t first = out.size();
+  {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    if (shared->done.empty())
+      return;
+    for (Result &r : shared->done)
+      out.push_back(std::move(r));
+    shared->done.clear();
+  }
+  for (size_t i = first; i < out.size(); ++i)
+    in_flight.erase(out[i].key);
+}
+
+std::vector<std::shared_ptr<ElectronicComponent>>
+ChunkLoader::load(ChunkKey key, const BoardChunks::Chunk &chunk,
+                  const BoardState &board) {
+  return build(*shared, key, chunk.revision, board, chunk.components);
+}
+
+void ChunkLoader::pageOut(ChunkKey key, const BoardChunks::Chunk &chunk,
+                          const BoardState &board) {
+  shared->pages.write(key, chunk.revision, board, chunk.components);
+}
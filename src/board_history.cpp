@@ -0,0 +1,66 @@
+#include "../include/board_history.hpp"
+#include "../include/game_objects/electronic_components/component_factory.hpp"
+
+ComponentRecord makeComponentRecord(const ElectronicComponent &obj) {
+  ComponentRecord rec;
+  rec.alive = true;
+  rec.label = obj.label;
+  rec.position = obj.position;
+  rec.voltage = obj.voltage;
+  rec.current = obj.current;
+  rec.resistance = obj.resistance;
+  return rec;
+}
+
+std::shared_ptr<ElectronicComponent>
+makeComponentFromRecord(const ComponentRecord &rec, uint32_t id) {
+  std::shared_ptr<ElectronicComponent> obj =
+      makeComponent(rec.label, rec.position);
+  if (!obj)
+    return nullptr;
+
+  obj->id = id;
+  for (size_t i = 0; i < obj->pins.size(); ++i)
+    obj->pins[i].setOwner(id, static_cast<int16_t>(i));
+  obj->position = rec.position;
+  obj->voltage = rec.voltage;
+  obj->current = rec.current;
+  obj->resistance = rec.resistance;
+  obj->update();
+  return obj;
+}
+
+void BoardHistory::reset(const BoardState &initial) {
+  current = initial;
+  undo_stack.clear();
+  redo_stack.clear();
+}
+
+void BoardHistory::commit(const BoardState &state) {
+  undo_stack.push_back(current);
+  if (undo_stack.size() > MAX_DEPTH)
+    undo_stack.pop_front();
+
+  current = state;
+  redo_stack.clear();
+}
+
+const BoardState *BoardHistory::undo() {
+  if (undo_stack.empty())
+    return nullptr;
+
+  redo_stack.push_back(current);
+  current = undo_stack.back();
+  undo_stack.pop_back();
+  return &current;
+}
+
+const BoardState *BoardHistory::redo() {
+  if (redo_stack.empty())
+    return nullptr;
+
+  undo_stack.push_back(current);
+  current = redo_stack.back();
+  redo_stack.pop_back();
+  return &current;
+}
@@ -0,0 +1,350 @@
+#include "../include/circuit_generator.hpp"
+#include "../include/game_objects/electronic_components/component_factory.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+static constexpr float NODE_SPACING = 300.0f;
+static constexpr float LED_TARGET_CURRENT = 0.015f; // A, for limiting resistors
+
+namespace {
+
+// Intermediate netlist: parts are edges between numbered nets.
+struct Netlist {
+  struct Part {
+    ComponentLabel label;
+    int a; // net of pins[0]
+    int b; // net of pins[1]
+    float value;
+  };
+
+  std::vector<Vector2> nodes;
+  std::vector<Part> parts;
+
+  int addNode(Vector2 pos) {
+    nodes.push_back(pos);
+    return static_cast<int>(nodes.size()) - 1;
+  }
+  void addPart(ComponentLabel label, int a, int b, float value = 0.0f) {
+    parts.push_back({label, a, b, value});
+  }
+};
+
+struct Edge {
+  int a;
+  int b;
+};
+
+// mt19937's output is fixed by the standard but the std distributions are
+// not, so boards are drawn through these to match across platforms.
+float unitRandom(std::mt19937 &rng) {
+  return static_cast<float>(rng() >> 8) * (1.0f / 16777216.0f);
+}
+uint32_t belowRandom(std::mt19937 &rng, uint32_t bound) {
+  return static_cast<uint32_t>((static_cast<uint64_t>(rng()) * bound) >> 32);
+}
+bool chanceRandom(std::mt19937 &rng, float p) { return unitRandom(rng) < p; }
+
+int findRoot(std::vector<int> &parent, int i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+// Random spanning tree of the candidates first (so the board stays
+// connected), then each remaining candidate with probability `density`,
+// truncated to `limit` edges.
+std::vector<Edge> pickEdges(int node_count, std::vector<Edge> candidates,
+                            float density, int limit, std::mt19937 &rng) {
+  for (size_t i = candidates.size(); i > 1; --i)
+    std::swap(candidates[i - 1],
+              candidates[belowRandom(rng, static_cast<uint32_t>(i))]);
+
+  std::vector<int> parent(node_count);
+  std::iota(parent.begin(), parent.end(), 0);
+  std::vector<Edge> tree;
+  std::vector<Edge> optional;
+  for (const Edge &e : candidates) {
+    int ra = findRoot(parent, e.a);
+    int rb = findRoot(parent, e.b);
+    if (ra != rb) {
+      parent[ra] = rb;
+      tree.push_back(e);
+    } else {
+      optional.push_back(e);
+    }
+  }
+
+  density = std::clamp(density, 0.0f, 1.0f);
+  std::vector<Edge> picked = tree;
+  for (const Edge &e : optional) {
+    if (chanceRandom(rng, density))
+      picked.push_back(e);
+  }
+  if (static_cast<int>(picked.size()) > limit)
+    picked.resize(std::max(limit, 0));
+  return picked;
+}
+
+// Log-uniform resistance between 100 Ohm and 10 kOhm, in kOhm
+float randomResistance(std::mt19937 &rng) {
+  return std::pow(10.0f, unitRandom(rng) * 2.0f - 1.0f);
+}
+
+// Smallest grid side whose expected part count reaches `edges`
+int gridSide(int edges, float density, bool diagonals) {
+  density = std::clamp(density, 0.0f, 1.0f);
+  for (int side = 2;; ++side) {
+    int nodes = side * side;
+    int candidates = 2 * side * (side - 1);
+    if (diagonals)
+      candidates += (side - 1) * (side - 1);
+    int tree = nodes - 1;
+    if (tree + density * (candidates - tree) >= edges)
+      return side;
+  }
+}
+
+void buildLadder(Netlist &net, int parts, float voltage) {
+  int sections = std::max(1, (parts - 1) / 2);
+  int ground = net.addNode({0.0f, NODE_SPACING});
+  int top = net.addNode({0.0f, 0.0f});
+  net.addPart(ComponentLabel::Battery, top, ground, voltage);
+
+  for (int i = 0; i < sections; ++i) {
+    int next = net.addNode({(i + 1) * NODE_SPACING, 0.0f});
+    net.addPart(ComponentLabel::Resistor, top, next, 1.0f);    // R
+    net.addPart(ComponentLabel::Resistor, next, ground, 2.0f); // 2R
+    top = next;
+  }
+}
+
+void buildMesh(Netlist &net, int parts, float density, float voltage,
+               std::mt19937 &rng) {
+  int side = gridSide(parts - 1, density, false);
+  std::vector<Edge> candidates;
+  for (int y = 0; y < side; ++y) {
+    for (int x = 0; x < side; ++x) {
+      net.addNode({x * NODE_SPACING, y * NODE_SPACING});
+      int i = y * side + x;
+      if (x + 1 < side)
+        candidates.push_back({i, i + 1});
+      if (y + 1 < side)
+        candidates.push_back({i, i + side});
+    }
+  }
+
+  net.addPart(ComponentLabel::Battery, 0, side * side - 1, voltage);
+  for (const Edge &e :
+       pickEdges(side * side, candidates, density, parts - 1, rng))
+    net.addPart(ComponentLabel::Resistor, e.a, e.b, randomResistance(rng));
+}
+
+void buildLedArray(Netlist &net, int parts, float voltage) {
+  int branches = std::max(1, (parts - 1) / 2);
+  int columns = static_cast<int>(std::ceil(std::sqrt(branches)));
+
+  int positive = net.addNode({0.0f, 0.0f});
+  int negative = net.addNode({0.0f, NODE_SPACING});
+  net.addPart(ComponentLabel::Battery, positive, negative, voltage);
+
+  // Limits each branch to LED_TARGET_CURRENT at the default LED drop
+  float forward = makeComponent(ComponentLabel::Led, {0, 0})->voltage;
+  float limit =
+      std::max(voltage - forward, 0.1f) / LED_TARGET_CURRENT / 1000.0f;
+
+  for (int i = 0; i < branches; ++i) {
+    int col = i % columns;
+    int row = i / columns;
+    int mid = net.addNode({(col + 1) * NODE_SPACING, row * NODE_SPACING});
+    net.addPart(ComponentLabel::Resistor, positive, mid, limit);
+    net.addPart(ComponentLabel::Led, mid, negative);
+  }
+}
+
+void buildSeriesParallel(Netlist &net, int parts, float voltage,
+                         std::mt19937 &rng) {
+  float extent = std::sqrt(static_cast<float>(parts)) * NODE_SPACING;
+
+  int positive = net.addNode({0.0f, 0.0f});
+  int negative = net.addNode({extent, extent});
+  net.addPart(ComponentLabel::Battery, positive, negative, voltage);
+  net.addPart(ComponentLabel::Resistor, positive, negative,
+              randomResistance(rng));
+
+  // Repeatedly split a random resistor in series or double it in parallel
+  while (static_cast<int>(net.parts.size()) < parts) {
+    uint32_t resistors = static_cast<uint32_t>(net.parts.size()) - 1;
+    size_t i = 1 + belowRandom(rng, resistors); // part 0 is the battery
+    Netlist::Part part = net.parts[i];
+
+    if (chanceRandom(rng, 0.5f)) {
+      float x = unitRandom(rng) * extent;
+      float y = unitRandom(rng) * extent;
+      int mid = net.addNode({x, y});
+      net.parts[i].b = mid;
+      net.addPart(ComponentLabel::Resistor, mid, part.b,
+                  randomResistance(rng));
+    } else {
+      net.addPart(ComponentLabel::Resistor, part.a, part.b,
+                  randomResistance(rng));
+    }
+  }
+}
+
+void buildRandomPlanar(Netlist &net, int parts, float density, float voltage,
+                       std::mt19937 &rng) {
+  int side = gridSide(parts, density, true);
+  auto jitter = [&] { return unitRandom(rng) * 0.6f - 0.3f; };
+  auto flip = [&] { return chanceRandom(rng, 0.5f); };
+
+  // Jittered grid with one diagonal per cell stays planar
+  std::vector<Edge> candidates;
+  for (int y = 0; y < side; ++y) {
+    for (int x = 0; x < side; ++x) {
+      float jx = jitter();
+      float jy = jitter();
+      net.addNode({(x + jx) * NODE_SPACING, (y + jy) * NODE_SPACING});
+      int i = y * side + x;
+      if (x + 1 < side)
+        candidates.push_back({i, i + 1});
+      if (y + 1 < side)
+        candidates.push_back({i, i + side});
+      if (x + 1 < side && y + 1 < side) {
+        if (flip())
+          candidates.push_back({i, i + side + 1});
+        else
+          candidates.push_back({i + 1, i + side});
+      }
+    }
+  }
+
+  std::vector<Edge> edges =
+      pickEdges(side * side, candidates, density, parts, rng);
+  for (size_t k = 0; k < edges.size(); ++k) {
+    Edge e = edges[k];
+    if (flip())
+      std::swap(e.a, e.b);
+
+    uint32_t roll = belowRandom(rng, 100);
+    if (k == 0 || roll < 4) {
+      net.addPart(ComponentLabel::Battery, e.a, e.b, voltage);
+    } else if (roll < 14) {
+      net.addPart(ComponentLabel::Led, e.a, e.b);
+    } else {
+      net.addPart(ComponentLabel::Resistor, e.a, e.b, randomResistance(rng));
+    }
+  }
+}
+
+// Turns the netlist into component and wire records. Each part sits between
+// its two nets; the pins of a net are wired together in a chain.
+BoardState emitBoard(const Netlist &net) {
+  BoardState board;
+  std::unordered_map<int, ComponentRecord> defaults;
+  std::vector<std::vector<std::pair<uint32_t, int16_t>>> pins_of_net(
+      net.nodes.size());
+
+  for (const Netlist::Part &part : net.parts) {
+    auto it = defaults.find(static_cast<int>(part.label));
+    if (it == defaults.end()) {
+      auto prototype = makeComponent(part.label, {0, 0});
+      it = defaults
+               .emplace(static_cast<int>(part.label),
+                        makeComponentRecord(*prototype))
+               .first;
+    }
+
+    ComponentRecord rec = it->second;
+    Vector2 a = net.nodes[part.a];
+    Vector2 b = net.nodes[part.b];
+    rec.position = {(a.x + b.x) / 2.0f, (a.y + b.y) / 2.0f};
+    if (part.label == ComponentLabel::Battery)
+      rec.voltage = part.value;
+    else if (part.label == ComponentLabel::Resistor)
+      rec.resistance = part.value;
+
+    uint32_t id = static_cast<uint32_t>(board.components.size());
+    board.components.push_back(rec);
+    pins_of_net[part.a].emplace_back(id, 0);
+    pins_of_net[part.b].emplace_back(id, 1);
+  }
+
+  for (const auto &pins : pins_of_net) {
+    for (size_t i = 1; i < pins.size(); ++i) {
+      ConnectionRecord rec;
+      rec.alive = true;
+      rec.component_a = pins[i - 1].first;
+      rec.pin_a = pins[i - 1].second;
+      rec.component_b = pins[i].first;
+      rec.pin_b = pins[i].second;
+      board.connections.push_back(rec);
+    }
+  }
+  return board;
+}
+
+} // namespace
+
+const char *circuitTopologyName(CircuitTopology topology) {
+  switch (topology) {
+  case CircuitTopology::ResistorLadder:
+    return "ladder";
+  case CircuitTopology::ResistorMesh:
+    return "mesh";
+  case CircuitTopology::LedArray:
+    return "led-array";
+  case CircuitTopology::SeriesParallel:
+    return "series-parallel";
+  case CircuitTopology::RandomPlanar:
+    return "random-planar";
+  }
+  return "unknown";
+}
+
+bool parseCircuitTopology(const std::string &name, CircuitTopology &out) {
+  const CircuitTopology all[] = {
+      CircuitTopology::ResistorLadder, CircuitTopology::ResistorMesh,
+      CircuitTopology::LedArray,       CircuitTopology::SeriesParallel,
+      CircuitTopology::RandomPlanar,
+  };
+  for (CircuitTopology topology : all) {
+    if (name == circuitTopologyName(topology)) {
+      out = topology;
+      return true;
+    }
+  }
+  return false;
+}
+
+BoardState generateCircuit(const CircuitGeneratorOptions &options) {
+  std::mt19937 rng(options.seed);
+  int parts = std::max(options.parts, 2);
+
+  Netlist net;
+  switch (options.topology) {
+  case CircuitTopology::ResistorLadder:
+    buildLadder(net, parts, options.battery_voltage);
+    break;
+  case CircuitTopology::ResistorMesh:
+    buildMesh(net, parts, options.wire_density, options.battery_voltage, rng);
+    break;
+  case CircuitTopology::LedArray:
+    buildLedArray(net, parts, options.battery_voltage);
+    break;
+  case CircuitTopology::SeriesParallel:
+    buildSeriesParallel(net, parts, options.battery_voltage, rng);
+    break;
+  case CircuitTopology::RandomPlanar:
+    buildRandomPlanar(net, parts, options.wire_density,
+                      options.battery_voltage, rng);
+    break;
+  }
+  return emitBoard(net);
+}
@@ -0,0 +1,166 @@
+#include "../include/file_watcher.hpp"
+#include "../include/log.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// How often the thread checks for shutdown, and polls when not on inotify
+static constexpr int WAKE_MS = 100;
+static constexpr int POLL_MS = 500;
+
+FileWatcher::~FileWatcher() {
+  stopping = true;
+  if (worker.joinable())
+    worker.join();
+#ifdef __linux__
+  if (inotify_fd >= 0)
+    close(inotify_fd);
+#endif
+}
+
+bool FileWatcher::watch(const std::string &dir) {
+  std::error_code error;
+  if (!fs::is_directory(dir, error)) {
+    LOG_WARN("Can't watch %s: not a directory", dir.c_str());
+    return false;
+  }
+
+#ifdef __linux__
+  if (inotify_fd < 0) {
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+      LOG_ERROR("Failed to start inotify");
+      return false;
+    }
+  }
+  addTree(dir);
+#else
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    roots.push_back(dir);
+  }
+  scan(false); // the files as they are now
+#endif
+
+  if (!worker.joinable())
+    worker = std::thread(&FileWatcher::run, this);
+  return true;
+}
+
+void FileWatcher::addTree(const std::string &dir) {
+#ifdef __linux__
+  constexpr uint32_t EVENTS =
+      IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+  auto add = [&](const std::string &path) {
+    int wd = inotify_add_watch(inotify_fd, path.c_str(), EVENTS);
+    if (wd < 0)
+      return;
+    std::lock_guard<std::mutex> lock(mutex);
+    dirs[wd] = path;
+  };
+
+  add(dir);
+  std::error_code error;
+  for (fs::recursive_directory_iterator it(dir, error), end;
+       !error && it != end; it.increment(error)) {
+    if (it->is_directory(error))
+      add(it->path().string());
+  }
+#else
+  (void)dir;
+#endif
+}
+
+void FileWatcher::scan(bool report) {
+  std::vector<std::string> watched;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    watched = roots;
+  }
+
+  std::vector<std::string> changed;
+  for (const std::string &root : watched) {
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(root, error), end;
+         !error && it != end; it.increment(error)) {
+      if (!it->is_regular_file(error))
+        continue;
+      std::string path = it->path().string();
+      fs::file_time_type stamp = it->last_write_time(error);
+      std::lock_guard<std::mutex> lock(mutex);
+      auto [entry, added] = stamps.emplace(path, stamp);
+      if (!added && entry->second != stamp) {
+        entry->second = stamp;
+        changed.push_back(path);
+      } else if (added && report) {
+        changed.push_back(path);
+      }
+    }
+  }
+  for (const std::string &path : changed)
+    handler(path);
+}
+
+void FileWatcher::run() {
+#ifdef __linux__
+  // Aligned for the inotify_event records read into it
+  alignas(inotify_event) char buffer[16 * 1024];
+  while (!stopping) {
+    pollfd ready = {inotify_fd, POLLIN, 0};
+    if (poll(&ready, 1, WAKE_MS) <= 0)
+      continue;
+
+    // Editors write a file in several steps; drain the burst first
+    std::vector<std::string> changed;
+    for (;;) {
+      ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+      if (length <= 0)
+        break;
+      for (char *p = buffer; p < buffer + length;) {
+        const auto *event = reinterpret_cast<const inotify_event *>(p);
+        p += sizeof(inotify_event) + event->len;
+        if (event->len == 0)
+          continue;
+
+        std::string dir;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          auto it = dirs.find(event->wd);
+          if (it == dirs.end())
+            continue;
+          dir = it->second;
+        }
+        std::string path = (fs::path(dir) / event->name).string();
+        if (event->mask & IN_ISDIR)
+          addTree(path); // new folders are watched too
+        else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+          changed.push_back(path);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    for (const std::string &path : changed)
+      handler(path);
+  }
+#else
+  auto last = std::chrono::steady_clock::now();
+  while (!stopping) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(WAKE_MS));
+    auto now = std::chrono::steady_clock::now();
+    if (now - last < std::chrono::milliseconds(POLL_MS))
+      continue;
+    last = now;
+    scan(true);
+  }
+#endif
+}
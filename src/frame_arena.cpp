@@ -0,0 +1,65 @@
+#include "../include/frame_arena.hpp"
+
+#include <cassert>
+#include <cstdarg>
+#include <cstdio>
+
+FrameArena::FrameArena(size_t capacity)
+    : data(new char[capacity]), size(capacity) {}
+
+void *FrameArena::allocate(size_t bytes, size_t align) {
+  // new[] only guarantees max_align_t alignment for the blocks themselves
+  assert(align <= alignof(std::max_align_t) && (align & (align - 1)) == 0);
+
+  size_t start = (offset + align - 1) & ~(align - 1);
+  if (start + bytes <= size) {
+    offset = start + bytes;
+    return data.get() + start;
+  }
+
+  // Doesn't fit this frame; reset() makes room for next time
+  overflow.push_back(std::unique_ptr<char[]>(new char[bytes ? bytes : 1]));
+  overflow_bytes += bytes + align;
+  return overflow.back().get();
+}
+
+const char *FrameArena::format(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  va_list retry;
+  va_copy(retry, args);
+
+  // Format straight into the free space, and only measure first when the
+  // text turns out not to fit
+  size_t avail = size - offset;
+  int len = vsnprintf(data.get() + offset, avail, fmt, args);
+  va_end(args);
+
+  const char *text = "";
+  if (len >= 0 && static_cast<size_t>(len) < avail) {
+    text = data.get() + offset;
+    offset += len + 1;
+  } else if (len >= 0) {
+    char *buf = static_cast<char *>(allocate(len + 1, 1));
+    vsnprintf(buf, len + 1, fmt, retry);
+    text = buf;
+  }
+  va_end(retry);
+  return text;
+}
+
+void FrameArena::reset() {
+  if (!overflow.empty()) {
+    size += overflow_bytes;
+    size += size / 2; // headroom so a slowly growing frame settles quickly
+    data.reset(new char[size]);
+    overflow.clear();
+    overflow_bytes = 0;
+  }
+  offset = 0;
+}
+
+FrameArena &frameArena() {
+  static FrameArena arena;
+  return arena;
+}
@@ -0,0 +1,31 @@
+#include "../include/geometry_kernels.hpp"
+
+#include <algorithm>
+
+namespace GeometryKernels {
+
+size_t firstContaining(const float *x, const float *y, const float *width,
+                       const float *height, size_t count, Vector2 point) {
+  for (size_t i = 0; i < count; ++i) {
+    if (point.x >= x[i] && point.x < x[i] + width[i] && point.y >= y[i] &&
+        point.y < y[i] + height[i])
+      return i;
+  }
+  return count;
+}
+
+uint32_t minKeyWithin(const float *x, const float *y, const uint32_t *key,
+                      size_t count, Vector2 center, float radius,
+                      uint32_t skip) {
+  float r2 = radius * radius;
+  uint32_t best = UINT32_MAX;
+  for (size_t i = 0; i < count; ++i) {
+    float dx = center.x - x[i];
+    float dy = center.y - y[i];
+    if (dx * dx + dy * dy <= r2 && key[i] != skip)
+      best = std::min(best, key[i]);
+  }
+  return best;
+}
+
+} // namespace GeometryKernels
@@ -0,0 +1,122 @@
+#include "../include/hot_reload.hpp"
+#include "../include/file_watcher.hpp"
+#include "../include/level_file.hpp"
+#include "../include/level_manager.hpp"
+#include "../include/log.hpp"
+#include "../include/profiler.hpp"
+#include "../include/resource_pack.hpp"
+#include "../include/texture_manager.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+std::unique_ptr<FileWatcher> watcher;
+
+// Results of the watcher thread, waiting for Apply()
+std::mutex mutex;
+std::vector<TextureRebuild> ready_textures;
+std::string level_path; // normalized
+bool level_ready = false;
+BoardState level_board;
+
+ElectronicsLevel *level = nullptr; // main thread only
+
+std::string normalPath(const std::string &path) {
+  return std::filesystem::path(path).lexically_normal().string();
+}
+
+// Watcher thread
+void onChanged(const std::string &path) {
+  PROFILE_ZONE("HotReload::onChanged");
+  std::string file = normalPath(path);
+  ResourcePack::Shadow(file); // the loose file is now newer than the pack
+
+  std::vector<TextureRebuild> rebuilt;
+  TextureManager::Rebuild(file, rebuilt);
+
+  bool is_level;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    is_level = !level_path.empty() && file == level_path;
+  }
+  BoardState board;
+  if (is_level && !loadLevelFile(file, board))
+    is_level = false; // half-written or broken; keep the current board
+
+  std::lock_guard<std::mutex> lock(mutex);
+  for (TextureRebuild &rebuild : rebuilt)
+    ready_textures.push_back(std::move(rebuild));
+  if (is_level && file == level_path) {
+    level_board = board; // a newer parse replaces one not yet applied
+    level_ready = true;
+  }
+}
+
+FileWatcher &fileWatcher() {
+  if (!watcher)
+    watcher = std::make_unique<FileWatcher>(onChanged);
+  return *watcher;
+}
+
+} // namespace
+
+void HotReload::Start(const std::string &resourceDir) {
+  std::error_code error;
+  if (!std::filesystem::is_directory(resourceDir, error))
+    return; // packed resources only, nothing to edit
+  if (fileWatcher().watch(resourceDir))
+    LOG_INFO("Hot reload watching %s", resourceDir.c_str());
+}
+
+void HotReload::Stop() {
+  watcher.reset(); // joins the thread
+  std::lock_guard<std::mutex> lock(mutex);
+  ready_textures.clear();
+  level_path.clear();
+  level_ready = false;
+  level = nullptr;
+}
+
+void HotReload::WatchLevel(ElectronicsLevel *target, const std::string &path) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    level_path = target ? normalPath(path) : std::string();
+    level_ready = false;
+  }
+  level = target;
+  if (!target)
+    return;
+
+  // Levels can live outside the resources folder
+  std::filesystem::path dir = std::filesystem::path(path).parent_path();
+  fileWatcher().watch(dir.empty() ? std::string(".") : dir.string());
+}
+
+void HotReload::Apply() {
+  std::vector<TextureRebuild> textures;
+  bool has_board = false;
+  BoardState board;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ready_textures.empty() && !level_ready)
+      return;
+    textures.swap(ready_textures);
+    if (level_ready) {
+      board = level_board;
+      has_board = true;
+      level_ready = false;
+    }
+  }
+
+  PROFILE_ZONE("HotReload::Apply");
+  for (const TextureRebuild &rebuild : textures)
+    TextureManager::Replace(rebuild);
+  if (has_board && level) {
+    level->applyBoard(board);
+    LOG_INFO("Reloaded level %s", level_path.c_str());
+  }
+}
@@ -5,7 +5,8 @@ namespace InputManager {
 // Private State
 static Vector2 internal_mouse_pos = {0, 0};
 static MovableObject *active_selection = nullptr;
-
+static InputFrame current_frame;
+static InputFrame previous_frame;
 
 Vector2 GetCachedMousePos() { return internal_mouse_pos; }
 
@@ -13,7 +14,73 @@ MovableObject *GetActiveSelection() { return active_selection; }
 
 void ClearActiveSelection() { active_selection = nullptr; }
 
-void updateMousePos() { internal_mouse_pos = GetMousePosition(); }
+void updateMousePos(const Camera2D &camera) {
+  internal_mouse_pos = GetScreenToWorld2D(current_frame.mouse, camera);
+}
+
+void beginFrame() {
+  InputFrame frame;
+  frame.mouse = ::GetMousePosition();
+  frame.wheel = ::GetMouseWheelMove();
+  for (int b = 0; b < INPUT_MAX_MOUSE_BUTTONS; ++b) {
+    if (::IsMouseButtonDown(b))
+      frame.mouse_buttons |= static_cast<uint8_t>(1u << b);
+  }
+  for (int k = 0; k < INPUT_MAX_KEYS; ++k) {
+    if (::IsKeyDown(k))
+      frame.keys.set(k);
+  }
+  beginFrame(frame);
+}
+
+void beginFrame(const InputFrame &frame) {
+  previous_frame = current_frame;
+  current_frame = frame;
+}
+
+const InputFrame &currentFrame() { return current_frame; }
+
+static bool keyDown(const InputFrame &frame, int key) {
+  return key >= 0 && key < INPUT_MAX_KEYS && frame.keys.test(key);
+}
+
+static bool buttonDown(const InputFrame &frame, int button) {
+  return button >= 0 && button < INPUT_MAX_MOUSE_BUTTONS &&
+         (frame.mouse_buttons >> button) & 1u;
+}
+
+Vector2 GetMousePosition() { return current_frame.mouse; }
+
+Vector2 GetMouseDelta() {
+  return {current_frame.mouse.x - previous_frame.mouse.x,
+          current_frame.mouse.y - previous_frame.mouse.y};
+}
+
+float GetMouseWheelMove() { return current_frame.wheel; }
+
+bool IsKeyDown(int key) { return keyDown(current_frame, key); }
+
+bool IsKeyPressed(int key) {
+  return keyDown(current_frame, key) && !keyDown(previous_frame, key);
+}
+
+bool IsKeyReleased(int key) {
+  return !keyDown(current_frame, key) && keyDown(previous_frame, key);
+}
+
+bool IsMouseButtonDown(int button) {
+  return buttonDown(current_frame, button);
+}
+
+bool IsMouseButtonPressed(int button) {
+  return buttonDown(current_frame, button) &&
+         !buttonDown(previous_frame, button);
+}
+
+bool IsMouseButtonReleased(int button) {
+  return !buttonDown(current_frame, button) &&
+         buttonDown(previous_frame, button);
+}
 
 void updateDragInputs(MovableObject &gameObject) {
   Vector2 inputPos = {0, 0};
@@ -24,14 +91,16 @@ void updateDragInputs(MovableObject &gameObject) {
   static std::unordered_map<MovableObject *, Vector2> dragOffsets;
   static std::unordered_map<MovableObject *, int> dragTouchIds;
 
-  if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-    inputPos = GetMousePosition();
+  // Qualified: raylib's functions of the same name are found through the
+  // MouseButton argument too
+  if (InputManager::IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+    inputPos = internal_mouse_pos;
     inputPressed = true;
     inputDown = true;
-  } else if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
-    inputPos = GetMousePosition();
+  } else if (InputManager::IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
+    inputPos = internal_mouse_pos;
     inputDown = true;
-  } else if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
+  } else if (InputManager::IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
     inputReleased = true;
   }
 
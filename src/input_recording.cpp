@@ -0,0 +1,187 @@
+#include "../include/input_recording.hpp"
+#include "../include/level_file.hpp"
+#include "../include/log.hpp"
+#include "../include/settings.hpp"
+
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+static const char MAGIC[8] = {'V', 'Q', 'I', 'N', 'P', 'U', 'T', '\0'};
+
+static void putU8(std::string &out, uint8_t v) {
+  out.push_back(static_cast<char>(v));
+}
+
+static void putU16(std::string &out, uint16_t v) {
+  putU8(out, v & 0xff);
+  putU8(out, v >> 8);
+}
+
+static void putU32(std::string &out, uint32_t v) {
+  putU16(out, v & 0xffff);
+  putU16(out, v >> 16);
+}
+
+static void putF32(std::string &out, float v) {
+  uint32_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  putU32(out, bits);
+}
+
+// Reads from a byte buffer; every read fails once the buffer runs out
+struct ByteReader {
+  const std::string &data;
+  size_t pos = 0;
+
+  bool u8(uint8_t &v) {
+    if (pos + 1 > data.size())
+      return false;
+    v = static_cast<uint8_t>(data[pos++]);
+    return true;
+  }
+  bool u16(uint16_t &v) {
+    uint8_t lo, hi;
+    if (!u8(lo) || !u8(hi))
+      return false;
+    v = static_cast<uint16_t>(lo | hi << 8);
+    return true;
+  }
+  bool u32(uint32_t &v) {
+    uint16_t lo, hi;
+    if (!u16(lo) || !u16(hi))
+      return false;
+    v = lo | static_cast<uint32_t>(hi) << 16;
+    return true;
+  }
+  bool f32(float &v) {
+    uint32_t bits;
+    if (!u32(bits))
+      return false;
+    std::memcpy(&v, &bits, sizeof(v));
+    return true;
+  }
+  bool bytes(size_t n, std::string &v) {
+    if (pos + n > data.size())
+      return false;
+    v = data.substr(pos, n);
+    pos += n;
+    return true;
+  }
+};
+
+bool InputRecorder::open(const std::string &path,
+                         const BoardState &initial_board,
+                         const Camera2D &camera, bool streaming) {
+  close();
+  file.open(path, std::ios::binary);
+  if (!file.is_open()) {
+    LOG_ERROR("Failed to open input recording: %s", path.c_str());
+    return false;
+  }
+
+  std::string board = serializeBoard(initial_board);
+  std::string header(MAGIC, sizeof(MAGIC));
+  putU32(header, INPUT_RECORDING_VERSION);
+  putU32(header, static_cast<uint32_t>(globalSettings.screenWidth));
+  putU32(header, static_cast<uint32_t>(globalSettings.screenHeight));
+  putF32(header, camera.target.x);
+  putF32(header, camera.target.y);
+  putF32(header, camera.offset.x);
+  putF32(header, camera.offset.y);
+  putF32(header, camera.rotation);
+  putF32(header, camera.zoom);
+  putU8(header, streaming ? 1 : 0);
+  putU32(header, static_cast<uint32_t>(board.size()));
+  header += board;
+  file.write(header.data(), header.size());
+  frames = 0;
+  return true;
+}
+
+void InputRecorder::write(const InputFrame &frame) {
+  if (!file.is_open())
+    return;
+
+  std::string &record = buffer;
+  record.clear();
+  putF32(record, frame.mouse.x);
+  putF32(record, frame.mouse.y);
+  putU8(record, frame.mouse_buttons);
+  putF32(record, frame.wheel);
+  putU16(record, static_cast<uint16_t>(frame.keys.count()));
+  for (int k = 0; k < INPUT_MAX_KEYS; ++k) {
+    if (frame.keys.test(k))
+      putU16(record, static_cast<uint16_t>(k));
+  }
+  file.write(record.data(), record.size());
+  frames++;
+}
+
+void InputRecorder::close() {
+  if (file.is_open())
+    file.close();
+}
+
+bool loadInputRecording(const std::string &path, InputRecording &out) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    LOG_ERROR("Failed to open input recording: %s", path.c_str());
+    return false;
+  }
+  std::string data((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+
+  ByteReader in{data};
+  std::string magic, board;
+  uint32_t version, width, height, boardSize;
+  if (!in.bytes(sizeof(MAGIC), magic) ||
+      std::memcmp(magic.data(), MAGIC, sizeof(MAGIC)) != 0 ||
+      !in.u32(version) || version > INPUT_RECORDING_VERSION) {
+    LOG_ERROR("Not a supported input recording: %s", path.c_str());
+    return false;
+  }
+  InputRecording rec;
+  uint8_t streaming = 0;
+  Camera2D &camera = rec.camera;
+  if (!in.u32(width) || !in.u32(height) ||
+      (version >= 3 &&
+       (!in.f32(camera.target.x) || !in.f32(camera.target.y) ||
+        !in.f32(camera.offset.x) || !in.f32(camera.offset.y) ||
+        !in.f32(camera.rotation) || !in.f32(camera.zoom) ||
+        !in.u8(streaming))) ||
+      !in.u32(boardSize) || !in.bytes(boardSize, board)) {
+    LOG_ERROR("Truncated input recording header: %s", path.c_str());
+    return false;
+  }
+
+  rec.screen_width = static_cast<int>(width);
+  rec.screen_height = static_cast<int>(height);
+  rec.streaming = streaming != 0;
+  if (!parseBoard(board, rec.initial_board))
+    return false;
+
+  // A partial trailing frame (e.g. after a crash) is dropped
+  while (in.pos < data.size()) {
+    InputFrame frame;
+    uint16_t keyCount;
+    if (!in.f32(frame.mouse.x) || !in.f32(frame.mouse.y) ||
+        !in.u8(frame.mouse_buttons) ||
+        (version >= 2 && !in.f32(frame.wheel)) || !in.u16(keyCount))
+      break;
+
+    bool complete = true;
+    for (uint16_t i = 0; i < keyCount && complete; ++i) {
+      uint16_t key;
+      complete = in.u16(key);
+      if (complete && key < INPUT_MAX_KEYS)
+        frame.keys.set(key);
+    }
+    if (!complete)
+      break;
+    rec.frames.push_back(frame);
+  }
+
+  out = std::move(rec);
+  return true;
+}
@@ -0,0 +1,173 @@
+#include "../include/level_cache.hpp"
+#include "../include/log.hpp"
+#include "../include/profiler.hpp"
+#include "../include/thread_pool.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+
+namespace fs = std::filesystem;
+
+LevelCatalog LevelCatalog::scan(const std::string &root) {
+  LevelCatalog catalog;
+  std::error_code error;
+  for (const fs::directory_entry &dir : fs::directory_iterator(root, error)) {
+    if (!dir.is_directory(error))
+      continue;
+    Chapter chapter;
+    chapter.name = dir.path().filename().string();
+    for (const fs::directory_entry &file :
+         fs::directory_iterator(dir.path(), error)) {
+      if (file.is_regular_file(error) && file.path().extension() == ".json")
+        chapter.levels.push_back(file.path().string());
+    }
+    if (chapter.levels.empty())
+      continue;
+    std::sort(chapter.levels.begin(), chapter.levels.end());
+    catalog.chapters.push_back(std::move(chapter));
+  }
+  std::sort(catalog.chapters.begin(), catalog.chapters.end(),
+            [](const Chapter &a, const Chapter &b) { return a.name < b.name; });
+  return catalog;
+}
+
+std::string LevelCatalog::displayName(const std::string &path) {
+  std::string stem = fs::path(path).stem().string();
+  size_t start = 0;
+  while (start < stem.size() && std::isdigit((unsigned char)stem[start]))
+    ++start;
+  if (start == stem.size())
+    start = 0; // nothing but a number
+  std::string name;
+  for (size_t i = start; i < stem.size(); ++i) {
+    char c = stem[i] == '_' || stem[i] == '-' ? ' ' : stem[i];
+    if (c == ' ' && (name.empty() || name.back() == ' '))
+      continue;
+    name += static_cast<char>(std::toupper((unsigned char)c));
+  }
+  return name;
+}
+
+struct LevelCache::Job {
+  std::string path;
+  std::mutex mutex;
+  std::condition_variable finished;
+  bool done = false;
+  std::unique_ptr<ElectronicsLevel> level; // nullptr if it didn't load
+};
+
+std::unique_ptr<ElectronicsLevel> LevelCache::build(const std::string &path,
+                                                    const ViewSize &view) {
+  PROFILE_ZONE("LevelCache::build");
+  auto level = std::make_unique<ElectronicsLevel>();
+  level->setStreaming(true); // Page far chunks out
+  if (!path.empty() && !level->loadFromFile(path))
+    return nullptr;
+  level->prepare(view);
+  return level;
+}
+
+void LevelCache::loadTextures() {
+  if (textures_loaded)
+    return;
+  ElectronicsLevel::loadTextures();
+  textures_loaded = true;
+}
+
+void LevelCache::preload(const std::vector<std::string> &paths) {
+  queued.clear();
+  for (const std::string &path : paths) {
+    if (isWarm(path) || (job && job->path == path) ||
+        std::find(queued.begin(), queued.end(), path) != queued.end())
+      continue;
+    queued.push_back(path);
+  }
+}
+
+void LevelCache::update() {
+  // Components take references to their textures when they're built
+  loadTextures();
+  collect(false);
+  if (job || queued.empty())
+    return;
+
+  job = std::make_shared<Job>();
+  job->path = queued.front();
+  queued.erase(queued.begin());
+  threadPool().submit([job = job, view = ViewSize::ofWindow()] {
+    std::unique_ptr<ElectronicsLevel> level = build(job->path, view);
+    std::lock_guard<std::mutex> lock(job->mutex);
+    job->level = std::move(level);
+    job->done = true;
+    job->finished.notify_all();
+  });
+}
+
+void LevelCache::collect(bool wait) {
+  if (!job)
+    return;
+  std::unique_ptr<ElectronicsLevel> level;
+  {
+    std::unique_lock<std::mutex> lock(job->mutex);
+    if (wait)
+      job->finished.wait(lock, [&] { return job->done; });
+    else if (!job->done)
+      return;
+    level = std::move(job->level);
+  }
+  std::string path = std::move(job->path);
+  job.reset();
+  if (level) {
+    LOG_DEBUG("Preloaded level %s", path.c_str());
+    insert(path, std::move(level));
+  }
+}
+
+std::unique_ptr<ElectronicsLevel>
+LevelCache::acquire(const std::string &path) {
+  PROFILE_ZONE("LevelCache::acquire");
+  loadTextures();
+  if (job && job->path == path)
+    collect(true);
+
+  for (auto it = warm.begin(); it != warm.end(); ++it) {
+    if (it->path == path) {
+      std::unique_ptr<ElectronicsLevel> level = std::move(it->level);
+      warm.erase(it);
+      return level;
+    }
+  }
+  return build(path, ViewSize::ofWindow());
+}
+
+void LevelCache::release(const std::string &path,
+                         std::unique_ptr<ElectronicsLevel> level) {
+  if (level)
+    insert(path, std::move(level));
+}
+
+void LevelCache::insert(const std::string &path,
+                        std::unique_ptr<ElectronicsLevel> level) {
+  warm.erase(std::remove_if(warm.begin(), warm.end(),
+                            [&](const Entry &e) { return e.path == path; }),
+             warm.end());
+  warm.insert(warm.begin(), Entry{path, std::move(level)});
+  if (warm.size() > CAPACITY)
+    warm.pop_back();
+}
+
+bool LevelCache::isWarm(const std::string &path) const {
+  for (const Entry &e : warm)
+    if (e.path == path)
+      return true;
+  return false;
+}
+
+void LevelCache::clear() {
+  collect(true);
+  queued.clear();
+  warm.clear();
+}
@@ -0,0 +1,175 @@
+#include "../include/level_file.hpp"
+#include "../include/log.hpp"
+#include "../include/resource_pack.hpp"
+#include <nlohmann/json.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+using nlohmann::json;
+
+const char *componentTypeName(ComponentLabel label) {
+  switch (label) {
+  case ComponentLabel::Battery:
+    return "battery";
+  case ComponentLabel::Led:
+    return "led";
+  case ComponentLabel::Resistor:
+    return "resistor";
+  case ComponentLabel::Switch:
+    return "switch";
+  }
+  return "unknown";
+}
+
+bool parseComponentType(const std::string &name, ComponentLabel &out) {
+  static const std::unordered_map<std::string, ComponentLabel> types = {
+      {"battery", ComponentLabel::Battery},
+      {"led", ComponentLabel::Led},
+      {"resistor", ComponentLabel::Resistor},
+      {"switch", ComponentLabel::Switch},
+  };
+  auto it = types.find(name);
+  if (it == types.end())
+    return false;
+  out = it->second;
+  return true;
+}
+
+std::string serializeBoard(const BoardState &board) {
+  json components = json::array();
+  for (size_t id = 0; id < board.components.size(); ++id) {
+    const ComponentRecord &rec = board.components[id];
+    if (!rec.alive)
+      continue;
+    components.push_back({
+        {"id", id},
+        {"type", componentTypeName(rec.label)},
+        {"x", rec.position.x},
+        {"y", rec.position.y},
+        {"voltage", rec.voltage},
+        {"current", rec.current},
+        {"resistance", rec.resistance},
+    });
+  }
+
+  json wires = json::array();
+  for (size_t id = 0; id < board.connections.size(); ++id) {
+    const ConnectionRecord &rec = board.connections[id];
+    if (!rec.alive)
+      continue;
+    wires.push_back({
+        {"from", {rec.component_a, rec.pin_a}},
+        {"to", {rec.component_b, rec.pin_b}},
+    });
+  }
+
+  json doc = {
+      {"format", "voltquest-level"},
+      {"version", LEVEL_FILE_VERSION},
+      {"components", components},
+      {"wires", wires},
+  };
+  return doc.dump(1);
+}
+
+// Throws json::exception on fields of the wrong JSON type
+static void parseRecords(const json &doc, BoardState &board) {
+  std::unordered_map<uint32_t, uint32_t> remap; // file id -> board id
+
+  for (const json &c : doc.value("components", json::array())) {
+    ComponentRecord rec;
+    rec.alive = true;
+    if (!c.is_object() ||
+        !parseComponentType(c.value("type", ""), rec.label)) {
+      LOG_WARN("Skipping component with unknown type");
+      continue;
+    }
+    rec.position = {c.value("x", 0.0f), c.value("y", 0.0f)};
+    rec.voltage = c.value("voltage", 0.0f);
+    rec.current = c.value("current", 0.0f);
+    rec.resistance = c.value("resistance", 0.0f);
+
+    remap[c.value("id", 0u)] = static_cast<uint32_t>(board.components.size());
+    board.components.push_back(rec);
+  }
+
+  for (const json &w : doc.value("wires", json::array())) {
+    if (!w.is_object() || !w.contains("from") || !w.contains("to") ||
+        w["from"].size() != 2 || w["to"].size() != 2)
+      continue;
+
+    auto a = remap.find(w["from"][0].get<uint32_t>());
+    auto b = remap.find(w["to"][0].get<uint32_t>());
+    if (a == remap.end() || b == remap.end()) {
+      LOG_WARN("Skipping wire to a missing component");
+      continue;
+    }
+
+    ConnectionRecord rec;
+    rec.alive = true;
+    rec.component_a = a->second;
+    rec.pin_a = w["from"][1].get<int16_t>();
+    rec.component_b = b->second;
+    rec.pin_b = w["to"][1].get<int16_t>();
+    board.connections.push_back(rec);
+  }
+}
+
+bool parseBoard(const std::string &text, BoardState &out) {
+  json doc = json::parse(text, nullptr, false);
+  if (doc.is_discarded() || !doc.is_object()) {
+    LOG_ERROR("Level is not valid JSON");
+    return false;
+  }
+  if (doc.value("format", "") != "voltquest-level" ||
+      doc.value("version", 0) > LEVEL_FILE_VERSION) {
+    LOG_ERROR("Unsupported level format");
+    return false;
+  }
+
+  BoardState board;
+  try {
+    parseRecords(doc, board);
+  } catch (const json::exception &e) {
+    LOG_ERROR("Malformed level: %s", e.what());
+    return false;
+  }
+
+  out = board;
+  return true;
+}
+
+bool saveLevelFile(const std::string &path, const BoardState &board) {
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    LOG_ERROR("Failed to open level file for writing: %s", path.c_str());
+    return false;
+  }
+  file << serializeBoard(board) << '\n';
+  return true;
+}
+
+bool loadLevelFile(const std::string &path, BoardState &out) {
+  std::string text;
+  ResourcePack::View packed;
+  if (ResourcePack::Find(path, packed)) {
+    text.assign(reinterpret_cast<const char *>(packed.data), packed.size);
+  } else {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+      LOG_ERROR("Failed to open level file: %s", path.c_str());
+      return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    text = buffer.str();
+  }
+
+  if (!parseBoard(text, out)) {
+    LOG_ERROR("Failed to load level: %s", path.c_str());
+    return false;
+  }
+  return true;
+}
@@ -1,38 +1,183 @@
 #include "../include/level_manager.hpp"
 #include "../include/game_objects/electronic_components/active_components.hpp"
+#include "../include/game_objects/electronic_components/component_factory.hpp"
 #include "../include/game_objects/electronic_components/passive_components.hpp"
 #include "../include/game_objects/electronic_components/power_sources.hpp"
+#include "../include/frame_arena.hpp"
+#include "../include/geometry_kernels.hpp"
 #include "../include/input_manager.hpp"
+#include "../include/level_file.hpp"
+#include "../include/log.hpp"
+#include "../include/profiler.hpp"
+#include "../include/simulation/solver_telemetry.hpp"
+#include "../include/text_renderer.hpp"
 #include "../include/texture_manager.hpp"
 #include "../include/ui_utils.hpp"
 
 #include <algorithm>
-#include <iostream>
+#include <cmath>
 #include <string>
+#include <unordered_map>
 
 static constexpr float SNAP_RADIUS_PX = 10.0f;
 
-ElectronicsLevel::ElectronicsLevel() {}
+// Written on F5
+static const char *SOLVER_TELEMETRY_PATH = "voltquest_solver.json";
+
+// Points of an inspector sweep
+static constexpr int SWEEP_POINTS = 256;
+
+// Inspector probes: probing another part past MAX_PROBES drops the oldest.
+// The plot shows the last PROBE_WINDOW frames, zoomed with the mouse wheel.
+// Its time axis counts stepped frames at the default 60 fps rather than
+// reading the clock, so a replay plots what the recorded session did.
+static constexpr size_t MAX_PROBES = 4;
+static constexpr uint64_t PROBE_WINDOW = 600;
+static constexpr uint64_t PROBE_MIN_WINDOW = 60;
+static constexpr double PROBE_FRAME_SECONDS = 1.0 / 60.0;
+
+// Board view
+static constexpr float MIN_ZOOM = 0.04f; // a 10k-part board fits the view
+static constexpr float MAX_ZOOM = 4.0f;
+static constexpr float ZOOM_STEP = 0.1f; // per mouse wheel notch
+static const Camera2D DEFAULT_CAMERA = {{0.0f, 0.0f}, {0.0f, 0.0f}, 0.0f,
+                                        1.0f};
+
+// Level of detail, by a part's smaller side in screen pixels: full sprites
+// down to FULL_DETAIL_MIN_PX, atlas impostors down to IMPOSTOR_MIN_PX and
+// flat blocks below that. Wires get one thin pass once their outline would
+// be thinner than WIRE_OUTLINE_MIN_PX.
+static constexpr float FULL_DETAIL_MIN_PX = 24.0f;
+static constexpr float IMPOSTOR_MIN_PX = 6.0f;
+static constexpr float WIRE_OUTLINE_MIN_PX = 3.0f;
+
+// Room around a component's collider for its sprite and selection outline
+static constexpr float BOUNDS_MARGIN_PX = 32.0f;
+
+// Chunk streaming, in world units around the view: chunks within
+// SYNC_MARGIN are paged in before the frame draws, those within
+// PREFETCH_MARGIN in the background, and those beyond EVICT_MARGIN dropped.
+static constexpr float SYNC_MARGIN = 512.0f;
+static constexpr float PREFETCH_MARGIN = BoardChunks::CHUNK_SIZE;
+static constexpr float EVICT_MARGIN = 2.0f * BoardChunks::CHUNK_SIZE;
+
+ElectronicsLevel::ElectronicsLevel() : probe_window(PROBE_WINDOW) {
+  history.reset(board_state);
+  simulation.setSolutionCache(&solutionCache());
+}
 ElectronicsLevel::~ElectronicsLevel() {}
 
 void ElectronicsLevel::processLevel() {
-  InputManager::updateMousePos();
-  updateLevel();
+  PROFILE_ZONE("processLevel");
+  stepLevel();
   drawLevel();
-  for (auto c : connections) {
-    int i = 0;
-    std::cout << "wire:" << i << '\n';
-    i++;
-  }
+}
+
+void ElectronicsLevel::stepLevel() {
+  setView(ViewSize::ofWindow());
+  updateCamera();
+  updateChunks(dynamic_cast<ElectronicComponent *>(
+      InputManager::GetActiveSelection()));
+  InputManager::updateMousePos(camera);
+  updateLevel();
+  updateComponentsPanel();
+  updateSimulation();
+  sampleProbes();
 }
 
 void ElectronicsLevel::resetLevel() {
   objects.clear();
   connections.clear();
+  objects_by_id.clear();
   activeObject = nullptr;
   is_placing_wire = false;
   wireStartPin = nullptr;
+  probes.clear();
+  boardChanged();
+  spatial_dirty = true; // the objects went without their records
   InputManager::ClearActiveSelection();
+
+  // Resetting is an edit like any other, so it can be undone. Records are
+  // marked dead rather than dropped: ids keep counting up, so parts added
+  // after the reset never reuse an id the history still describes.
+  for (size_t id = 0; id < board_state.connections.size(); ++id)
+    if (board_state.connections[id].alive)
+      board_state.connections.set(id, ConnectionRecord{});
+  for (size_t id = 0; id < board_state.components.size(); ++id)
+    if (board_state.components[id].alive)
+      board_state.components.set(id, ComponentRecord{});
+  commitHistory();
+}
+
+void ElectronicsLevel::undo() {
+  if (const BoardState *state = history.undo()) {
+    restoreState(*state);
+    InputManager::ClearActiveSelection(); // may be a replaced part
+  }
+}
+
+void ElectronicsLevel::redo() {
+  if (const BoardState *state = history.redo()) {
+    restoreState(*state);
+    InputManager::ClearActiveSelection();
+  }
+}
+
+void ElectronicsLevel::clearSelection() {
+  deselect();
+  InputManager::ClearActiveSelection();
+}
+
+void ElectronicsLevel::clearHistory() { history.reset(board_state); }
+
+void ElectronicsLevel::loadBoard(const BoardState &state) {
+  objects.clear();
+  connections.clear();
+  objects_by_id.clear();
+  probes.clear();
+  board_state = BoardState{};
+  spatial_dirty = true;
+
+  // Restoring over an empty board creates every component and wire
+  restoreState(state);
+  history.reset(board_state);
+}
+
+void ElectronicsLevel::reloadLiveScene() {
+  BoardState state = board_state;
+  objects.clear();
+  connections.clear();
+  objects_by_id.clear();
+  board_state = BoardState{};
+  spatial_dirty = true;
+  restoreState(state);
+}
+
+void ElectronicsLevel::setStreaming(bool enabled) {
+  if (streaming == enabled)
+    return;
+  streaming = enabled;
+  resident.clear();
+  // Streaming starts from nothing live and pages in what the view needs
+  reloadLiveScene();
+}
+
+bool ElectronicsLevel::loadFromFile(const std::string &path) {
+  BoardState state;
+  if (!loadLevelFile(path, state))
+    return false;
+  loadBoard(state);
+  return true;
+}
+
+bool ElectronicsLevel::saveToFile(const std::string &path) const {
+  return saveLevelFile(path, board_state);
+}
+
+void ElectronicsLevel::applyBoard(const BoardState &state) {
+  restoreState(state);
+  InputManager::ClearActiveSelection();
+  commitHistory();
 }
 
 void ElectronicsLevel::loadTextures() {
@@ -43,14 +188,196 @@ void ElectronicsLevel::loadTextures() {
   TextureManager::LoadSVG("resistor",
                           getResourcePath("assets/images/resistor.svg"),
                           safeScreenScale);
+
+  // Small copies of every sprite in one texture, for zoomed-out boards
+  TextureManager::LoadSVGAtlas(
+      "impostors",
+      {
+          {"impostors/battery", getResourcePath("assets/images/battery.svg")},
+          {"impostors/led", getResourcePath("assets/images/led.svg")},
+          {"impostors/resistor",
+           getResourcePath("assets/images/resistor.svg")},
+      },
+      safeScreenScale * IMPOSTOR_SCALE);
 }
 
 // Helpers
+
+ViewSize ViewSize::ofWindow() {
+  return {static_cast<float>(globalSettings.screenWidth),
+          static_cast<float>(globalSettings.screenHeight), safeScreenScale};
+}
+
+// Everything a component draws: sprite, pins and selection outline
+static Rectangle componentBounds(const ElectronicComponent &obj,
+                                 float scale) {
+  Rectangle r = obj.getCollider();
+  float x0 = r.x, y0 = r.y;
+  float x1 = r.x + r.width, y1 = r.y + r.height;
+  for (const Pin &pin : obj.pins) {
+    Rectangle p = pin.getCollider();
+    x0 = std::min(x0, p.x);
+    y0 = std::min(y0, p.y);
+    x1 = std::max(x1, p.x + p.width);
+    y1 = std::max(y1, p.y + p.height);
+  }
+  float margin = BOUNDS_MARGIN_PX * scale;
+  return {x0 - margin, y0 - margin, x1 - x0 + 2 * margin,
+          y1 - y0 + 2 * margin};
+}
+
+static Rectangle grownBy(Rectangle r, float by) {
+  return {r.x - by, r.y - by, r.width + 2 * by, r.height + 2 * by};
+}
+
+static Rectangle wireBounds(Vector2 a, Vector2 b, float scale) {
+  float half = 4.0f * scale; // half the outline's width
+  return {std::min(a.x, b.x) - half, std::min(a.y, b.y) - half,
+          std::fabs(a.x - b.x) + 2 * half, std::fabs(a.y - b.y) + 2 * half};
+}
+
+// A part of each kind at the origin: where the pins of parts that aren't
+// live objects sit relative to their position. Made once, on first use
+// from whichever thread builds a level first.
+static const ElectronicComponent *prototypeOf(ComponentLabel label) {
+  static const std::vector<std::shared_ptr<ElectronicComponent>> made = [] {
+    std::vector<std::shared_ptr<ElectronicComponent>> kinds;
+    for (int i = 0; i <= static_cast<int>(ComponentLabel::Switch); ++i) {
+      kinds.push_back(
+          makeComponent(static_cast<ComponentLabel>(i), {0.0f, 0.0f}));
+      if (kinds.back())
+        kinds.back()->update();
+    }
+    return kinds;
+  }();
+  size_t kind = static_cast<size_t>(label);
+  return kind < made.size() ? made[kind].get() : nullptr;
+}
+
+static bool wireValid(const BoardState &board, const ConnectionRecord &rec) {
+  return rec.alive && rec.component_a < board.components.size() &&
+         rec.component_b < board.components.size() &&
+         board.components[rec.component_a].alive &&
+         board.components[rec.component_b].alive;
+}
+
+ElectronicsLevel::WireShape
+ElectronicsLevel::wireShape(const ConnectionRecord &rec) const {
+  Color color = BLACK;
+  auto pinCenter = [&](uint32_t id, int16_t index) {
+    if (const Pin *pin = findPin(id, index)) {
+      color = pin->getColor();
+      return pin->getCenterPosition();
+    }
+    const ComponentRecord &part = board_state.components[id];
+    const ElectronicComponent *proto = prototypeOf(part.label);
+    if (!proto || index < 0 || (size_t)index >= proto->pins.size())
+      return part.position;
+    const Pin &pin = proto->pins[index];
+    color = pin.getColor();
+    Vector2 c = pin.getCenterPosition();
+    return Vector2{part.position.x + c.x, part.position.y + c.y};
+  };
+  Vector2 a = pinCenter(rec.component_a, rec.pin_a);
+  Vector2 b = pinCenter(rec.component_b, rec.pin_b); // colored like pin b
+  return {a, b, color};
+}
+
+void ElectronicsLevel::updateSpatialIndex() {
+  ensureChunks(); // wires are looked up through it
+  if (spatial_dirty) {
+    PROFILE_ZONE("updateSpatialIndex");
+    component_index.clear();
+    wire_index.clear();
+    cross_wire_index.clear();
+    wire_shapes.clear();
+    spatial_dirty = false;
+    for (const auto &obj : objects)
+      indexComponent(obj->id);
+    for (size_t id = 0; id < board_state.connections.size(); ++id)
+      indexWire(static_cast<uint32_t>(id));
+    indexed = board_state;
+    return;
+  }
+
+  // Only what an edit changed. A part that died or moved takes its wires'
+  // shapes with it, though their records didn't change.
+  indexed.components.diff(board_state.components, [&](size_t id) {
+    indexComponent(static_cast<uint32_t>(id));
+    chunks.forEachWireRecordOf(static_cast<uint32_t>(id),
+                               [&](uint32_t wire) { indexWire(wire); });
+  });
+  indexed.connections.diff(board_state.connections, [&](size_t id) {
+    indexWire(static_cast<uint32_t>(id));
+  });
+  indexed = board_state;
+}
+
+// Files a live part under the chunk of its record, which a part being
+// dragged may have left
+void ElectronicsLevel::indexComponent(uint32_t id) {
+  if (id >= board_state.components.size() || id >= objects_by_id.size() ||
+      !objects_by_id[id] || !board_state.components[id].alive) {
+    component_index.remove(id);
+    return;
+  }
+  component_index.update(
+      id, BoardChunks::keyAt(board_state.components[id].position),
+      componentBounds(*objects_by_id[id], view.scale));
+}
+
+// While streaming, wires within a chunk are indexed only while it is
+// resident; wires between chunks always are, as they may cross the view
+// from chunks far out of it.
+void ElectronicsLevel::indexWire(uint32_t id) {
+  auto drop = [&](ChunkedGrid &index) {
+    index.remove(id);
+    wire_shapes.erase(id);
+  };
+  if (id >= board_state.connections.size() ||
+      !wireValid(board_state, board_state.connections[id])) {
+    drop(wire_index);
+    drop(cross_wire_index);
+    return;
+  }
+
+  const ConnectionRecord &rec = board_state.connections[id];
+  auto chunkOf = [&](uint32_t part) {
+    return BoardChunks::keyAt(board_state.components[part].position);
+  };
+  ChunkKey a = chunkOf(rec.component_a);
+  ChunkKey b = chunkOf(rec.component_b);
+  ChunkedGrid &index = a == b ? wire_index : cross_wire_index;
+  (a == b ? cross_wire_index : wire_index).remove(id);
+  if (a == b && streaming && !resident.count(a)) {
+    drop(wire_index);
+    return;
+  }
+  WireShape &shape = wire_shapes[id];
+  shape = wireShape(rec);
+  index.update(id, a, wireBounds(shape.a, shape.b, view.scale));
+}
+
+void ElectronicsLevel::updateSpatialEntry(const ElectronicComponent &obj) {
+  if (spatial_dirty)
+    return; // rebuilt before its next use anyway
+
+  indexComponent(obj.id);
+  chunks.forEachWireOf(obj.id, [&](uint32_t wire) { indexWire(wire); });
+}
+
+// Needs a current spatial index. Returns the same pin as scanning the board
+// in order would: the first in range on the component with the lowest id.
 Pin *ElectronicsLevel::findSnapTarget(Pin *source, float radius) const {
   Vector2 a = source->getCenterPosition();
+  Rectangle area = {a.x - radius, a.y - radius, 2 * radius, 2 * radius};
 
-  for (auto &obj : objects) {
-    for (auto &pin : obj->pins) {
+  Pin *found = nullptr;
+  uint32_t found_id = UINT32_MAX;
+  component_index.query(area, [&](uint32_t id) {
+    if (id >= found_id)
+      return;
+    for (auto &pin : objects_by_id[id]->pins) {
       Pin *p = &pin;
       if (p == source)
         continue;
@@ -59,11 +386,151 @@ Pin *ElectronicsLevel::findSnapTarget(Pin *source, float radius) const {
       float dx = a.x - b.x;
       float dy = a.y - b.y;
 
-      if ((dx * dx + dy * dy) <= radius * radius)
-        return p;
+      if ((dx * dx + dy * dy) <= radius * radius) {
+        found = p;
+        found_id = id;
+        return;
+      }
     }
+  });
+  return found;
+}
+
+// Index of the first of `count` rectangles containing `point`, or `count`
+template <typename RectAt>
+static size_t firstContaining(size_t count, RectAt rectAt, Vector2 point) {
+  FrameArena &arena = frameArena();
+  ArenaVector<float> xs(count, 0.0f, ArenaAllocator<float>(arena));
+  ArenaVector<float> ys(count, 0.0f, ArenaAllocator<float>(arena));
+  ArenaVector<float> widths(count, 0.0f, ArenaAllocator<float>(arena));
+  ArenaVector<float> heights(count, 0.0f, ArenaAllocator<float>(arena));
+  for (size_t i = 0; i < count; ++i) {
+    Rectangle r = rectAt(i);
+    xs[i] = r.x;
+    ys[i] = r.y;
+    widths[i] = r.width;
+    heights[i] = r.height;
+  }
+  return GeometryKernels::firstContaining(xs.data(), ys.data(), widths.data(),
+                                          heights.data(), count, point);
+}
+
+// findSnapTarget() for every live pin at once, in id order; pins without
+// a target are left out. The pins are copied into a table bucketed by cells
+// of side 2 * radius, so each pin only tests the (usually 2x2) cells its
+// snap area overlaps, a batch at a time. Keys order pins as the scan does:
+// by component id, then by pin.
+//
+// While streaming, only parts within SYNC_MARGIN of the view take part.
+// Those are live whatever the loader has finished, so which wires a
+// release makes doesn't depend on its timing.
+void ElectronicsLevel::findSnapTargets(float radius,
+                                       ArenaVector<SnapPair> &out) const {
+  PROFILE_ZONE("findSnapTargets");
+  FrameArena &arena = frameArena();
+  ArenaVector<ElectronicComponent *> parts{
+      ArenaAllocator<ElectronicComponent *>(arena)};
+  parts.reserve(objects.size());
+  Rectangle area = grownBy(visibleWorldRect(), SYNC_MARGIN);
+  for (const auto &obj : objects) {
+    if (!streaming || CheckCollisionPointRec(obj->position, area))
+      parts.push_back(obj.get());
+  }
+  std::sort(parts.begin(), parts.end(),
+            [](const ElectronicComponent *a, const ElectronicComponent *b) {
+              return a->id < b->id;
+            });
+
+  size_t stride = 1;
+  size_t count = 0;
+  for (const ElectronicComponent *obj : parts) {
+    stride = std::max(stride, obj->pins.size());
+    count += obj->pins.size();
+  }
+  if (count == 0)
+    return;
+
+  float cell = std::max(2.0f * radius, 1.0f);
+  float reach = radius * 1.01f; // slack for rounding in the distance test
+  size_t bucket_count = 1;
+  while (bucket_count < count)
+    bucket_count <<= 1;
+  auto cellOf = [&](float v) {
+    return static_cast<int32_t>(std::floor(v / cell));
+  };
+  auto bucketOf = [&](int32_t cx, int32_t cy) {
+    uint32_t hash = static_cast<uint32_t>(cx) * 73856093u ^
+                    static_cast<uint32_t>(cy) * 19349663u;
+    return hash & static_cast<uint32_t>(bucket_count - 1);
+  };
+
+  // Pins in id order, then counted into their buckets
+  ArenaVector<Vector2> centers{ArenaAllocator<Vector2>(arena)};
+  ArenaVector<uint32_t> keys{ArenaAllocator<uint32_t>(arena)};
+  ArenaVector<uint32_t> buckets{ArenaAllocator<uint32_t>(arena)};
+  ArenaVector<uint32_t> starts(bucket_count + 1, 0,
+                               ArenaAllocator<uint32_t>(arena));
+  centers.reserve(count);
+  keys.reserve(count);
+  buckets.reserve(count);
+  for (size_t i = 0; i < parts.size(); ++i) {
+    const std::vector<Pin> &pins = parts[i]->pins;
+    for (size_t j = 0; j < pins.size(); ++j) {
+      Vector2 c = pins[j].getCenterPosition();
+      uint32_t bucket = bucketOf(cellOf(c.x), cellOf(c.y));
+      centers.push_back(c);
+      keys.push_back(static_cast<uint32_t>(i * stride + j));
+      buckets.push_back(bucket);
+      ++starts[bucket + 1];
+    }
+  }
+  for (size_t b = 0; b < bucket_count; ++b)
+    starts[b + 1] += starts[b];
+
+  ArenaVector<float> xs(count, 0.0f, ArenaAllocator<float>(arena));
+  ArenaVector<float> ys(count, 0.0f, ArenaAllocator<float>(arena));
+  ArenaVector<uint32_t> sorted_keys(count, 0, ArenaAllocator<uint32_t>(arena));
+  ArenaVector<uint32_t> fill(starts.begin(), starts.end() - 1,
+                             ArenaAllocator<uint32_t>(arena));
+  for (size_t k = 0; k < count; ++k) {
+    uint32_t slot = fill[buckets[k]]++;
+    xs[slot] = centers[k].x;
+    ys[slot] = centers[k].y;
+    sorted_keys[slot] = keys[k];
+  }
+
+  for (size_t k = 0; k < count; ++k) {
+    Vector2 c = centers[k];
+    int32_t x0 = cellOf(c.x - reach), x1 = cellOf(c.x + reach);
+    int32_t y0 = cellOf(c.y - reach), y1 = cellOf(c.y + reach);
+
+    // Cells can share a bucket; scan each bucket once
+    uint32_t seen[9];
+    size_t seen_count = 0;
+    uint32_t best = UINT32_MAX;
+    for (int32_t cy = y0; cy <= y1; ++cy) {
+      for (int32_t cx = x0; cx <= x1; ++cx) {
+        uint32_t bucket = bucketOf(cx, cy);
+        if (std::find(seen, seen + seen_count, bucket) != seen + seen_count)
+          continue;
+        seen[seen_count++] = bucket;
+        uint32_t begin = starts[bucket];
+        if (begin == starts[bucket + 1])
+          continue;
+        uint32_t found = GeometryKernels::minKeyWithin(
+            xs.data() + begin, ys.data() + begin, sorted_keys.data() + begin,
+            starts[bucket + 1] - begin, c, radius, keys[k]);
+        best = std::min(best, found);
+      }
+    }
+    if (best == UINT32_MAX)
+      continue;
+
+    auto pinAt = [&](uint32_t key) {
+      return &parts[key / stride]->pins[key % stride];
+    };
+    out.push_back({pinAt(keys[k]), pinAt(best)});
   }
-  return nullptr;
 }
 
 bool ElectronicsLevel::hasConnection(Pin *a, Pin *b) const {
@@ -75,104 +542,644 @@ bool ElectronicsLevel::hasConnection(Pin *a, Pin *b) const {
   return false;
 }
 
+Pin *ElectronicsLevel::findPin(uint32_t component_id,
+                               int16_t pin_index) const {
+  if (component_id >= objects_by_id.size() || !objects_by_id[component_id])
+    return nullptr;
+
+  auto &pins = objects_by_id[component_id]->pins;
+  if (pin_index < 0 || static_cast<size_t>(pin_index) >= pins.size())
+    return nullptr;
+  return &pins[pin_index];
+}
+
+// Edits
+static void applyRecord(ElectronicComponent &obj, const ComponentRecord &rec) {
+  obj.position = rec.position;
+  obj.voltage = rec.voltage;
+  obj.current = rec.current;
+  obj.resistance = rec.resistance;
+  obj.update(); // refresh colliders and pins for the new position
+}
+
+void ElectronicsLevel::addObject(
+    const std::shared_ptr<ElectronicComponent> &obj) {
+  uint32_t id = static_cast<uint32_t>(board_state.components.size());
+  obj->id = id;
+  for (size_t i = 0; i < obj->pins.size(); ++i)
+    obj->pins[i].setOwner(id, static_cast<int16_t>(i));
+  obj->update(); // place colliders and pins before it is indexed
+
+  if (objects_by_id.size() <= id)
+    objects_by_id.resize(id + 1);
+  objects_by_id[id] = obj;
+  objects.push_back(obj);
+  board_state.components.push_back(makeComponentRecord(*obj));
+  boardChanged();
+}
+
+void ElectronicsLevel::removeObject(size_t index) {
+  std::shared_ptr<ElectronicComponent> obj = objects[index];
+  auto &pins = obj->pins;
+
+  // All of its wires go, also those to parts that aren't live
+  ensureChunks();
+  chunks.forEachWireOf(obj->id, [&](uint32_t wire) {
+    board_state.connections.set(wire, ConnectionRecord{});
+  });
+
+  auto it = std::remove_if(connections.begin(), connections.end(),
+                           [&](const Connection &c) {
+                             for (auto &p : pins)
+                               if (c.getPin(0) == &p || c.getPin(1) == &p)
+                                 return true;
+                             return false;
+                           });
+  connections.erase(it, connections.end());
+
+  board_state.components.set(obj->id, ComponentRecord{});
+  objects_by_id[obj->id] = nullptr;
+  objects.erase(objects.begin() + index);
+  boardChanged();
+}
+
+void ElectronicsLevel::addConnection(Pin *a, Pin *b) {
+  uint32_t id = static_cast<uint32_t>(board_state.connections.size());
+  connections.emplace_back(a, b, id);
+
+  ConnectionRecord rec;
+  rec.alive = true;
+  rec.component_a = a->getOwnerId();
+  rec.pin_a = a->getIndex();
+  rec.component_b = b->getOwnerId();
+  rec.pin_b = b->getIndex();
+  board_state.connections.push_back(rec);
+  boardChanged();
+}
+
+void ElectronicsLevel::recordObject(const ElectronicComponent &obj) {
+  board_state.components.set(obj.id, makeComponentRecord(obj));
+  boardChanged();
+}
+
+// The spatial index catches up by diffing against `indexed`
+void ElectronicsLevel::boardChanged() {
+  chunks_dirty = true;
+  ++board_generation;
+}
+
+void ElectronicsLevel::commitHistory() {
+  history.commit(board_state);
+  simulation.markDirty();
+}
+
+void ElectronicsLevel::restoreState(const BoardState &target) {
+  // Only ids whose records differ are touched; everything the two states
+  // share is skipped by the diff without being visited.
+
+  // Drop stale wires first, their pins may belong to doomed components
+  board_state.connections.diff(target.connections, [&](size_t id) {
+    if (id >= board_state.connections.size() ||
+        !board_state.connections[id].alive)
+      return;
+    connections.erase(std::remove_if(connections.begin(), connections.end(),
+                                     [&](const Connection &c) {
+                                       return c.getId() == id;
+                                     }),
+                      connections.end());
+  });
+
+  // While streaming, only parts in resident chunks are live
+  std::vector<uint32_t> created;
+  std::vector<uint32_t> replaced; // live before, made anew
+  board_state.components.diff(target.components, [&](size_t id) {
+    ComponentRecord rec = id < target.components.size()
+                              ? target.components[id]
+                              : ComponentRecord{};
+    if (objects_by_id.size() <= id)
+      objects_by_id.resize(id + 1);
+
+    bool wanted = rec.alive &&
+                  (!streaming ||
+                   resident.count(BoardChunks::keyAt(rec.position)) != 0);
+    auto &live = objects_by_id[id];
+    if (live && (!wanted || live->label != rec.label)) {
+      // Wires to it are rebuilt below or stay records only
+      connections.erase(
+          std::remove_if(connections.begin(), connections.end(),
+                         [&](const Connection &c) {
+                           return c.getPin(0)->getOwnerId() == id ||
+                                  c.getPin(1)->getOwnerId() == id;
+                         }),
+          connections.end());
+      objects.erase(std::remove(objects.begin(), objects.end(), live),
+                    objects.end());
+      live = nullptr;
+      replaced.push_back(static_cast<uint32_t>(id));
+    }
+    if (!wanted)
+      return;
+
+    if (!live) {
+      live = makeComponentFromRecord(rec, static_cast<uint32_t>(id));
+      if (!live)
+        return;
+      objects.push_back(live);
+      created.push_back(static_cast<uint32_t>(id));
+    }
+    applyRecord(*live, rec);
+  });
+
+  board_state.connections.diff(target.connections, [&](size_t id) {
+    if (id >= target.connections.size() || !target.connections[id].alive)
+      return;
+    const ConnectionRecord &rec = target.connections[id];
+    Pin *a = findPin(rec.component_a, rec.pin_a);
+    Pin *b = findPin(rec.component_b, rec.pin_b);
+    if (a && b)
+      connections.emplace_back(a, b, static_cast<uint32_t>(id));
+  });
+
+  board_state = target;
+  simulation.markDirty();
+  boardChanged();
+
+  // A part paged in or made anew by the diff may have unchanged wires to
+  // live parts, which the diff skipped
+  const std::vector<uint32_t> &relink = streaming ? created : replaced;
+  if (!relink.empty())
+    linkWiresOf(relink);
+
+  // Selection and wire placement may point at replaced objects
+  deselect();
+}
+
+void ElectronicsLevel::deselect() {
+  for (auto &o : objects) {
+    o->is_active = false;
+    o->is_dragged = false;
+  }
+  activeObject = nullptr;
+  is_placing_wire = false;
+  wireStartPin = nullptr;
+}
+
+// Chunk streaming
+
+void ElectronicsLevel::ensureChunks() {
+  if (!chunks_dirty)
+    return;
+  chunks.sync(board_state);
+  chunks_dirty = false;
+}
+
+// Creates the live wires of `component_ids` whose other end is live too
+void ElectronicsLevel::linkWiresOf(const std::vector<uint32_t> &component_ids) {
+  ensureChunks();
+  std::unordered_set<uint32_t> linked;
+  for (const Connection &c : connections)
+    linked.insert(c.getId());
+
+  for (uint32_t id : component_ids) {
+    chunks.forEachWireOf(id, [&](uint32_t wire) {
+      const ConnectionRecord &rec = board_state.connections[wire];
+      Pin *a = findPin(rec.component_a, rec.pin_a);
+      Pin *b = findPin(rec.component_b, rec.pin_b);
+      if (a && b && linked.insert(wire).second)
+        connections.emplace_back(a, b, wire);
+    });
+  }
+}
+
+void ElectronicsLevel::installChunk(
+    std::vector<std::shared_ptr<ElectronicComponent>> &live) {
+  std::vector<uint32_t> ids;
+  ids.reserve(live.size());
+  for (auto &obj : live) {
+    uint32_t id = obj->id;
+    if (objects_by_id.size() <= id)
+      objects_by_id.resize(id + 1);
+    if (objects_by_id[id])
+      continue;
+    // Current simulation results, as if it had been live all along
+    simulation.applyResults(*obj);
+    obj->update();
+    objects_by_id[id] = obj;
+    objects.push_back(std::move(obj));
+    ids.push_back(id);
+  }
+  linkWiresOf(ids);
+
+  if (spatial_dirty)
+    return;
+  for (uint32_t id : ids) {
+    indexComponent(id);
+    chunks.forEachWireOf(id, [&](uint32_t wire) { indexWire(wire); });
+  }
+}
+
+void ElectronicsLevel::pageIn(ChunkKey key) {
+  PROFILE_ZONE("pageIn");
+  resident.insert(key);
+  const BoardChunks::Chunk *chunk = chunks.find(key);
+  if (!chunk)
+    return;
+
+  std::vector<std::shared_ptr<ElectronicComponent>> live =
+      chunk_loader.load(key, *chunk, board_state);
+  installChunk(live);
+}
+
+void ElectronicsLevel::evictChunk(ChunkKey key) {
+  PROFILE_ZONE("evictChunk");
+  resident.erase(key);
+  const BoardChunks::Chunk *chunk = chunks.find(key);
+  if (!chunk)
+    return;
+  chunk_loader.pageOut(key, *chunk, board_state);
+
+  for (uint32_t id : chunk->components) {
+    if (id < objects_by_id.size())
+      objects_by_id[id] = nullptr;
+  }
+  auto gone = [&](uint32_t id) { return !objects_by_id[id]; };
+  connections.erase(
+      std::remove_if(connections.begin(), connections.end(),
+                     [&](const Connection &c) {
+                       return gone(c.getPin(0)->getOwnerId()) ||
+                              gone(c.getPin(1)->getOwnerId());
+                     }),
+      connections.end());
+  objects.erase(std::remove_if(objects.begin(), objects.end(),
+                               [&](const auto &obj) { return gone(obj->id); }),
+                objects.end());
+
+  // Its wires to other chunks stay indexed, drawn from the records now
+  if (spatial_dirty)
+    return;
+  for (uint32_t id : chunk->components)
+    indexComponent(id);
+  for (uint32_t wire : chunk->wires)
+    indexWire(wire);
+  for (uint32_t wire : chunk->cross_wires)
+    indexWire(wire);
+}
+
+// Chunks holding something the player is working with stay live. A part
+// being dragged may have left the chunk its record is filed under.
+bool ElectronicsLevel::chunkPinned(ChunkKey key,
+                                   const ElectronicComponent *dragged) const {
+  auto holds = [&](const ElectronicComponent *obj) {
+    if (!obj)
+      return false;
+    Vector2 filed = board_state.components[obj->id].position;
+    return BoardChunks::keyAt(obj->position) == key ||
+           BoardChunks::keyAt(filed) == key;
+  };
+  if (holds(activeObject.get()))
+    return true;
+  if (holds(dragged))
+    return true;
+  return wireStartPin && wireStartPin->getOwnerId() < objects_by_id.size() &&
+         holds(objects_by_id[wireStartPin->getOwnerId()].get());
+}
+
+void ElectronicsLevel::updateChunks(const ElectronicComponent *dragged) {
+  if (!streaming)
+    return;
+  PROFILE_ZONE("updateChunks");
+  ensureChunks();
+
+  // Background page-ins, unless an edit has made them stale
+  std::vector<ChunkLoader::Result> loaded;
+  chunk_loader.collect(loaded);
+  for (ChunkLoader::Result &result : loaded) {
+    if (result.generation == board_generation && !resident.count(result.key)) {
+      resident.insert(result.key);
+      installChunk(result.objects);
+    }
+  }
+
+  Rectangle shown = visibleWorldRect();
+
+  // About to show: can't wait for the loader
+  BoardChunks::forEachKeyIn(grownBy(shown, SYNC_MARGIN), [&](ChunkKey key) {
+    if (!resident.count(key))
+      pageIn(key);
+  });
+  BoardChunks::forEachKeyIn(grownBy(shown, PREFETCH_MARGIN), [&](ChunkKey key) {
+    if (resident.count(key) || chunk_loader.pending(key))
+      return;
+    const BoardChunks::Chunk *chunk = chunks.find(key);
+    if (!chunk)
+      resident.insert(key); // nothing to load
+    else
+      chunk_loader.request(key, board_generation, *chunk, board_state);
+  });
+
+  // Far chunks go back to being records only
+  Rectangle keep = grownBy(shown, EVICT_MARGIN);
+  std::vector<ChunkKey> far;
+  for (ChunkKey key : resident) {
+    if (!CheckCollisionRecs(BoardChunks::bounds(key), keep) &&
+        !chunkPinned(key, dragged))
+      far.push_back(key);
+  }
+  for (ChunkKey key : far)
+    evictChunk(key);
+}
+
 // Update
+bool ElectronicsLevel::overPanel() {
+  return CheckCollisionPointRec(InputManager::GetMousePosition(),
+                                panelLayout().bounds);
+}
+
+Rectangle ElectronicsLevel::visibleWorldRect() const {
+  Vector2 a = GetScreenToWorld2D({0.0f, 0.0f}, camera);
+  Vector2 b = GetScreenToWorld2D({view.width, view.height}, camera);
+  return {a.x, a.y, b.x - a.x, b.y - a.y};
+}
+
+void ElectronicsLevel::setView(const ViewSize &size) {
+  // Bounds in the spatial index carry margins in screen units
+  if (size.scale != view.scale)
+    spatial_dirty = true;
+  view = size;
+}
+
+void ElectronicsLevel::updateCamera() {
+  if (InputManager::IsKeyPressed(KEY_HOME)) {
+    camera = DEFAULT_CAMERA;
+    return;
+  }
+
+  // Pan while the right or middle button is held
+  if (InputManager::IsMouseButtonDown(MOUSE_BUTTON_RIGHT) ||
+      InputManager::IsMouseButtonDown(MOUSE_BUTTON_MIDDLE)) {
+    Vector2 delta = InputManager::GetMouseDelta();
+    camera.target.x -= delta.x / camera.zoom;
+    camera.target.y -= delta.y / camera.zoom;
+  }
+
+  // Zoom about the cursor, keeping the point under it in place
+  float wheel = InputManager::GetMouseWheelMove();
+  if (wheel != 0.0f && !overPanel()) {
+    Vector2 mouse = InputManager::GetMousePosition();
+    camera.target = GetScreenToWorld2D(mouse, camera);
+    camera.offset = mouse;
+    camera.zoom = std::clamp(camera.zoom * std::exp(ZOOM_STEP * wheel),
+                             MIN_ZOOM, MAX_ZOOM);
+  }
+}
+
 void ElectronicsLevel::updateLevel() {
+  PROFILE_ZONE("updateLevel");
+  updateSpatialIndex();
   Vector2 mouse = InputManager::GetCachedMousePos();
-  bool mouseReleased = IsMouseButtonReleased(MOUSE_BUTTON_LEFT);
+  bool mouseReleased = InputManager::IsMouseButtonReleased(MOUSE_BUTTON_LEFT);
+
+  // Undo / redo
+  bool ctrlDown = InputManager::IsKeyDown(KEY_LEFT_CONTROL) ||
+                  InputManager::IsKeyDown(KEY_RIGHT_CONTROL);
+  bool shiftDown = InputManager::IsKeyDown(KEY_LEFT_SHIFT) ||
+                   InputManager::IsKeyDown(KEY_RIGHT_SHIFT);
+  if (ctrlDown && InputManager::IsKeyPressed(KEY_Z)) {
+    shiftDown ? redo() : undo();
+    return;
+  }
+  if (ctrlDown && InputManager::IsKeyPressed(KEY_Y)) {
+    redo();
+    return;
+  }
+
+  // Remember what is being dragged so its final position can be recorded
+  std::shared_ptr<ElectronicComponent> dragged;
+  if (auto *sel = dynamic_cast<ElectronicComponent *>(
+          InputManager::GetActiveSelection())) {
+    if (sel->id < objects_by_id.size())
+      dragged = objects_by_id[sel->id];
+  }
+
+  // Parts under the cursor, in id order. The panel covers the board, so
+  // clicks on it don't reach the parts beneath.
+  bool mousePressed =
+      InputManager::IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && !overPanel();
+  ArenaVector<ElectronicComponent *> hovered{
+      ArenaAllocator<ElectronicComponent *>(frameArena())};
+  if (mousePressed) {
+    component_index.query({mouse.x, mouse.y, 0.0f, 0.0f}, [&](uint32_t id) {
+      hovered.push_back(objects_by_id[id].get());
+    });
+    std::sort(hovered.begin(), hovered.end(),
+              [](ElectronicComponent *a, ElectronicComponent *b) {
+                return a->id < b->id;
+              });
+  }
 
   // click handling
-  if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-    for (auto &obj : objects) {
-      for (auto &pin : obj->pins) {
-        if (pin.isHovered()) {
-
-          if (!is_placing_wire) {
-            wireStartPin = &pin;
-            is_placing_wire = true;
-          } else if (wireStartPin && &pin != wireStartPin) {
-            if (!hasConnection(wireStartPin, &pin))
-              connections.emplace_back(wireStartPin, &pin);
-
-            wireStartPin = nullptr;
-            is_placing_wire = false;
-          }
-          return;
-        }
-      }
+  if (mousePressed) {
+    ArenaVector<Pin *> pins{ArenaAllocator<Pin *>(frameArena())};
+    for (ElectronicComponent *obj : hovered) {
+      for (auto &pin : obj->pins)
+        pins.push_back(&pin);
     }
+    size_t hit = firstContaining(
+        pins.size(), [&](size_t i) { return pins[i]->getCollider(); }, mouse);
+    if (hit < pins.size()) {
+      Pin *pin = pins[hit];
+      if (!is_placing_wire) {
+        wireStartPin = pin;
+        is_placing_wire = true;
+      } else if (wireStartPin && pin != wireStartPin) {
+        if (!hasConnection(wireStartPin, pin)) {
+          addConnection(wireStartPin, pin);
+          commitHistory();
+        }
 
-    // object selection
-    bool hit = false;
-    for (auto &obj : objects) {
-      if (CheckCollisionPointRec(mouse, obj->getCollider())) {
-        for (auto &o : objects)
-          o->is_active = false;
-        obj->is_active = true;
-        activeObject = obj;
-        hit = true;
-        break;
+        wireStartPin = nullptr;
+        is_placing_wire = false;
       }
+      return;
     }
 
-    if (!hit) {
-      for (auto &o : objects)
-        o->is_active = false;
-      activeObject = nullptr;
+    // object selection; only the selected part is ever active
+    if (activeObject)
+      activeObject->is_active = false;
+    activeObject = nullptr;
+    hit = firstContaining(
+        hovered.size(), [&](size_t i) { return hovered[i]->getCollider(); },
+        mouse);
+    if (hit < hovered.size()) {
+      hovered[hit]->is_active = true;
+      activeObject = objects_by_id[hovered[hit]->id];
     }
   }
 
-  // update objects
-  for (int i = 0; i < objects.size(); ++i) {
-    InputManager::updateDragInputs(*objects[i]);
-    objects[i]->update();
-
-    if (objects[i]->is_active && IsKeyPressed(KEY_DELETE)) {
-
-      auto &pins = objects[i]->pins;
-      connections.erase(std::remove_if(connections.begin(), connections.end(),
-                                       [&](const Connection &c) {
-                                         for (auto &p : pins)
-                                           if (c.getPin(0) == &p ||
-                                               c.getPin(1) == &p)
-                                             return true;
-                                         return false;
-                                       }),
-                        connections.end());
+  // update objects: a drag can only start on a part under the cursor, and
+  // only the dragged part moves
+  for (ElectronicComponent *obj : hovered)
+    InputManager::updateDragInputs(*obj);
+  if (dragged) {
+    InputManager::updateDragInputs(*dragged);
+    dragged->update();
+    updateSpatialEntry(*dragged);
+  }
 
-      objects.erase(objects.begin() + i);
-      activeObject = nullptr;
-      break;
-    }
+  if (activeObject && InputManager::IsKeyPressed(KEY_DELETE)) {
+    if (activeObject == dragged)
+      dragged = nullptr;
+    removeObject(std::find(objects.begin(), objects.end(), activeObject) -
+                 objects.begin());
+    commitHistory();
+    activeObject = nullptr;
   }
 
   if (mouseReleased) {
     float snapDist = SNAP_RADIUS_PX * safeScreenScale;
+    bool changed = false;
 
-    for (auto &obj : objects) {
-      for (auto &pin : obj->pins) {
-        Pin *p = &pin;
-        Pin *target = findSnapTarget(p, snapDist);
-        if (!target)
-          continue;
+    if (dragged && !(makeComponentRecord(*dragged) ==
+                     board_state.components[dragged->id])) {
+      recordObject(*dragged);
+      changed = true;
+    }
 
-        if (!hasConnection(p, target)) {
-          connections.emplace_back(p, target);
-        }
+    ArenaVector<SnapPair> snaps{ArenaAllocator<SnapPair>(frameArena())};
+    findSnapTargets(snapDist, snaps);
+    for (const SnapPair &snap : snaps) {
+      if (!hasConnection(snap.pin, snap.target)) {
+        addConnection(snap.pin, snap.target);
+        changed = true;
       }
     }
+
+    // A drag and the wires it snapped form a single undo step
+    if (changed)
+      commitHistory();
+  }
+}
+
+void ElectronicsLevel::updateSimulation() {
+  if (InputManager::IsKeyPressed(KEY_F5) &&
+      solverTelemetry().exportJson(SOLVER_TELEMETRY_PATH))
+    LOG_INFO("Solver telemetry written to %s", SOLVER_TELEMETRY_PATH);
+
+  if (solveBoard())
+    recordSolverStats();
+}
+
+bool ElectronicsLevel::solveBoard() {
+  if (!simulation.isDirty())
+    return false;
+
+  simulation.build(board_state);
+  simulation.solve();
+
+  // Sprites follow the new powered and damaged states
+  for (auto &obj : objects) {
+    simulation.applyResults(*obj);
+    obj->update();
   }
+  return true;
+}
+
+void ElectronicsLevel::prepare(const ViewSize &size) {
+  PROFILE_ZONE("prepare");
+  setView(size);
+  updateChunks(nullptr);
+  solveBoard();
+  updateSpatialIndex();
+}
+
+void ElectronicsLevel::recordSolverStats() {
+  simulation.estimateCondition();
+  SolverTelemetry &telemetry = solverTelemetry();
+  telemetry.record(simulation.lastSolveStats());
+  const SolveStats &s = *telemetry.latest();
+
+  char line[3][96];
+  snprintf(line[0], sizeof(line[0]), "solve #%llu: %zu/%zu islands, %.2f ms",
+           static_cast<unsigned long long>(s.sequence), s.islands_solved,
+           s.islands, s.build_ms + s.total_ms);
+  snprintf(line[1], sizeof(line[1]), "ord %.2f sym %.2f num %.2f sub %.2f",
+           s.ordering_ms, s.symbolic_ms, s.numeric_ms, s.solve_ms);
+  snprintf(line[2], sizeof(line[2]), "nnz %zu>%zu it %d/%d cond %.0e",
+           s.matrix_nonzeros, s.factor_nonzeros, s.iterations,
+           s.krylov_iterations, s.condition);
+  Profiler::setOverlayNotes({line[0], line[1], line[2]});
 }
 
 // Draw
+
+// Sorts `ids` by key(id), a unique index below `count`. Once the ids are a
+// good share of `count`, placing them in slots beats a comparison sort.
+template <typename Key>
+static void sortByKey(ArenaVector<uint32_t> &ids, size_t count, Key key) {
+  if (ids.size() * 8 < count) {
+    std::sort(ids.begin(), ids.end(),
+              [&](uint32_t a, uint32_t b) { return key(a) < key(b); });
+    return;
+  }
+  ArenaVector<uint32_t> slots(count, UINT32_MAX,
+                              ArenaAllocator<uint32_t>(frameArena()));
+  for (uint32_t id : ids)
+    slots[key(id)] = id;
+  size_t n = 0;
+  for (uint32_t id : slots) {
+    if (id != UINT32_MAX)
+      ids[n++] = id;
+  }
+}
+
+static DrawDetail detailFor(const ElectronicComponent &obj, float zoom) {
+  Rectangle c = obj.getCollider();
+  float px = std::min(c.width, c.height) * zoom;
+  if (px >= FULL_DETAIL_MIN_PX)
+    return DrawDetail::Full;
+  return px >= IMPOSTOR_MIN_PX ? DrawDetail::Impostor : DrawDetail::Block;
+}
+
 void ElectronicsLevel::drawLevel() {
+  PROFILE_ZONE("drawLevel");
+  updateSpatialIndex();
   BeginDrawing();
   ClearBackground(GRAY);
+  BeginMode2D(camera);
 
-  for (auto &obj : objects)
-    obj->draw();
+  // Only what is in view, in id order
+  Rectangle shown = visibleWorldRect();
+  ArenaVector<uint32_t> visible{ArenaAllocator<uint32_t>(frameArena())};
+  component_index.query(shown, [&](uint32_t id) { visible.push_back(id); });
+  sortByKey(visible, objects_by_id.size(), [](uint32_t id) { return id; });
+  // Flat blocks first: they are drawn from raylib's shape texture and would
+  // split the impostor atlas batch if interleaved with it
+  for (uint32_t id : visible) {
+    ElectronicComponent &obj = *objects_by_id[id];
+    if (detailFor(obj, camera.zoom) == DrawDetail::Block)
+      obj.drawAtDetail(DrawDetail::Block);
+  }
+  for (uint32_t id : visible) {
+    ElectronicComponent &obj = *objects_by_id[id];
+    DrawDetail detail = detailFor(obj, camera.zoom);
+    if (detail != DrawDetail::Block)
+      obj.drawAtDetail(detail);
+  }
 
-  for (const Connection &c : connections)
-    c.draw();
+  DrawDetail wireDetail =
+      8.0f * safeScreenScale * camera.zoom >= WIRE_OUTLINE_MIN_PX
+          ? DrawDetail::Full
+          : DrawDetail::Impostor;
+  visible.clear();
+  auto addWire = [&](uint32_t id) { visible.push_back(id); };
+  wire_index.query(shown, addWire);
+  cross_wire_index.query(shown, addWire);
+  sortByKey(visible, board_state.connections.size(),
+            [](uint32_t id) { return id; });
+  for (uint32_t id : visible) {
+    const WireShape &shape = wire_shapes.find(id)->second;
+    Connection::drawWire(shape.a, shape.b, shape.color, wireDetail);
+  }
 
   // wire preview
   if (is_placing_wire && wireStartPin) {
@@ -183,126 +1190,427 @@ void ElectronicsLevel::drawLevel() {
     DrawLineEx(a, b, 8.0f * safeScreenScale, BLACK);
     DrawLineEx(a, b, 6.0f * safeScreenScale, col);
   }
+  EndMode2D();
 
   drawComponentsPanel();
+  TextRenderer::Flush();
+  Profiler::drawOverlay();
   EndDrawing();
 }
 
-void ElectronicsLevel::drawComponentsPanel() {
+// Parts offered by the panel, in button order
+static const struct {
+  const char *name;
+  ComponentLabel label;
+} PANEL_PARTS[] = {
+    {"Battery", ComponentLabel::Battery},
+    {"Led", ComponentLabel::Led},
+    {"Resistor", ComponentLabel::Resistor},
+};
+static constexpr int PANEL_PART_COUNT =
+    sizeof(PANEL_PARTS) / sizeof(PANEL_PARTS[0]);
+
+const ElectronicsLevel::PanelLayout &ElectronicsLevel::panelLayout() {
+  static_assert(sizeof(PanelLayout::buttons) / sizeof(Rectangle) ==
+                    PANEL_PART_COUNT,
+                "one panel button per part");
+  if (!panel_layout_stamp.refresh())
+    return panel_layout;
+
+  PanelLayout &layout = panel_layout;
   float panelWidth = 450.0f * safeScreenScale;
-  Rectangle panelBounds = {
+  layout.bounds = {
       globalSettings.screenWidth - panelWidth,
       0.0f,
       panelWidth,
       static_cast<float>(globalSettings.screenHeight),
   };
 
-  drawUIPanel(panelBounds);
-
   float margin = 22 * safeScreenScale;
   float btnSize = 100 * safeScreenScale;
   float spacing = 20 * safeScreenScale;
   int columns = 2;
 
-  std::vector<std::string> componentNames = {"Battery", "Led", "Resistor"};
-  int totalButtons = componentNames.size();
-
   float totalGridWidth = columns * btnSize + (columns - 1) * spacing;
-  float startX = panelBounds.x + (panelBounds.width - totalGridWidth) / 2.0f;
-  float startY = panelBounds.y + margin;
+  float startX =
+      layout.bounds.x + (layout.bounds.width - totalGridWidth) / 2.0f;
+  float startY = layout.bounds.y + margin;
 
-  // Draw buttons
-  for (int i = 0; i < totalButtons; ++i) {
+  for (int i = 0; i < PANEL_PART_COUNT; ++i) {
     int col = i % columns;
     int row = i / columns;
-
-    Rectangle btnRect = {
+    layout.buttons[i] = {
         startX + col * (btnSize + spacing),
         startY + row * (btnSize + spacing),
         btnSize,
         btnSize,
     };
+  }
+  layout.buttonOutline = 8.0f * safeScreenScale;
+  layout.buttonFontSize = static_cast<int>(18 * safeScreenScale);
 
-    drawUIRect(8.0f * safeScreenScale, 0.2f, btnRect);
-    drawUITextCentered(static_cast<int>(18 * safeScreenScale), btnRect,
-                       componentNames[i], DARKGRAY);
+  layout.wireHint = {layout.bounds.x + margin,
+                     globalSettings.screenHeight - margin};
 
-    if (CheckCollisionPointRec(GetMousePosition(), btnRect) &&
-        IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+  // Divider
+  float dividerY = layout.bounds.y + layout.bounds.height / 2.0f;
+  layout.dividerStart = {layout.bounds.x + margin - 5.0f, dividerY};
+  layout.dividerEnd = {layout.bounds.x + layout.bounds.width - margin + 5.0f,
+                       dividerY};
 
-      const std::string &name = componentNames[i];
+  // Inspector
+  float lineSpacing = 36.0f * safeScreenScale;
+  for (int i = 0; i < INSPECTOR_MAX_LINES; ++i)
+    layout.inspectorLines[i] = {startX - 20.0f,
+                                dividerY + margin + i * lineSpacing};
+  layout.titleFontSize = static_cast<int>(28.0f * safeScreenScale);
+  layout.valueFontSize = static_cast<int>(24.0f * safeScreenScale);
 
-      if (name == "Battery") {
-        objects.push_back(std::make_shared<Battery>(Vector2{100, 100}));
-      } else if (name == "Led") {
-        objects.push_back(std::make_shared<Led>(Vector2{100, 100}));
-      } else if (name == "Resistor") {
-        objects.push_back(std::make_shared<Resistor>(Vector2{100, 100}));
-      }
+  layout.resetButton = {layout.bounds.x + layout.bounds.width / 2.0f,
+                        layout.bounds.y + layout.bounds.height -
+                            160.0f * safeScreenScale,
+                        160 * safeScreenScale, 40 * safeScreenScale};
+
+  // Sweep button under the inspector, its plot down to the reset button
+  float gap = 10.0f * safeScreenScale;
+  layout.sweepButton = {
+      startX - 20.0f,
+      layout.inspectorLines[INSPECTOR_MAX_LINES - 1].y + lineSpacing,
+      200 * safeScreenScale, 36 * safeScreenScale};
+  layout.probeButton = {
+      layout.sweepButton.x + layout.sweepButton.width + gap,
+      layout.sweepButton.y, 120 * safeScreenScale, layout.sweepButton.height};
+  float plotTop = layout.sweepButton.y + layout.sweepButton.height + gap;
+  layout.sweepPlot = {
+      layout.bounds.x + margin, plotTop, layout.bounds.width - 2 * margin,
+      std::max(layout.resetButton.y - gap - plotTop, 0.0f)};
+  return layout;
+}
+
+void ElectronicsLevel::updateComponentsPanel() {
+  const PanelLayout &layout = panelLayout();
+  Vector2 mouse = InputManager::GetMousePosition();
+  bool clicked = InputManager::IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+
+  for (int i = 0; i < PANEL_PART_COUNT; ++i) {
+    if (clicked && CheckCollisionPointRec(mouse, layout.buttons[i])) {
+      // Near the view's corner, wherever the board is scrolled to
+      addObject(makeComponent(PANEL_PARTS[i].label,
+                              GetScreenToWorld2D({100, 100}, camera)));
+      commitHistory();
     }
   }
 
   // Wire Cancellation
-  if (is_placing_wire) {
-    if (IsKeyPressed(KEY_ESCAPE)) {
-      is_placing_wire = false;
-      wireStartObject = nullptr;
-    }
-    DrawText("Press ESC to cancel wire", panelBounds.x + margin,
-             globalSettings.screenHeight - margin, 20, DARKGRAY);
+  if (is_placing_wire && InputManager::IsKeyPressed(KEY_ESCAPE)) {
+    is_placing_wire = false;
+    wireStartObject = nullptr;
   }
 
-  // Divider
-  float dividerY = panelBounds.y + panelBounds.height / 2.0f;
-  DrawLineEx(
-      Vector2{panelBounds.x + margin - 5.0f, dividerY},
-      Vector2{panelBounds.x + panelBounds.width - margin + 5.0f, dividerY},
-      5.0f, Color{180, 180, 200, 255});
+  if (clicked && activeObject && sweepable(*activeObject) &&
+      CheckCollisionPointRec(mouse, layout.sweepButton))
+    startSweep(*activeObject);
 
-  // Inspector
-  float inspectorStartY = dividerY + margin;
-  float labelFontSize = 28.0f * safeScreenScale;
-  float valueFontSize = 24.0f * safeScreenScale;
-  float lineSpacing = 36.0f * safeScreenScale;
-  float textX = startX - 20.0f;
+  if (clicked && activeObject &&
+      CheckCollisionPointRec(mouse, layout.probeButton))
+    toggleProbe(*activeObject);
+
+  // The wheel over a probe plot zooms its time axis, not the board
+  float wheel = InputManager::GetMouseWheelMove();
+  if (wheel != 0.0f && activeObject && probeOf(activeObject->id) &&
+      CheckCollisionPointRec(mouse, layout.sweepPlot))
+    probe_window = wheel > 0.0f
+                       ? std::max(probe_window / 2, PROBE_MIN_WINDOW)
+                       : std::min(probe_window * 2, ProbeTrace::HISTORY);
+
+  if (clicked && CheckCollisionPointRec(mouse, layout.resetButton))
+    resetLevel();
+}
 
-  std::vector<std::string> lines;
+bool ElectronicsLevel::sweepable(const ElectronicComponent &obj) const {
+  return obj.label == ComponentLabel::Battery ||
+         obj.label == ComponentLabel::Resistor;
+}
+
+void ElectronicsLevel::startSweep(const ElectronicComponent &obj) {
+  updateSimulation(); // the sweep starts from the built simulation
+
+  // From nothing to twice the part's value; resistors stop short of a
+  // short circuit
+  const ComponentRecord &rec = board_state.components[obj.id];
+  ParameterSweep::Spec spec;
+  spec.component_id = obj.id;
+  spec.points = SWEEP_POINTS;
+  if (obj.label == ComponentLabel::Battery) {
+    spec.to = 2.0f * std::max(rec.voltage, 0.5f);
+  } else {
+    float resistance = std::max(rec.resistance, 0.01f);
+    spec.from = 0.1f * resistance;
+    spec.to = 2.0f * resistance;
+  }
+
+  // The part itself, then the first LEDs it can drive
+  spec.probes.push_back(obj.id);
+  int32_t island = simulation.islandOf(obj.id);
+  for (uint32_t id = 0; id < board_state.components.size() &&
+                        spec.probes.size() < ParameterSweep::MAX_PROBES;
+       ++id) {
+    const ComponentRecord &part = board_state.components[id];
+    if (part.alive && part.label == ComponentLabel::Led && island >= 0 &&
+        simulation.islandOf(id) == island)
+      spec.probes.push_back(id);
+  }
+
+  sweep.start(simulation, std::move(spec));
+  sweep_generation = board_generation;
+}
+
+void ElectronicsLevel::drawComponentsPanel() {
+  PROFILE_ZONE("drawComponentsPanel");
+  const PanelLayout &layout = panelLayout();
+
+  drawUIPanel(layout.bounds);
+
+  // Draw buttons
+  for (int i = 0; i < PANEL_PART_COUNT; ++i) {
+    drawUIRect(layout.buttonOutline, 0.2f, layout.buttons[i]);
+    drawUITextCentered(layout.buttonFontSize, layout.buttons[i],
+                       PANEL_PARTS[i].name, DARKGRAY);
+  }
+
+  if (is_placing_wire) {
+    TextRenderer::DrawLabel("Press ESC to cancel wire", layout.wireHint, 20,
+                            DARKGRAY);
+  }
+
+  DrawLineEx(layout.dividerStart, layout.dividerEnd, 5.0f,
+             Color{180, 180, 200, 255});
+
+  // Inspector; per-frame text lives in the frame arena, not on the heap
+  FrameArena &arena = frameArena();
+  ArenaVector<const char *> lines{ArenaAllocator<const char *>(arena)};
+  lines.reserve(INSPECTOR_MAX_LINES);
   lines.push_back("Inspector");
 
   if (activeObject) {
-    lines.push_back("Position: (" +
-                    std::to_string((int)activeObject->position.x) + ", " +
-                    std::to_string((int)activeObject->position.y) + ")");
+    lines.push_back(arena.format("Position: (%d, %d)",
+                                 (int)activeObject->position.x,
+                                 (int)activeObject->position.y));
 
     if (activeObject->label == ComponentLabel::Battery) {
       lines.push_back("TYPE: Battery");
-      lines.push_back("Volt: 1.5V");
+      lines.push_back(arena.format("Volt: %.1fV", activeObject->voltage));
+    } else if (activeObject->label == ComponentLabel::Resistor) {
+      lines.push_back("Type: Resistor");
+      lines.push_back(
+          arena.format("Resistance: %.2f kOhm", activeObject->resistance));
     } else if (activeObject->label == ComponentLabel::Led) {
       lines.push_back("Type: LED");
-      lines.push_back(std::string("State: ") +
-                      (activeObject->powered
-                           ? "ON"
-                           : (activeObject->damaged ? "DAMAGED" : "OFF")));
+      const char *state = activeObject->powered   ? "ON"
+                          : activeObject->damaged ? "DAMAGED"
+                          : activeObject->battery_connected
+                              ? "OFF"
+                              : "OFF, open circuit";
+      lines.push_back(arena.format("State: %s", state));
     } else {
       lines.push_back("Type: Unknown");
     }
+  } else if (const SolveStats *solve = solverTelemetry().latest()) {
+    // Nothing selected: the board's last solve
+    lines.push_back(arena.format("Solve: %.2f ms, %zu nodes",
+                                 solve->build_ms + solve->total_ms,
+                                 solve->nodes));
+    lines.push_back(arena.format("Fill: %zu -> %zu nnz",
+                                 solve->matrix_nonzeros,
+                                 solve->factor_nonzeros));
+    lines.push_back(arena.format("Cond %.0e, resid %.0e", solve->condition,
+                                 solve->residual));
+  }
+
+  for (size_t i = 0; i < lines.size() && i < INSPECTOR_MAX_LINES; ++i) {
+    TextRenderer::Draw(lines[i], layout.inspectorLines[i],
+                       (i == 0 ? layout.titleFontSize : layout.valueFontSize),
+                       DARKGRAY);
   }
 
-  for (size_t i = 0; i < lines.size(); ++i) {
-    DrawText(lines[i].c_str(), textX, inspectorStartY + i * lineSpacing,
-             (i == 0 ? labelFontSize : valueFontSize), DARKGRAY);
+  bool swept = false;
+  if (activeObject && sweepable(*activeObject)) {
+    bool battery = activeObject->label == ComponentLabel::Battery;
+    const char *label = sweep.running()
+                            ? "Sweeping..."
+                            : (battery ? "Sweep voltage" : "Sweep resistance");
+    drawUIRect(4.0f * safeScreenScale, 0.2f, layout.sweepButton);
+    drawUITextCentered(layout.buttonFontSize, layout.sweepButton, label,
+                       DARKGRAY);
+    swept = drawSweepPlot(layout.sweepPlot);
+  }
+
+  if (activeObject) {
+    ProbeTrace *probe = probeOf(activeObject->id);
+    drawUIRect(4.0f * safeScreenScale, 0.2f, layout.probeButton);
+    drawUITextCentered(layout.buttonFontSize, layout.probeButton,
+                       probe ? "Unprobe" : "Probe", DARKGRAY);
+    if (probe && !swept)
+      drawProbePlot(layout.sweepPlot, *probe);
   }
 
   // Reset Button
-  Rectangle resetBtn = {panelBounds.x + panelBounds.width / 2.0f,
-                        panelBounds.y + panelBounds.height -
-                            160.0f * safeScreenScale,
-                        160 * safeScreenScale, 40 * safeScreenScale};
+  const Rectangle &resetBtn = layout.resetButton;
   DrawRectangleRec(resetBtn, RED);
-  DrawText("Reset Level", resetBtn.x + 20, resetBtn.y + 10, 20, WHITE);
+  TextRenderer::DrawLabel("Reset Level", {resetBtn.x + 20, resetBtn.y + 10}, 20,
+                          WHITE);
+}
 
-  if (CheckCollisionPointRec(GetMousePosition(), resetBtn) &&
-      IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-    resetLevel();
+// Current through each probe against the swept value: the selected part
+// first, then the LEDs on its circuit
+bool ElectronicsLevel::drawSweepPlot(const Rectangle &area) {
+  static const Color PROBE_COLORS[ParameterSweep::MAX_PROBES] = {
+      BLUE, RED, ORANGE, DARKGREEN};
+
+  const ParameterSweep::Result *result = sweep.result();
+  if (!result || sweep.running() || area.height < 40.0f * safeScreenScale ||
+      result->spec.component_id != activeObject->id ||
+      sweep_generation != board_generation)
+    return false;
+
+  const ParameterSweep::Spec &spec = result->spec;
+  int fontSize = static_cast<int>(18 * safeScreenScale);
+  float textHeight = 22.0f * safeScreenScale;
+  Rectangle plot = {area.x, area.y, area.width, area.height - textHeight};
+  DrawRectangleRec(plot, Color{245, 245, 250, 255});
+  DrawRectangleLinesEx(plot, 1.0f, GRAY);
+
+  float lo = result->min_current;
+  float hi = std::max(result->max_current, lo + 1e-6f);
+  auto toScreen = [&](size_t i, float current) {
+    float t = result->values.size() > 1
+                  ? static_cast<float>(i) / (result->values.size() - 1)
+                  : 0.0f;
+    return Vector2{plot.x + t * plot.width,
+                   plot.y + (1.0f - (current - lo) / (hi - lo)) * plot.height};
+  };
+  if (lo < 0.0f)
+    DrawLineV(toScreen(0, 0.0f), toScreen(result->values.size() - 1, 0.0f),
+              LIGHTGRAY);
+
+  for (size_t p = 0; p < result->currents.size(); ++p) {
+    const std::vector<float> &curve = result->currents[p];
+    for (size_t i = 1; i < curve.size(); ++i)
+      DrawLineEx(toScreen(i - 1, curve[i - 1]), toScreen(i, curve[i]),
+                 2.0f * safeScreenScale, PROBE_COLORS[p]);
+  }
+
+  bool battery = activeObject->label == ComponentLabel::Battery;
+  const char *axis = frameArena().format(
+      "%.2f-%.2f %s, peak %.1f mA", spec.from, spec.to,
+      battery ? "V" : "kOhm", 1000.0f * std::max(hi, -lo));
+  TextRenderer::Draw(axis, {plot.x, plot.y + plot.height + 4.0f}, fontSize,
+                     DARKGRAY);
+  return true;
+}
+
+ProbeTrace *ElectronicsLevel::probeOf(uint32_t component_id) {
+  for (ProbeTrace &probe : probes)
+    if (probe.componentId() == component_id)
+      return &probe;
+  return nullptr;
+}
+
+void ElectronicsLevel::toggleProbe(const ElectronicComponent &obj) {
+  for (size_t i = 0; i < probes.size(); ++i) {
+    if (probes[i].componentId() == obj.id) {
+      probes.erase(probes.begin() + i);
+      return;
+    }
+  }
+  if (probes.size() == MAX_PROBES)
+    probes.erase(probes.begin());
+  probes.emplace_back(obj.id);
+}
+
+// Once per frame, after the simulation. Probes of deleted parts go; parts
+// paged out by streaming have no pins to read and skip the frame.
+void ElectronicsLevel::sampleProbes() {
+  for (size_t i = 0; i < probes.size();) {
+    uint32_t id = probes[i].componentId();
+    if (id >= board_state.components.size() ||
+        !board_state.components[id].alive) {
+      probes.erase(probes.begin() + i);
+      continue;
+    }
+    const ElectronicComponent *obj =
+        id < objects_by_id.size() ? objects_by_id[id].get() : nullptr;
+    if (obj && obj->pins.size() >= 2) {
+      const Pin &a = obj->pins[0];
+      const Pin &b = obj->pins[1];
+      probes[i].record(a.getVoltage() - b.getVoltage(), a.getCurrent());
+    }
+    ++i;
+  }
+}
+
+// Voltage across the part and current through it over the last
+// probe_window frames, each scaled to its own range. Every pixel column
+// spans the min to the max of its frames, joined to the column before.
+void ElectronicsLevel::drawProbePlot(const Rectangle &area,
+                                     const ProbeTrace &probe) {
+  static const Color CHANNEL_COLORS[ProbeTrace::CHANNELS] = {BLUE, RED};
+
+  uint64_t window = std::min(probe_window, probe.sampleCount());
+  if (window == 0 || area.height < 40.0f * safeScreenScale)
+    return;
+
+  int fontSize = static_cast<int>(18 * safeScreenScale);
+  float textHeight = 22.0f * safeScreenScale;
+  Rectangle plot = {area.x, area.y, area.width, area.height - textHeight};
+  DrawRectangleRec(plot, Color{245, 245, 250, 255});
+  DrawRectangleLinesEx(plot, 1.0f, GRAY);
+
+  // A probe younger than the window fills the plot from the right
+  size_t width = std::max<size_t>(static_cast<size_t>(plot.width), 1);
+  size_t columns = std::max<size_t>(width * window / probe_window, 1);
+  float left = plot.x + (width - columns);
+  auto *spans = static_cast<ProbeTrace::Span *>(frameArena().allocate(
+      columns * sizeof(ProbeTrace::Span), alignof(ProbeTrace::Span)));
+
+  float lo[ProbeTrace::CHANNELS] = {};
+  float hi[ProbeTrace::CHANNELS] = {};
+  for (size_t ch = 0; ch < ProbeTrace::CHANNELS; ++ch) {
+    probe.envelope(static_cast<ProbeTrace::Channel>(ch), window, spans,
+                   columns);
+    bool any = false;
+    for (size_t c = 0; c < columns; ++c) {
+      if (spans[c].min > spans[c].max)
+        continue;
+      lo[ch] = any ? std::min(lo[ch], spans[c].min) : spans[c].min;
+      hi[ch] = any ? std::max(hi[ch], spans[c].max) : spans[c].max;
+      any = true;
+    }
+    if (!any)
+      continue;
+
+    float range = std::max(hi[ch] - lo[ch], 1e-6f);
+    auto toY = [&](float value) {
+      return plot.y + 2.0f +
+             (1.0f - (value - lo[ch]) / range) * (plot.height - 4.0f);
+    };
+    const ProbeTrace::Span *prev = nullptr;
+    for (size_t c = 0; c < columns; ++c) {
+      const ProbeTrace::Span &span = spans[c];
+      if (span.min > span.max)
+        continue;
+      float top = prev ? std::max(span.max, prev->min) : span.max;
+      float bottom = prev ? std::min(span.min, prev->max) : span.min;
+      float x = left + c + 0.5f;
+      DrawLineV({x, toY(top)}, {x, toY(bottom) + 1.0f}, CHANNEL_COLORS[ch]);
+      prev = &span;
+    }
   }
+
+  double seconds = (window - 1) * PROBE_FRAME_SECONDS;
+  const char *axis = frameArena().format(
+      "%.1f s: %.2f..%.2f V, %.1f..%.1f mA", seconds, lo[0], hi[0],
+      1000.0f * lo[1], 1000.0f * hi[1]);
+  TextRenderer::Draw(axis, {plot.x, plot.y + plot.height + 4.0f}, fontSize,
+                     DARKGRAY);
 }
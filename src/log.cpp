@@ -0,0 +1,266 @@
+#include "../include/log.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace Log {
+
+static constexpr uint64_t QUEUE_CAPACITY = 1024; // a power of two
+static constexpr size_t MESSAGE_BYTES = 232;     // longer ones are cut
+static constexpr size_t LINE_BYTES = MESSAGE_BYTES + 128;
+static constexpr size_t BATCH_BYTES = 64 * 1024;
+static constexpr auto WRITE_INTERVAL = std::chrono::milliseconds(20);
+
+static const auto process_start = std::chrono::steady_clock::now();
+
+static uint64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - process_start)
+      .count();
+}
+
+namespace {
+
+struct Slot {
+  // Bounded MPMC queue sequence (Vyukov): equal to the position when the
+  // slot is free to claim, one past it once the message is in
+  std::atomic<uint64_t> sequence{0};
+  uint64_t time_ns = 0;
+  const Site *site = nullptr;
+  uint32_t suppressed = 0;
+  char text[MESSAGE_BYTES];
+};
+
+struct Logger {
+  Logger();
+
+  // nullptr when the queue is full
+  Slot *claim(uint64_t &position);
+  void publish(Slot &slot, uint64_t position);
+  // Writes everything published, in order; the writer thread, or callers
+  // once it has stopped
+  void drain();
+  void run();
+
+  Slot slots[QUEUE_CAPACITY];
+  alignas(64) std::atomic<uint64_t> tail{0}; // next position to claim
+  alignas(64) uint64_t head = 0;             // next position to write
+  std::atomic<uint64_t> written{0};
+  std::atomic<uint64_t> dropped{0};
+  uint64_t reported_dropped = 0;
+  std::atomic<bool> running{true};
+
+  std::mutex drain_mutex; // one consumer at a time
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable drained;
+  std::thread writer;
+  char batch[BATCH_BYTES];
+};
+
+} // namespace
+
+static void stopLogger();
+
+// Never destroyed, so statements in static destructors still work: after
+// stopLogger() they write synchronously
+static Logger &logger() {
+  static Logger *instance = new Logger();
+  return *instance;
+}
+
+Logger::Logger() {
+  for (uint64_t i = 0; i < QUEUE_CAPACITY; ++i)
+    slots[i].sequence.store(i, std::memory_order_relaxed);
+  writer = std::thread([this] { run(); });
+  std::atexit(stopLogger);
+}
+
+Slot *Logger::claim(uint64_t &position) {
+  uint64_t pos = tail.load(std::memory_order_relaxed);
+  for (;;) {
+    Slot &slot = slots[pos & (QUEUE_CAPACITY - 1)];
+    uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    int64_t diff = static_cast<int64_t>(sequence - pos);
+    if (diff == 0) {
+      if (tail.compare_exchange_weak(pos, pos + 1,
+                                     std::memory_order_relaxed)) {
+        position = pos;
+        return &slot;
+      }
+    } else if (diff < 0) {
+      return nullptr;
+    } else {
+      pos = tail.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void Logger::publish(Slot &slot, uint64_t position) {
+  slot.sequence.store(position + 1, std::memory_order_release);
+}
+
+static const char *levelName(Level level) {
+  switch (level) {
+  case Level::Debug:
+    return "DEBUG";
+  case Level::Info:
+    return "INFO";
+  case Level::Warn:
+    return "WARN";
+  case Level::Error:
+    return "ERROR";
+  }
+  return "";
+}
+
+static const char *baseName(const char *path) {
+  const char *name = path;
+  for (const char *c = path; *c; ++c)
+    if (*c == '/' || *c == '\\')
+      name = c + 1;
+  return name;
+}
+
+// snprintf that returns what it actually wrote
+static size_t append(char *out, size_t room, const char *format, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 3, 4)))
+#endif
+    ;
+
+static size_t append(char *out, size_t room, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(out, room, format, args);
+  va_end(args);
+  if (n < 0)
+    return 0;
+  return static_cast<size_t>(n) < room ? n : room - 1;
+}
+
+void Logger::drain() {
+  std::lock_guard<std::mutex> lock(drain_mutex);
+  size_t used = 0;
+
+  uint64_t lost = dropped.load(std::memory_order_relaxed);
+  if (lost != reported_dropped) {
+    used += append(batch, BATCH_BYTES, "%.3f WARN log: %llu messages dropped\n",
+                   nowNs() / 1e9,
+                   static_cast<unsigned long long>(lost - reported_dropped));
+    reported_dropped = lost;
+  }
+
+  for (;;) {
+    Slot &slot = slots[head & (QUEUE_CAPACITY - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+      break;
+    if (used + LINE_BYTES > BATCH_BYTES) {
+      fwrite(batch, 1, used, stdout);
+      used = 0;
+    }
+    char *line = batch + used;
+    size_t room = BATCH_BYTES - used;
+    size_t n = append(line, room, "%.3f %s %s:%d %s", slot.time_ns / 1e9,
+                      levelName(slot.site->level), baseName(slot.site->file),
+                      slot.site->line, slot.text);
+    if (slot.suppressed > 0)
+      n += append(line + n, room - n, " (%u similar suppressed)",
+                  slot.suppressed);
+    line[n++] = '\n';
+    used += n;
+    slot.sequence.store(head + QUEUE_CAPACITY, std::memory_order_release);
+    ++head;
+  }
+  written.store(head, std::memory_order_release);
+
+  if (used > 0) {
+    fwrite(batch, 1, used, stdout);
+    fflush(stdout);
+  }
+}
+
+void Logger::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (running.load()) {
+    lock.unlock();
+    drain();
+    lock.lock();
+    drained.notify_all();
+    wake.wait_for(lock, WRITE_INTERVAL);
+  }
+}
+
+static void stopLogger() {
+  Logger &log = logger();
+  {
+    std::lock_guard<std::mutex> lock(log.mutex);
+    log.running.store(false);
+  }
+  log.wake.notify_one();
+  log.writer.join();
+  log.drain();
+  log.drained.notify_all();
+}
+
+void write(Site &site, const char *format, ...) {
+  uint64_t now = nowNs();
+
+  uint64_t window_start = site.window_start_ns.load(std::memory_order_relaxed);
+  if (now - window_start >= BURST_WINDOW_NS &&
+      site.window_start_ns.compare_exchange_strong(
+          window_start, now, std::memory_order_relaxed))
+    site.window_count.store(0, std::memory_order_relaxed);
+  if (site.window_count.fetch_add(1, std::memory_order_relaxed) >= BURST) {
+    site.suppressed.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  Logger &log = logger();
+  uint64_t position;
+  Slot *slot = log.claim(position);
+  if (!slot) {
+    log.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  slot->time_ns = now;
+  slot->site = &site;
+  slot->suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+  va_list args;
+  va_start(args, format);
+  vsnprintf(slot->text, MESSAGE_BYTES, format, args);
+  va_end(args);
+  log.publish(*slot, position);
+
+  if (!log.running.load())
+    log.drain();
+}
+
+void flush() {
+  Logger &log = logger();
+  uint64_t target = log.tail.load(std::memory_order_acquire);
+  std::unique_lock<std::mutex> lock(log.mutex);
+  if (log.running.load()) {
+    log.wake.notify_one();
+    log.drained.wait(lock, [&] {
+      return !log.running.load() ||
+             log.written.load(std::memory_order_acquire) >= target;
+    });
+  }
+  if (!log.running.load()) {
+    lock.unlock();
+    log.drain();
+  }
+}
+
+uint64_t droppedCount() {
+  return logger().dropped.load(std::memory_order_relaxed);
+}
+
+} // namespace Log
@@ -1,27 +1,60 @@
+#include "../include/frame_arena.hpp"
+#include "../include/hot_reload.hpp"
+#include "../include/input_manager.hpp"
 #include "../include/level_manager.hpp"
 #include "../include/path_utils.hpp"
+#include "../include/profiler.hpp"
+#include "../include/resource_pack.hpp"
 #include "../include/screen_manager.hpp"
 #include "../include/settings.hpp"
+#include "../include/text_renderer.hpp"
 #include "../include/texture_manager.hpp"
 #include "../include/ui_manager.hpp"
 #include "../include/ui_utils.hpp"
 #include "../include/window_manager.hpp"
 #include "raylib.h"
+#include <cstdio>
+#include <string>
 
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--record" && i + 1 < argc) {
+      setInputRecordingPath(argv[++i]);
+    } else if (arg == "--level" && i + 1 < argc) {
+      setLevelPath(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: voltquest [--record <session.vqinput>] "
+                      "[--level <file.json>]\n");
+      return 1;
+    }
+  }
 
-int main() {
   initBasePath();
+  // One mapped archive instead of many small files, when the build made one
+  ResourcePack::Mount(getResourcePackPath(), getResourcePath(""));
   initSettingsPath();
   loadSettings();
   createWindow();
   calculateScreenScale();
-  updateLayout();
+  TextRenderer::Init(getResourcePath("assets/fonts/ui.ttf"));
   TextureManager::LoadSVG("voltquest_logo",
                           getResourcePath("assets/logos/voltquest.svg"),
                           safeScreenScale);
+  HotReload::Start(getResourcePath(""));
   while (globalSettings.isGameRunning) {
+    frameArena().reset();
+    HotReload::Apply();
+    updateWindowSize();
+    InputManager::beginFrame();
     drawCurrentScreen();
+    Profiler::updateControls();
+    PROFILE_FRAME();
   }
+  unloadLevels();
+  HotReload::Stop();
+  TextRenderer::UnloadAll();
   CloseWindow();
+  ResourcePack::Unmount();
   return 0;
 }
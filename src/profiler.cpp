@@ -0,0 +1,359 @@
+#include "../include/profiler.hpp"
+#include "../include/log.hpp"
+
+#ifdef VOLTQUEST_PROFILER
+
+#include "raylib.h"
+#include <nlohmann/json.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct ZoneEvent {
+  const char *name;
+  uint64_t start_ns;
+  uint64_t end_ns;
+};
+
+// Single-producer/single-consumer ring: the owning thread pushes, the main
+// thread drains in endFrame(). Full buffers drop events instead of blocking.
+struct ThreadBuffer {
+  static constexpr uint64_t CAPACITY = 1 << 14;
+
+  std::array<ZoneEvent, CAPACITY> events;
+  std::atomic<uint64_t> head{0};
+  std::atomic<uint64_t> tail{0};
+  std::atomic<uint64_t> dropped{0};
+  uint32_t thread_index = 0;
+};
+
+struct Registry {
+  std::mutex mutex; // guards `buffers`, taken on thread start and drain only
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+Registry &registry() {
+  static Registry instance;
+  return instance;
+}
+
+ThreadBuffer &threadBuffer() {
+  thread_local ThreadBuffer *local = nullptr;
+  if (!local) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.buffers.push_back(std::make_unique<ThreadBuffer>());
+    local = reg.buffers.back().get();
+    local->thread_index = static_cast<uint32_t>(reg.buffers.size() - 1);
+  }
+  return *local;
+}
+
+struct TraceEvent {
+  const char *name;
+  uint64_t start_ns;
+  uint64_t end_ns;
+  uint32_t thread_index;
+};
+
+struct ZoneStat {
+  const char *name;
+  double frame_ms = 0.0; // accumulating for the current frame
+  uint32_t frame_calls = 0;
+  double last_ms = 0.0; // the last finished frame
+  uint32_t last_calls = 0;
+  double avg_ms = 0.0; // smoothed for display
+};
+
+constexpr size_t FRAME_HISTORY = 240;
+constexpr size_t TRACE_CAPACITY = 1 << 16;
+constexpr double TARGET_FRAME_MS = 1000.0 / 60.0;
+
+// Everything below is owned by the main thread
+struct State {
+  bool overlay_visible = false;
+  uint64_t frame_start_ns = 0;
+  double last_frame_ms = 0.0;
+  uint32_t main_thread_index = 0;
+  uint64_t dropped = 0;
+  uint64_t frame_start_allocations = 0;
+  uint64_t last_frame_allocations = 0;
+
+  std::vector<ZoneStat> zones;
+  std::vector<std::string> notes;
+  std::array<float, FRAME_HISTORY> frame_history{};
+  size_t frame_cursor = 0;
+
+  std::vector<TraceEvent> trace;
+  size_t trace_next = 0;
+};
+
+State &state() {
+  static State instance = [] {
+    State s;
+    s.trace.reserve(TRACE_CAPACITY); // no growth once the game is running
+    return s;
+  }();
+  return instance;
+}
+
+ZoneStat &zoneStat(State &s, const char *name) {
+  for (ZoneStat &z : s.zones) {
+    // Identical literals in different translation units may not share an
+    // address, so fall back to comparing the text
+    if (z.name == name || std::strcmp(z.name, name) == 0)
+      return z;
+  }
+  s.zones.push_back(ZoneStat{name});
+  return s.zones.back();
+}
+
+void pushTrace(State &s, const TraceEvent &event) {
+  if (s.trace.size() < TRACE_CAPACITY) {
+    s.trace.push_back(event);
+  } else {
+    s.trace[s.trace_next] = event;
+  }
+  s.trace_next = (s.trace_next + 1) % TRACE_CAPACITY;
+}
+
+void drain(State &s) {
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  for (auto &buf : reg.buffers) {
+    uint64_t tail = buf->tail.load(std::memory_order_relaxed);
+    uint64_t head = buf->head.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+      const ZoneEvent &e = buf->events[tail & (ThreadBuffer::CAPACITY - 1)];
+      ZoneStat &z = zoneStat(s, e.name);
+      z.frame_ms += (e.end_ns - e.start_ns) * 1e-6;
+      z.frame_calls++;
+      pushTrace(s, {e.name, e.start_ns, e.end_ns, buf->thread_index});
+    }
+    buf->tail.store(tail, std::memory_order_release);
+    s.dropped += buf->dropped.exchange(0, std::memory_order_relaxed);
+  }
+}
+
+Color frameColor(float ms) {
+  if (ms <= TARGET_FRAME_MS + 0.5)
+    return GREEN;
+  if (ms <= 2.0 * TARGET_FRAME_MS + 0.5)
+    return ORANGE;
+  return RED;
+}
+
+} // namespace
+
+uint64_t Profiler::nowNs() {
+  using Clock = std::chrono::steady_clock;
+  static const Clock::time_point epoch = Clock::now();
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                           epoch)
+          .count());
+}
+
+void Profiler::record(const char *name, uint64_t start_ns, uint64_t end_ns) {
+  ThreadBuffer &buf = threadBuffer();
+  uint64_t head = buf.head.load(std::memory_order_relaxed);
+  if (head - buf.tail.load(std::memory_order_acquire) >=
+      ThreadBuffer::CAPACITY) {
+    buf.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  buf.events[head & (ThreadBuffer::CAPACITY - 1)] = {name, start_ns, end_ns};
+  buf.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::endFrame() {
+  State &s = state();
+  uint64_t now = nowNs();
+  s.main_thread_index = threadBuffer().thread_index;
+
+  drain(s);
+
+  if (s.frame_start_ns != 0) {
+    s.last_frame_ms = (now - s.frame_start_ns) * 1e-6;
+    s.frame_history[s.frame_cursor] = static_cast<float>(s.last_frame_ms);
+    s.frame_cursor = (s.frame_cursor + 1) % FRAME_HISTORY;
+    pushTrace(s, {"frame", s.frame_start_ns, now, s.main_thread_index});
+  }
+  s.frame_start_ns = now;
+
+  uint64_t allocations = allocationCount();
+  s.last_frame_allocations = allocations - s.frame_start_allocations;
+  s.frame_start_allocations = allocations;
+
+  for (ZoneStat &z : s.zones) {
+    z.last_ms = z.frame_ms;
+    z.last_calls = z.frame_calls;
+    z.avg_ms += (z.last_ms - z.avg_ms) * 0.1;
+    z.frame_ms = 0.0;
+    z.frame_calls = 0;
+  }
+}
+
+void Profiler::updateControls() {
+  if (IsKeyPressed(KEY_F3))
+    setOverlayVisible(!overlayVisible());
+
+  if (IsKeyPressed(KEY_F4)) {
+    const char *path = "voltquest_trace.json";
+    if (exportTrace(path))
+      LOG_INFO("Profiler trace written to %s", path);
+  }
+}
+
+void Profiler::drawOverlay() {
+  State &s = state();
+  if (!s.overlay_visible)
+    return;
+
+  const int fontSize = 20;
+  const int lineHeight = 24;
+  const int padding = 10;
+  const int width = 420;
+  const int graphHeight = 80;
+  const int x = padding;
+  int y = padding;
+  int height = padding * 3 +
+               lineHeight * (2 + (int)s.zones.size() + (int)s.notes.size()) +
+               graphHeight;
+
+  DrawRectangle(x, y, width, height, Fade(BLACK, 0.75f));
+  int textX = x + padding;
+  int valueX = x + width - 170;
+  y += padding;
+
+  char text[128];
+  double fps = s.last_frame_ms > 0.0 ? 1000.0 / s.last_frame_ms : 0.0;
+  snprintf(text, sizeof(text), "frame %.2f ms (%.0f fps)", s.last_frame_ms,
+           fps);
+  DrawText(text, textX, y, fontSize, frameColor((float)s.last_frame_ms));
+  snprintf(text, sizeof(text), "%llu allocs",
+           static_cast<unsigned long long>(s.last_frame_allocations));
+  DrawText(text, valueX, y, fontSize,
+           s.last_frame_allocations > 0 ? ORANGE : RAYWHITE);
+  y += lineHeight;
+
+  DrawText("zone", textX, y, fontSize, GRAY);
+  if (s.dropped > 0) {
+    snprintf(text, sizeof(text), "(%llu dropped)",
+             static_cast<unsigned long long>(s.dropped));
+    DrawText(text, textX + 60, y, fontSize, RED);
+  }
+  DrawText("ms    calls", valueX, y, fontSize, GRAY);
+  y += lineHeight;
+
+  for (const ZoneStat &z : s.zones) {
+    DrawText(z.name, textX, y, fontSize, RAYWHITE);
+    snprintf(text, sizeof(text), "%6.3f  %5u", z.avg_ms, z.last_calls);
+    DrawText(text, valueX, y, fontSize, RAYWHITE);
+    y += lineHeight;
+  }
+  for (const std::string &note : s.notes) {
+    DrawText(note.c_str(), textX, y, fontSize, SKYBLUE);
+    y += lineHeight;
+  }
+
+  // Frame-time graph, oldest on the left; full height is two 60 Hz frames
+  y += padding;
+  int graphWidth = width - 2 * padding;
+  float barWidth = (float)graphWidth / FRAME_HISTORY;
+  float msToPx = graphHeight / (float)(2.0 * TARGET_FRAME_MS);
+  for (size_t i = 0; i < FRAME_HISTORY; ++i) {
+    float ms = s.frame_history[(s.frame_cursor + i) % FRAME_HISTORY];
+    float barHeight = ms * msToPx;
+    if (barHeight > graphHeight)
+      barHeight = graphHeight;
+    DrawRectangleRec(Rectangle{textX + i * barWidth, y + graphHeight -
+                                                         barHeight,
+                               barWidth, barHeight},
+                     frameColor(ms));
+  }
+  int targetY = y + graphHeight - (int)(TARGET_FRAME_MS * msToPx);
+  DrawLine(textX, targetY, textX + graphWidth, targetY, Fade(RAYWHITE, 0.5f));
+}
+
+bool Profiler::overlayVisible() { return state().overlay_visible; }
+
+void Profiler::setOverlayVisible(bool visible) {
+  state().overlay_visible = visible;
+}
+
+void Profiler::setOverlayNotes(const std::vector<std::string> &notes) {
+  state().notes = notes;
+}
+
+bool Profiler::exportTrace(const std::string &path) {
+  State &s = state();
+  nlohmann::json events = nlohmann::json::array();
+
+  size_t threads;
+  {
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    threads = registry().buffers.size();
+  }
+  for (uint32_t t = 0; t < threads; ++t) {
+    events.push_back({
+        {"name", "thread_name"},
+        {"ph", "M"},
+        {"pid", 1},
+        {"tid", t},
+        {"args",
+         {{"name", t == s.main_thread_index ? std::string("main")
+                                            : "worker " + std::to_string(t)}}},
+    });
+  }
+
+  // Oldest first: once the ring has wrapped, trace_next is the oldest slot
+  size_t count = s.trace.size();
+  size_t first = count < TRACE_CAPACITY ? 0 : s.trace_next;
+  for (size_t i = 0; i < count; ++i) {
+    const TraceEvent &e = s.trace[(first + i) % count];
+    events.push_back({
+        {"name", e.name},
+        {"cat", "zone"},
+        {"ph", "X"},
+        {"ts", e.start_ns * 1e-3},
+        {"dur", (e.end_ns - e.start_ns) * 1e-3},
+        {"pid", 1},
+        {"tid", e.thread_index},
+    });
+  }
+
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    LOG_ERROR("Failed to open trace file: %s", path.c_str());
+    return false;
+  }
+  nlohmann::json trace = {{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+  out << trace.dump() << '\n';
+  return true;
+}
+
+double Profiler::lastFrameMs() { return state().last_frame_ms; }
+
+uint64_t Profiler::lastFrameAllocations() {
+  return state().last_frame_allocations;
+}
+
+double Profiler::lastZoneMs(const char *name) {
+  for (const ZoneStat &z : state().zones) {
+    if (std::strcmp(z.name, name) == 0)
+      return z.last_ms;
+  }
+  return 0.0;
+}
+
+#endif // VOLTQUEST_PROFILER
@@ -0,0 +1,315 @@
+#include "../include/resource_pack.hpp"
+#include "../include/log.hpp"
+#include "../include/profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <tuple>
+#include <unordered_set>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char MAGIC[8] = {'V', 'Q', 'P', 'A', 'C', 'K', '\0', '\0'};
+static constexpr size_t HEADER_SIZE = 16; // magic, version, entry count
+static constexpr size_t DATA_ALIGNMENT = 16;
+
+// The mounted pack
+static const unsigned char *pack_data = nullptr;
+static size_t pack_size = 0;
+static const ResourcePackEntry *entries = nullptr;
+static uint32_t entry_count = 0;
+static std::string resource_root; // normalized, ends with a separator
+// Name hashes of entries overridden by newer loose files; hot reload adds
+// to it from its own thread
+static std::unordered_set<uint64_t> shadowed;
+static std::mutex shadow_mutex;
+#ifdef _WIN32
+static HANDLE mapping = nullptr;
+#endif
+
+static auto entryKey(const ResourcePackEntry &e) {
+  return std::make_tuple(e.name_hash, static_cast<uint32_t>(e.kind),
+                         e.scale_milli);
+}
+
+// Maps the whole file read-only; nullptr if it can't be opened
+static const unsigned char *mapFile(const std::string &path, size_t &size) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return nullptr;
+  LARGE_INTEGER length;
+  if (!GetFileSizeEx(file, &length) || length.QuadPart == 0) {
+    CloseHandle(file);
+    return nullptr;
+  }
+  mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file); // the mapping keeps the file open
+  if (!mapping)
+    return nullptr;
+  void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view) {
+    CloseHandle(mapping);
+    mapping = nullptr;
+    return nullptr;
+  }
+  size = static_cast<size_t>(length.QuadPart);
+  return static_cast<const unsigned char *>(view);
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return nullptr;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return nullptr;
+  }
+  void *view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                    MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping keeps the file open
+  if (view == MAP_FAILED)
+    return nullptr;
+  size = static_cast<size_t>(st.st_size);
+  return static_cast<const unsigned char *>(view);
+#endif
+}
+
+static void unmapFile() {
+  if (!pack_data)
+    return;
+#ifdef _WIN32
+  UnmapViewOfFile(pack_data);
+  CloseHandle(mapping);
+  mapping = nullptr;
+#else
+  munmap(const_cast<unsigned char *>(pack_data), pack_size);
+#endif
+  pack_data = nullptr;
+  pack_size = 0;
+}
+
+bool ResourcePack::Mount(const std::string &packPath,
+                         const std::string &resourceRoot) {
+  PROFILE_ZONE("ResourcePack::Mount");
+  Unmount();
+
+  size_t size = 0;
+  const unsigned char *data = mapFile(packPath, size);
+  if (!data)
+    return false; // no pack, loose files it is
+
+  uint32_t version = 0;
+  uint32_t count = 0;
+  if (size >= HEADER_SIZE) {
+    std::memcpy(&version, data + 8, sizeof(version));
+    std::memcpy(&count, data + 12, sizeof(count));
+  }
+  bool valid = size >= HEADER_SIZE &&
+               std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0 &&
+               version == RESOURCE_PACK_VERSION &&
+               count <= (size - HEADER_SIZE) / sizeof(ResourcePackEntry);
+  const auto *table =
+      reinterpret_cast<const ResourcePackEntry *>(data + HEADER_SIZE);
+  for (uint32_t i = 0; valid && i < count; ++i) {
+    valid = table[i].offset <= size && table[i].size <= size - table[i].offset;
+  }
+  pack_data = data;
+  pack_size = size;
+  if (!valid) {
+    LOG_WARN("Ignoring invalid resource pack: %s", packPath.c_str());
+    unmapFile();
+    return false;
+  }
+
+  entries = table;
+  entry_count = count;
+  resource_root =
+      (std::filesystem::path(resourceRoot) / "").lexically_normal().string();
+  LOG_INFO("Mounted resource pack %s (%u entries)", packPath.c_str(), count);
+  return true;
+}
+
+void ResourcePack::Unmount() {
+  unmapFile();
+  entries = nullptr;
+  entry_count = 0;
+  resource_root.clear();
+  std::lock_guard<std::mutex> lock(shadow_mutex);
+  shadowed.clear();
+}
+
+bool ResourcePack::IsMounted() { return pack_data != nullptr; }
+
+uint64_t ResourcePack::HashName(const std::string &name) {
+  uint64_t hash = 14695981039346656037ull; // FNV-1a
+  for (unsigned char c : name) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+uint32_t ResourcePack::ScaleMilli(float scale) {
+  return static_cast<uint32_t>(std::lround(scale * 1000.0f));
+}
+
+// Hash of the name of `path` in the pack; false if it is outside the root
+static bool nameHashOf(const std::string &path, uint64_t &hash) {
+  std::string normal = std::filesystem::path(path).lexically_normal().string();
+  if (!entries || normal.size() <= resource_root.size() ||
+      normal.compare(0, resource_root.size(), resource_root) != 0)
+    return false;
+
+  std::string name = normal.substr(resource_root.size());
+  std::replace(name.begin(), name.end(), '\\', '/');
+  hash = ResourcePack::HashName(name);
+  return true;
+}
+
+// The entry for `path` under the mounted root, or nullptr
+static const ResourcePackEntry *findEntry(const std::string &path,
+                                          ResourceKind kind,
+                                          uint32_t scale_milli) {
+  ResourcePackEntry probe = {};
+  if (!nameHashOf(path, probe.name_hash))
+    return nullptr;
+  {
+    std::lock_guard<std::mutex> lock(shadow_mutex);
+    if (shadowed.count(probe.name_hash))
+      return nullptr;
+  }
+  probe.kind = kind;
+  probe.scale_milli = scale_milli;
+
+  const ResourcePackEntry *end = entries + entry_count;
+  const ResourcePackEntry *it = std::lower_bound(
+      entries, end, probe,
+      [](const ResourcePackEntry &a, const ResourcePackEntry &b) {
+        return entryKey(a) < entryKey(b);
+      });
+  if (it == end || entryKey(*it) != entryKey(probe))
+    return nullptr;
+  return it;
+}
+
+void ResourcePack::Shadow(const std::string &path) {
+  uint64_t hash;
+  if (!nameHashOf(path, hash))
+    return;
+  std::lock_guard<std::mutex> lock(shadow_mutex);
+  shadowed.insert(hash);
+}
+
+bool ResourcePack::Find(const std::string &path, View &out) {
+  const ResourcePackEntry *e = findEntry(path, ResourceKind::File, 0);
+  if (!e)
+    return false;
+  out.data = pack_data + e->offset;
+  out.size = static_cast<size_t>(e->size);
+  return true;
+}
+
+bool ResourcePack::FindRaster(const std::string &path, float scale,
+                              RasterView &out) {
+  const ResourcePackEntry *e =
+      findEntry(path, ResourceKind::Raster, ScaleMilli(scale));
+  if (!e || e->size != (uint64_t)e->width * e->height * 4)
+    return false;
+  out.pixels = pack_data + e->offset;
+  out.width = static_cast<int>(e->width);
+  out.height = static_cast<int>(e->height);
+  return true;
+}
+
+// Writer
+
+void ResourcePackWriter::addFile(const std::string &name,
+                                 std::vector<unsigned char> bytes) {
+  ResourcePackEntry entry = {};
+  entry.name_hash = ResourcePack::HashName(name);
+  entry.kind = ResourceKind::File;
+  items.push_back({entry, std::move(bytes)});
+}
+
+void ResourcePackWriter::addRaster(const std::string &name, float scale,
+                                   int width, int height,
+                                   std::vector<unsigned char> pixels) {
+  ResourcePackEntry entry = {};
+  entry.name_hash = ResourcePack::HashName(name);
+  entry.kind = ResourceKind::Raster;
+  entry.scale_milli = ResourcePack::ScaleMilli(scale);
+  entry.width = static_cast<uint32_t>(width);
+  entry.height = static_cast<uint32_t>(height);
+  items.push_back({entry, std::move(pixels)});
+}
+
+static size_t alignUp(size_t n) {
+  return (n + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+}
+
+bool ResourcePackWriter::write(const std::string &path) const {
+  std::vector<const Item *> sorted;
+  for (const Item &item : items)
+    sorted.push_back(&item);
+  std::sort(sorted.begin(), sorted.end(), [](const Item *a, const Item *b) {
+    return entryKey(a->entry) < entryKey(b->entry);
+  });
+  for (size_t i = 1; i < sorted.size(); ++i) {
+    if (entryKey(sorted[i - 1]->entry) == entryKey(sorted[i]->entry)) {
+      LOG_ERROR("Resource pack has two entries with the same key");
+      return false;
+    }
+  }
+
+  std::vector<ResourcePackEntry> table;
+  size_t offset =
+      alignUp(HEADER_SIZE + sorted.size() * sizeof(ResourcePackEntry));
+  for (const Item *item : sorted) {
+    ResourcePackEntry entry = item->entry;
+    entry.offset = offset;
+    entry.size = item->bytes.size();
+    table.push_back(entry);
+    offset = alignUp(offset + item->bytes.size());
+  }
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    LOG_ERROR("Failed to open resource pack for writing: %s", path.c_str());
+    return false;
+  }
+  uint32_t header[2] = {RESOURCE_PACK_VERSION,
+                        static_cast<uint32_t>(table.size())};
+  file.write(MAGIC, sizeof(MAGIC));
+  file.write(reinterpret_cast<const char *>(header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(table.data()),
+             table.size() * sizeof(ResourcePackEntry));
+
+  size_t written = HEADER_SIZE + table.size() * sizeof(ResourcePackEntry);
+  static const char zeros[DATA_ALIGNMENT] = {};
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    file.write(zeros, table[i].offset - written);
+    file.write(reinterpret_cast<const char *>(sorted[i]->bytes.data()),
+               sorted[i]->bytes.size());
+    written = table[i].offset + sorted[i]->bytes.size();
+  }
+  if (!file) {
+    LOG_ERROR("Failed to write resource pack: %s", path.c_str());
+    return false;
+  }
+  return true;
+}
@@ -1,14 +1,40 @@
 #include "../include/screen_manager.hpp"
+#include "../include/hot_reload.hpp"
+#include "../include/input_manager.hpp"
+#include "../include/input_recording.hpp"
+#include "../include/level_cache.hpp"
 #include "../include/level_manager.hpp"
+#include "../include/profiler.hpp"
+#include "../include/path_utils.hpp"
+#include "../include/text_renderer.hpp"
 #include "../include/settings.hpp"
 #include "../include/ui_manager.hpp"
 #include "../include/ui_utils.hpp"
 #include "raylib.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 enum class SCREEN { START_MENU, OPTIONS_MENU, CHAPTER_MENU, LEVEL_MENU, GAME };
 SCREEN currentScreen = SCREEN::START_MENU;
-ElectronicsLevel *current_level = nullptr;
+static std::unique_ptr<ElectronicsLevel> current_level;
+static std::string current_level_path; // "" for the sandbox
+static SCREEN level_exit_screen = SCREEN::START_MENU; // where Q goes
+static std::string input_recording_path;
+static InputRecorder input_recorder;
+static std::string level_path;
+
+// Played levels stay warm and the menus preload what is likely next
+static LevelCache level_cache;
+static LevelCatalog level_catalog;
+static bool level_catalog_scanned = false;
+static int current_chapter = 0;
+static std::string last_played; // path, within its chapter
+
+void setInputRecordingPath(const std::string &path) {
+  input_recording_path = path;
+}
+
+void setLevelPath(const std::string &path) { level_path = path; }
 
 namespace startMenu {
 float logoSize;
@@ -38,6 +64,44 @@ Rectangle panelBounds;
 Vector2 optionsTextPos;
 } // namespace optionsMenu
 
+// The chapter and level menus: one button per entry, in columns
+namespace listMenu {
+constexpr int ROWS = 6;
+std::string title;
+std::vector<std::string> labels;
+std::vector<std::string> paths; // level menu: the level of each button
+std::vector<UIButton> buttons;
+std::vector<UIButton *> buttonPointers;
+Vector2 titlePos;
+int focusedButton = -1;
+} // namespace listMenu
+
+static void layoutListMenu() {
+  using namespace listMenu;
+  Vector2 size = {360.0f * safeScreenScale, 90.0f * safeScreenScale};
+  float spacing = 24.0f * safeScreenScale;
+  int count = static_cast<int>(labels.size());
+  int columns = std::max((count + ROWS - 1) / ROWS, 1);
+  float width = columns * size.x + (columns - 1) * spacing;
+  float left = baseWidth / 2.0f * screenScaleX - width / 2.0f;
+  float top = baseHeight / 4.0f * screenScaleY;
+
+  titlePos = {baseWidth / 2.0f * screenScaleX, baseHeight / 8.0f};
+  buttons.resize(labels.size());
+  buttonPointers.resize(labels.size());
+  for (int i = 0; i < count; ++i) {
+    int column = i / ROWS;
+    int row = i % ROWS;
+    buttons[i] = {{left + column * (size.x + spacing),
+                   top + row * (size.y + spacing), size.x, size.y},
+                  labels[i],
+                  40,
+                  Color{255, 198, 0, 255},
+                  false};
+    buttonPointers[i] = &buttons[i];
+  }
+}
+
 void updateLayout() {
   // Start Menu
   {
@@ -57,7 +121,8 @@ void updateLayout() {
          startMenu::buttonSize.y},
         "PLAY",
         55,
-        Color{255, 198, 0, 255}};
+        Color{255, 198, 0, 255},
+        false};
 
     startMenu::optionsButton = {
         {(baseWidth / 2.0f * screenScaleX) - (startMenu::buttonSize.x / 2.0f),
@@ -65,7 +130,8 @@ void updateLayout() {
          startMenu::buttonSize.x, startMenu::buttonSize.y},
         "OPTIONS",
         55,
-        Color{0, 146, 255, 255}};
+        Color{0, 146, 255, 255},
+        false};
 
     startMenu::quitButton = {
         {(baseWidth / 2.0f * screenScaleX) - (startMenu::buttonSize.x / 2.0f),
@@ -73,7 +139,8 @@ void updateLayout() {
          startMenu::buttonSize.x, startMenu::buttonSize.y},
         "QUIT",
         55,
-        RED};
+        RED,
+        false};
   }
 
   // Options Menu
@@ -88,6 +155,129 @@ void updateLayout() {
     optionsMenu::optionsTextPos = {baseWidth / 2.0f * screenScaleX,
                                    baseHeight / 8.0f}; // Top text Y position
   }
+
+  layoutListMenu();
+}
+
+// Nothing is focused until an arrow key is pressed, so the Enter that
+// opened a menu doesn't also pick its first entry
+static void openListMenu(SCREEN screen, const char *title,
+                         std::vector<std::string> labels,
+                         std::vector<std::string> paths) {
+  listMenu::title = title;
+  listMenu::labels = std::move(labels);
+  listMenu::paths = std::move(paths);
+  listMenu::focusedButton = -1;
+  layoutListMenu();
+  currentScreen = screen;
+}
+
+static int chapterOf(const std::string &path) {
+  for (size_t c = 0; c < level_catalog.chapters.size(); ++c) {
+    const std::vector<std::string> &levels = level_catalog.chapters[c].levels;
+    if (std::find(levels.begin(), levels.end(), path) != levels.end())
+      return static_cast<int>(c);
+  }
+  return -1;
+}
+
+// The next `count` levels of `chapter` after the last one played there,
+// else its first ones
+static void nextLevels(int chapter, size_t count,
+                       std::vector<std::string> &out) {
+  const std::vector<std::string> &levels =
+      level_catalog.chapters[chapter].levels;
+  auto played = std::find(levels.begin(), levels.end(), last_played);
+  size_t first = played == levels.end() ? 0 : played - levels.begin() + 1;
+  for (size_t i = first; i < levels.size() && i < first + count; ++i)
+    out.push_back(levels[i]);
+}
+
+static void openChapterMenu() {
+  if (!level_catalog_scanned) {
+    level_catalog = LevelCatalog::scan(getResourcePath("levels"));
+    level_catalog_scanned = true;
+  }
+  std::vector<std::string> labels;
+  for (const LevelCatalog::Chapter &chapter : level_catalog.chapters)
+    labels.push_back(LevelCatalog::displayName(chapter.name));
+  labels.push_back("SANDBOX"); // an empty board
+  openListMenu(SCREEN::CHAPTER_MENU, "CHAPTERS", std::move(labels), {});
+
+  // Likely next: where the player left off, then the chapter after it
+  std::vector<std::string> likely;
+  int chapter = std::max(chapterOf(last_played), 0);
+  if (chapter < static_cast<int>(level_catalog.chapters.size()))
+    nextLevels(chapter, 1, likely);
+  if (chapter + 1 < static_cast<int>(level_catalog.chapters.size()))
+    likely.push_back(level_catalog.chapters[chapter + 1].levels.front());
+  level_cache.preload(likely);
+}
+
+static void openLevelMenu(int chapter) {
+  current_chapter = chapter;
+  const LevelCatalog::Chapter &entry = level_catalog.chapters[chapter];
+  std::vector<std::string> labels;
+  for (const std::string &path : entry.levels)
+    labels.push_back(LevelCatalog::displayName(path));
+  openListMenu(SCREEN::LEVEL_MENU,
+               LevelCatalog::displayName(entry.name).c_str(),
+               std::move(labels), entry.levels);
+
+  std::vector<std::string> likely;
+  nextLevels(chapter, 2, likely);
+  level_cache.preload(likely);
+}
+
+// Enters `path` ("" for an empty board) from the cache; stays in the menu
+// if the level doesn't load
+static void enterLevel(const std::string &path, SCREEN exit_screen) {
+  current_level = level_cache.acquire(path);
+  if (!current_level)
+    return;
+  current_level_path = path;
+  level_exit_screen = exit_screen;
+  if (!path.empty()) {
+    last_played = path;
+    HotReload::WatchLevel(current_level.get(), path);
+  }
+  // A warm level may still have a part selected or edits to undo, which the
+  // recording couldn't replay
+  current_level->clearSelection();
+  if (!input_recording_path.empty()) {
+    current_level->clearHistory();
+    input_recorder.open(input_recording_path, current_level->getBoardState(),
+                        current_level->getCamera(),
+                        current_level->isStreaming());
+  }
+  currentScreen = SCREEN::GAME;
+}
+
+static void leaveLevel() {
+  input_recorder.close();
+  HotReload::WatchLevel(nullptr, "");
+  current_level->clearSelection();
+  level_cache.release(current_level_path, std::move(current_level));
+
+  switch (level_exit_screen) {
+  case SCREEN::LEVEL_MENU:
+    openLevelMenu(current_chapter);
+    break;
+  case SCREEN::CHAPTER_MENU:
+    openChapterMenu();
+    break;
+  default:
+    currentScreen = SCREEN::START_MENU;
+    break;
+  }
+}
+
+void unloadLevels() {
+  if (current_level) {
+    HotReload::WatchLevel(nullptr, "");
+    current_level.reset();
+  }
+  level_cache.clear();
 }
 
 void drawStartMenu() {
@@ -100,6 +290,14 @@ void drawStartMenu() {
 #endif // !EMSCRIPTEN
 }
 
+void drawListMenu() {
+  ClearBackground(Color{58, 71, 80, 255});
+  drawUIText(80, listMenu::titlePos, listMenu::title.c_str(),
+             Color{0, 146, 255, 255});
+  for (const UIButton &button : listMenu::buttons)
+    drawUIButton(button);
+}
+
 void drawOptionsMenu() {
   ClearBackground(Color{58, 71, 80, 255});
   drawUIPanel(optionsMenu::panelBounds);
@@ -108,16 +306,27 @@ void drawOptionsMenu() {
 }
 
 void drawCurrentScreen() {
+  // Menu geometry is rebuilt only when the screen size changes
+  static LayoutStamp menuLayoutStamp;
+  if (menuLayoutStamp.refresh())
+    updateLayout();
+
   switch (currentScreen) {
   case SCREEN::START_MENU: {
 
     BeginDrawing();
     drawStartMenu();
+    TextRenderer::Flush();
+    Profiler::drawOverlay();
     EndDrawing();
     updateKeyboardNavigation(startMenu::button_count, startMenu::focusedButton,
                              startMenu::buttonsArray);
     if (isUIButtonPressed(startMenu::playButton)) {
-      currentScreen = SCREEN::GAME;
+      // A level given on the command line is played straight away
+      if (!level_path.empty())
+        enterLevel(level_path, SCREEN::START_MENU);
+      else
+        openChapterMenu();
     } else if (isUIButtonPressed(startMenu::optionsButton)) {
       currentScreen = SCREEN::OPTIONS_MENU;
     }
@@ -132,6 +341,8 @@ void drawCurrentScreen() {
   case SCREEN::OPTIONS_MENU: {
     BeginDrawing();
     drawOptionsMenu();
+    TextRenderer::Flush();
+    Profiler::drawOverlay();
     EndDrawing();
     if (IsKeyDown(KEY_ESCAPE)) {
       currentScreen = SCREEN::START_MENU;
@@ -139,20 +350,47 @@ void drawCurrentScreen() {
     break;
   }
 
-  case SCREEN::GAME: {
-    if (current_level == nullptr) {
-      current_level = new ElectronicsLevel(); // Call the Constructor
-      current_level->loadTextures();          // Load images
+  case SCREEN::CHAPTER_MENU:
+  case SCREEN::LEVEL_MENU: {
+    level_cache.update();
+    BeginDrawing();
+    drawListMenu();
+    TextRenderer::Flush();
+    Profiler::drawOverlay();
+    EndDrawing();
+    updateKeyboardNavigation(static_cast<int>(listMenu::buttons.size()),
+                             listMenu::focusedButton,
+                             listMenu::buttonPointers.data());
+
+    bool chapters = currentScreen == SCREEN::CHAPTER_MENU;
+    int pressed = -1;
+    for (size_t i = 0; i < listMenu::buttons.size() && pressed < 0; ++i)
+      if (isUIButtonPressed(listMenu::buttons[i]))
+        pressed = static_cast<int>(i);
+
+    if (IsKeyPressed(KEY_ESCAPE)) {
+      if (chapters)
+        currentScreen = SCREEN::START_MENU;
+      else
+        openChapterMenu();
+    } else if (pressed >= 0 && chapters) {
+      // The last button is the sandbox
+      if (pressed < static_cast<int>(level_catalog.chapters.size()))
+        openLevelMenu(pressed);
+      else
+        enterLevel("", SCREEN::CHAPTER_MENU);
+    } else if (pressed >= 0) {
+      enterLevel(listMenu::paths[pressed], SCREEN::LEVEL_MENU);
     }
+    break;
+  }
 
+  case SCREEN::GAME: {
+    input_recorder.write(InputManager::currentFrame());
     current_level->processLevel();
 
-    if (IsKeyPressed(KEY_Q)) {
-      currentScreen = SCREEN::START_MENU;
-
-      delete current_level;
-      current_level = nullptr;
-    }
+    if (IsKeyPressed(KEY_Q))
+      leaveLevel();
     break;
   }
   default:
@@ -1,40 +1,1213 @@
 #include "../../include/simulation/electronics_simulation.hpp"
 #include "../../include/game_objects/electronic_components/electronics_base.hpp"
+#include "../../include/profiler.hpp"
+#include "../../include/thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
-void ElectronicsSimulation::clearCache() { all_pins.clear(); }
+// Union-find root with path halving
+static int32_t findRoot(std::vector<int32_t> &parent, int32_t i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+// Linear companion model of an element: current from pin 0 to pin 1 through
+// the element is g * (Va - Vb) - source.
+static void elementModel(ComponentLabel kind, float voltage, float resistance,
+                         bool led_on, double &g, double &source) {
+  source = 0.0;
+  switch (kind) {
+  case ComponentLabel::Battery:
+    g = 1.0 / ElectronicsSimulation::BATTERY_INTERNAL_RESISTANCE;
+    source = voltage * g;
+    break;
+  case ComponentLabel::Resistor:
+    g = 1.0 / std::max(resistance * ElectronicsSimulation::RESISTANCE_UNIT,
+                       ElectronicsSimulation::MIN_RESISTANCE);
+    break;
+  case ComponentLabel::Led:
+    if (led_on) {
+      g = 1.0 / ElectronicsSimulation::LED_ON_RESISTANCE;
+      source = voltage * g; // forward voltage drop
+    } else {
+      g = ElectronicsSimulation::LED_OFF_CONDUCTANCE;
+    }
+    break;
+  default: // parts without an electrical model act as an open circuit
+    g = ElectronicsSimulation::LED_OFF_CONDUCTANCE;
+    break;
+  }
+}
+
+static constexpr uint64_t FNV_BASIS = 14695981039346656037ull;
+
+// FNV-1a over the words of a netlist
+static void hashWord(uint64_t &hash, uint32_t word) {
+  for (int shift = 0; shift < 32; shift += 8) {
+    hash ^= (word >> shift) & 0xff;
+    hash *= 1099511628211ull;
+  }
+}
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+// Largest column sum of |A|, its 1-norm; A is symmetric, so also its
+// infinity norm
+static double matrixNorm(const SparseMatrix &A) {
+  double norm = 0.0;
+  for (int32_t col = 0; col < A.n; ++col) {
+    double sum = 0.0;
+    for (int32_t p = A.col_ptr[col]; p < A.col_ptr[col + 1]; ++p)
+      sum += std::fabs(A.values[p]);
+    norm = std::max(norm, sum);
+  }
+  return norm;
+}
+
+// Normwise backward error of x for A x = b, in the infinity norm
+static double backwardError(const SparseMatrix &A,
+                            const std::vector<double> &b,
+                            const std::vector<double> &x) {
+  double r_norm = 0.0, x_norm = 0.0, b_norm = 0.0;
+  for (int32_t row = 0; row < A.n; ++row) {
+    double r = b[row];
+    for (int32_t p = A.col_ptr[row]; p < A.col_ptr[row + 1]; ++p)
+      r -= A.values[p] * x[A.row_idx[p]];
+    r_norm = std::max(r_norm, std::fabs(r));
+    x_norm = std::max(x_norm, std::fabs(x[row]));
+    b_norm = std::max(b_norm, std::fabs(b[row]));
+  }
+  double scale = matrixNorm(A) * x_norm + b_norm;
+  return scale > 0.0 ? r_norm / scale : 0.0;
+}
+
+void ElectronicsSimulation::clearCache() {
+  element_of.clear();
+  islands.clear();
+  built_board = BoardState{};
+  dangling_wires.clear();
+  built = false;
+}
 
-void ElectronicsSimulation::build(
-    const std::vector<std::shared_ptr<ElectronicComponent>> &objects,
-    const std::vector<Wire> &node_edges) {
-  clearCache();
+void ElectronicsSimulation::build(const BoardState &board) {
+  PROFILE_ZONE("simulation.build");
+  auto start = Clock::now();
 
-  fetchPins(objects);
-  buildNodes(node_edges);
-  stampMatrix();
+  std::vector<uint32_t> parts, wires;
+  std::vector<Island> replaced;
+  collectChanges(board, parts, wires, replaced);
+  groupIslands(board, parts, wires);
+  reuseIslands(replaced);
+  orderIslands();
+  prepareIslands();
 
+  built_board = board;
+  built = true;
   dirty = false;
+  last_stats.build_ms = msSince(start);
 }
 
 void ElectronicsSimulation::solve() {
   assert(!dirty && "solve() called before build()");
+  PROFILE_ZONE("simulation.solve");
+  auto start = Clock::now();
+
+  pending.clear();
+  for (size_t i = 0; i < islands.size(); ++i) {
+    if (!islands[i].solved)
+      pending.push_back(static_cast<uint32_t>(i));
+  }
+
+  // Islands share nothing, so each one is solved on its own thread
+  if (pending.size() == 1) {
+    solveIsland(islands[pending[0]]);
+  } else if (!pending.empty()) {
+    threadPool().parallelFor(pending.size(), [this](size_t i) {
+      solveIsland(islands[pending[i]]);
+    });
+  }
+
+  SolveStats &stats = last_stats;
+  stats.islands_solved = pending.size();
+  stats.ordering_ms = stats.symbolic_ms = 0.0;
+  stats.numeric_ms = stats.solve_ms = 0.0;
+  stats.iterations = stats.krylov_iterations = 0;
+  for (uint32_t i : pending) {
+    Island &island = islands[i];
+    stats.ordering_ms += island.ordering_ms;
+    stats.symbolic_ms += island.symbolic_ms;
+    island.ordering_ms = island.symbolic_ms = 0.0; // counted once
+    stats.numeric_ms += island.numeric_ms;
+    stats.solve_ms += island.solve_ms;
+    stats.iterations = std::max(stats.iterations, island.iterations);
+    stats.krylov_iterations =
+        std::max(stats.krylov_iterations, island.krylov_iterations);
+  }
+  stats.islands = islands.size();
+  stats.iterative_islands = iterativeIslandCount();
+  stats.nodes = nodeCount();
+  stats.branches = elementCount();
+  stats.unknowns = unknownCount();
+  stats.matrix_nonzeros = matrixNonZeros();
+  stats.factor_nonzeros = factorNonZeros();
+  stats.residual = 0.0;
+  for (const Island &island : islands)
+    stats.residual = std::max(stats.residual, island.residual);
+  stats.condition = 0.0;
+  stats.total_ms = msSince(start);
+}
+
+void ElectronicsSimulation::estimateCondition() {
+  PROFILE_ZONE("simulation.estimateCondition");
+  pending.clear();
+  for (size_t i = 0; i < islands.size(); ++i) {
+    if (islands[i].condition < 0.0)
+      pending.push_back(static_cast<uint32_t>(i));
+  }
+  threadPool().parallelFor(pending.size(), [this](size_t i) {
+    Island &island = islands[pending[i]];
+    island.condition = estimateIslandCondition(island);
+  });
+
+  last_stats.condition = 0.0;
+  for (const Island &island : islands)
+    last_stats.condition = std::max(last_stats.condition, island.condition);
+}
+
+// Hager's estimate of |A^-1|_1 (Higham, LAPACK xLACON) from a few solves
+// with the island's last factor; A is symmetric, so A^-T = A^-1
+double ElectronicsSimulation::estimateIslandCondition(Island &island) {
+  const int32_t n = island.matrix.n;
+  std::vector<double> x(n, 1.0 / n), y, z;
+  double inverse_norm = 0.0;
+  int32_t last = -1;
+  for (int step = 0; step < 5; ++step) {
+    y = x;
+    island.factor.solve(y);
+    inverse_norm = 0.0;
+    for (double v : y)
+      inverse_norm += std::fabs(v);
+
+    z.resize(n);
+    for (int32_t i = 0; i < n; ++i)
+      z[i] = y[i] >= 0.0 ? 1.0 : -1.0;
+    island.factor.solve(z);
+    int32_t j = 0;
+    double zx = 0.0;
+    for (int32_t i = 0; i < n; ++i) {
+      if (std::fabs(z[i]) > std::fabs(z[j]))
+        j = i;
+      zx += z[i] * x[i];
+    }
+    if (step > 0 && (j == last || std::fabs(z[j]) <= zx))
+      break;
+    std::fill(x.begin(), x.end(), 0.0);
+    x[j] = 1.0;
+    last = j;
+  }
+  return matrixNorm(island.matrix) * inverse_norm;
+}
+
+void ElectronicsSimulation::solveIsland(Island &island) const {
+  PROFILE_ZONE("simulation.solveIsland");
+  if (island.matrix.n > 0 && !island.factor.analyzed())
+    buildPattern(island, solver_backend); // skipped on a cache hit
+
+  // LED states start from the previous solve, so an unchanged island
+  // converges in a single iteration. Voltages are relative to each loop's
+  // own reference until the loop settles.
+  island.iterations = 0;
+  island.krylov_iterations = 0;
+  island.numeric_ms = island.solve_ms = 0.0;
+  island.residual = island.condition = 0.0;
+  bool factored = false;
+  for (int iter = 0; iter < MAX_ITERATIONS; ++iter) {
+    stampMatrix(island);
+    factored = island.matrix.n > 0 && solveMatrix(island);
+    if (island.matrix.n > 0 && !factored)
+      break;
+    for (int32_t net = 0; net < island.net_count; ++net) {
+      int32_t row = island.node_unknown[net];
+      island.node_voltage[net] = row >= 0 ? island.rhs[row] : 0.0;
+    }
+
+    ++island.iterations;
+    if (!updateLedStates(island))
+      break;
+  }
+
+  // The factor left is of the final matrix, ready for an estimate
+  if (factored && !island.iterative)
+    island.condition = -1.0;
+
+  spreadVoltages(island);
+  storeResults(island);
+  island.solved = true;
+  if (solution_cache && !island.form.empty())
+    storeCached(island, *solution_cache);
+}
+
+// Iterative islands start from their last solution. One that doesn't
+// converge falls back to the factor until the island is regrouped.
+bool ElectronicsSimulation::solveMatrix(Island &island) const {
+  if (island.iterative) {
+    SparseCG &krylov = island.krylov;
+    auto start = Clock::now();
+    bool factored = krylov.factorize(island.matrix);
+    auto factored_at = Clock::now();
+    if (factored && krylov.solve(island.matrix, island.rhs, island.solution)) {
+      island.numeric_ms +=
+          std::chrono::duration<double, std::milli>(factored_at - start)
+              .count();
+      island.solve_ms += msSince(factored_at);
+      island.krylov_iterations += krylov.iterations();
+      island.residual =
+          backwardError(island.matrix, island.rhs, island.solution);
+      island.rhs = island.solution;
+      return true;
+    }
+    island.iterative = false;
+  }
+
+  SparseLDL &factor = island.factor;
+  island.rhs_copy = island.rhs;
+  auto start = Clock::now();
+  if (!factor.factorize(island.matrix))
+    return false;
+  island.numeric_ms += msSince(start);
+  start = Clock::now();
+  factor.solve(island.rhs);
+  island.solve_ms += msSince(start);
+  island.residual = backwardError(island.matrix, island.rhs_copy, island.rhs);
+  return true;
+}
+
+void ElectronicsSimulation::collectChanges(const BoardState &board,
+                                           std::vector<uint32_t> &parts,
+                                           std::vector<uint32_t> &wires,
+                                           std::vector<Island> &replaced) {
+  auto alivePart = [&](size_t id) {
+    return id < board.components.size() && board.components[id].alive;
+  };
+
+  if (!built) {
+    element_of.assign(board.components.size(), ElementRef{});
+    for (size_t id = 0; id < board.components.size(); ++id) {
+      if (alivePart(id))
+        parts.push_back(static_cast<uint32_t>(id));
+    }
+    for (size_t id = 0; id < board.connections.size(); ++id) {
+      if (board.connections[id].alive)
+        wires.push_back(static_cast<uint32_t>(id));
+    }
+    replaced = std::move(islands);
+    islands.clear();
+    dangling_wires.clear();
+    return;
+  }
+
+  // Only records that differ from the last build are visited. Their
+  // islands, old and new, are regrouped; the others are kept whole.
+  element_of.resize(std::max(element_of.size(), board.components.size()),
+                    ElementRef{});
+  std::vector<char> touched(islands.size(), 0);
+  auto touch = [&](uint32_t id) {
+    if (id < element_of.size() && element_of[id].island >= 0)
+      touched[element_of[id].island] = 1;
+  };
+
+  std::vector<uint32_t> revived;
+  built_board.components.diff(board.components, [&](size_t id) {
+    touch(static_cast<uint32_t>(id));
+    if (alivePart(id)) {
+      parts.push_back(static_cast<uint32_t>(id));
+      if (id >= built_board.components.size() ||
+          !built_board.components[id].alive)
+        revived.push_back(static_cast<uint32_t>(id));
+    } else if (id < element_of.size()) {
+      element_of[id] = ElementRef{};
+    }
+  });
+  built_board.connections.diff(board.connections, [&](size_t id) {
+    const PersistentVector<ConnectionRecord> *versions[] = {
+        &built_board.connections, &board.connections};
+    for (const PersistentVector<ConnectionRecord> *records : versions) {
+      if (id >= records->size() || !(*records)[id].alive)
+        continue;
+      touch((*records)[id].component_a);
+      touch((*records)[id].component_b);
+    }
+    if (id < board.connections.size() && board.connections[id].alive)
+      wires.push_back(static_cast<uint32_t>(id));
+  });
+
+  // Unchanged wires can only reach a part that comes back to life if they
+  // were left dangling
+  std::sort(revived.begin(), revived.end());
+  auto revivedPart = [&](uint32_t id) {
+    return std::binary_search(revived.begin(), revived.end(), id);
+  };
+  for (size_t i = 0; i < dangling_wires.size() && !revived.empty(); ++i) {
+    if (dangling_wires[i] >= board.connections.size())
+      continue;
+    const ConnectionRecord &c = board.connections[dangling_wires[i]];
+    if (revivedPart(c.component_a) || revivedPart(c.component_b)) {
+      touch(c.component_a);
+      touch(c.component_b);
+      wires.push_back(dangling_wires[i]);
+    }
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < islands.size(); ++i) {
+    if (!touched[i]) {
+      if (kept != i)
+        islands[kept] = std::move(islands[i]);
+      ++kept;
+      continue;
+    }
+    for (const Element &e : islands[i].elements) {
+      if (alivePart(e.component_id))
+        parts.push_back(e.component_id);
+    }
+    for (uint32_t id : islands[i].wires) {
+      if (id < board.connections.size())
+        wires.push_back(id);
+    }
+    replaced.push_back(std::move(islands[i]));
+  }
+  islands.resize(kept);
+  element_of.resize(board.components.size());
+
+  std::sort(parts.begin(), parts.end());
+  parts.erase(std::unique(parts.begin(), parts.end()), parts.end());
+  std::sort(wires.begin(), wires.end());
+  wires.erase(std::unique(wires.begin(), wires.end()), wires.end());
+}
+
+void ElectronicsSimulation::groupIslands(const BoardState &board,
+                                         const std::vector<uint32_t> &parts,
+                                         const std::vector<uint32_t> &wires) {
+  // Parts being grouped are marked by an index and no island
+  for (size_t k = 0; k < parts.size(); ++k)
+    element_of[parts[k]] = ElementRef{-1, static_cast<int32_t>(k)};
+
+  // Nets: pins joined by wires. Pin k of part i is slot i * 2 + k.
+  const size_t slots = parts.size() * PINS_PER_ELEMENT;
+  std::vector<int32_t> parent(slots);
+  std::iota(parent.begin(), parent.end(), 0);
+
+  auto slotOf = [&](uint32_t component, int16_t pin) -> int32_t {
+    if (component >= element_of.size() || element_of[component].island >= 0 ||
+        element_of[component].index < 0 || pin < 0 ||
+        pin >= PINS_PER_ELEMENT)
+      return -1;
+    return element_of[component].index * PINS_PER_ELEMENT + pin;
+  };
+
+  std::vector<uint32_t> wire_slot(wires.size(), 0);
+  for (size_t w = 0; w < wires.size(); ++w) {
+    const ConnectionRecord &c = board.connections[wires[w]];
+    int32_t a = slotOf(c.component_a, c.pin_a);
+    int32_t b = slotOf(c.component_b, c.pin_b);
+    if (!c.alive || a < 0 || b < 0) {
+      wire_slot[w] = UINT32_MAX;
+      continue;
+    }
+    wire_slot[w] = static_cast<uint32_t>(a);
+    parent[findRoot(parent, a)] = findRoot(parent, b);
+  }
+
+  // Wires regrouped here are dangling again only if they still miss a part
+  std::vector<uint32_t> dangling;
+  std::set_difference(dangling_wires.begin(), dangling_wires.end(),
+                      wires.begin(), wires.end(),
+                      std::back_inserter(dangling));
+  for (size_t w = 0; w < wires.size(); ++w) {
+    if (wire_slot[w] == UINT32_MAX && board.connections[wires[w]].alive)
+      dangling.push_back(wires[w]);
+  }
+  std::sort(dangling.begin(), dangling.end());
+  dangling_wires = std::move(dangling);
+
+  std::vector<int32_t> net_of_root(slots, -1);
+  int32_t net_count = 0;
+  for (size_t i = 0; i < slots; ++i) {
+    int32_t root = findRoot(parent, static_cast<int32_t>(i));
+    if (net_of_root[root] < 0)
+      net_of_root[root] = net_count++;
+  }
+  auto netOf = [&](size_t slot) {
+    return net_of_root[findRoot(parent, static_cast<int32_t>(slot))];
+  };
+
+  // Islands: nets joined by parts, numbered by their first part
+  std::vector<int32_t> root_of(net_count);
+  std::iota(root_of.begin(), root_of.end(), 0);
+  for (size_t k = 0; k < parts.size(); ++k) {
+    int32_t a = netOf(k * PINS_PER_ELEMENT);
+    int32_t b = netOf(k * PINS_PER_ELEMENT + 1);
+    root_of[findRoot(root_of, a)] = findRoot(root_of, b);
+  }
+
+  const size_t first_island = islands.size();
+  std::vector<int32_t> island_of_root(net_count, -1);
+  std::vector<int32_t> island_of(parts.size());
+  for (size_t k = 0; k < parts.size(); ++k) {
+    int32_t &island = island_of_root[findRoot(
+        root_of, netOf(k * PINS_PER_ELEMENT))];
+    if (island < 0) {
+      island = static_cast<int32_t>(islands.size());
+      islands.emplace_back();
+    }
+    island_of[k] = island;
+  }
+
+  // Island nets are numbered in order of first use, which keeps the order
+  // of the board-wide nets
+  std::vector<int32_t> local_net(net_count, -1);
+  for (size_t k = 0; k < parts.size(); ++k) {
+    const ComponentRecord &rec = board.components[parts[k]];
+    Island &island = islands[island_of[k]];
+
+    Element e;
+    e.component_id = parts[k];
+    e.kind = rec.label;
+    e.voltage = rec.voltage;
+    e.resistance = rec.resistance;
+    e.rated_current = rec.current;
+    int32_t *nodes[PINS_PER_ELEMENT] = {&e.node_a, &e.node_b};
+    for (int pin = 0; pin < PINS_PER_ELEMENT; ++pin) {
+      int32_t net = netOf(k * PINS_PER_ELEMENT + pin);
+      if (local_net[net] < 0)
+        local_net[net] = island.net_count++;
+      *nodes[pin] = local_net[net];
+    }
+
+    element_of[e.component_id] =
+        ElementRef{island_of[k], static_cast<int32_t>(island.elements.size())};
+    island.elements.push_back(e);
+  }
+  for (size_t w = 0; w < wires.size(); ++w) {
+    if (wire_slot[w] != UINT32_MAX)
+      islands[island_of[wire_slot[w] / PINS_PER_ELEMENT]].wires.push_back(
+          wires[w]);
+  }
+
+  for (size_t i = first_island; i < islands.size(); ++i)
+    buildNodes(islands[i]);
+}
+
+void ElectronicsSimulation::buildNodes(Island &island) {
+  markLiveElements(island);
+
+  // Loops: nets joined by live elements. Each needs one reference net at
+  // 0 V, its first battery's negative terminal. Nets off every loop get no
+  // matrix row.
+  std::vector<int32_t> loop(island.net_count);
+  std::iota(loop.begin(), loop.end(), 0);
+  std::vector<char> on_loop(island.net_count, 0);
+  for (const Element &e : island.elements) {
+    if (!e.live)
+      continue;
+    loop[findRoot(loop, e.node_a)] = findRoot(loop, e.node_b);
+    on_loop[e.node_a] = on_loop[e.node_b] = 1;
+  }
+  std::vector<int32_t> reference(island.net_count, -1);
+  for (const Element &e : island.elements) {
+    int32_t root = findRoot(loop, e.node_b);
+    if (e.live && e.kind == ComponentLabel::Battery && reference[root] < 0)
+      reference[root] = e.node_b;
+  }
+
+  island.node_unknown.assign(island.net_count, -1);
+  int32_t rows = 0;
+  for (int32_t net = 0; net < island.net_count; ++net) {
+    if (on_loop[net] && reference[findRoot(loop, net)] != net)
+      island.node_unknown[net] = rows++;
+  }
+  island.matrix.n = rows;
+  island.node_voltage.assign(island.net_count, 0.0);
+
+  island.shape = FNV_BASIS;
+  for (Element &e : island.elements) {
+    e.row_a = e.live ? island.node_unknown[e.node_a] : -1;
+    e.row_b = e.live ? island.node_unknown[e.node_b] : -1;
+    hashWord(island.shape, e.component_id);
+    hashWord(island.shape, static_cast<uint32_t>(e.kind));
+    hashWord(island.shape, static_cast<uint32_t>(e.node_a));
+    hashWord(island.shape, static_cast<uint32_t>(e.node_b));
+  }
+
+  // Board voltages are spread from the island's reference, its first
+  // battery's negative terminal or else its net 0, along a spanning tree
+  int32_t root = 0;
+  for (const Element &e : island.elements) {
+    if (e.kind == ComponentLabel::Battery) {
+      root = e.node_b;
+      break;
+    }
+  }
+  std::vector<int32_t> start(island.net_count + 1, 0);
+  for (const Element &e : island.elements) {
+    ++start[e.node_a + 1];
+    ++start[e.node_b + 1];
+  }
+  for (int32_t net = 0; net < island.net_count; ++net)
+    start[net + 1] += start[net];
+  std::vector<int32_t> incident(start.back());
+  std::vector<int32_t> fill(start.begin(), start.end() - 1);
+  for (size_t i = 0; i < island.elements.size(); ++i) {
+    incident[fill[island.elements[i].node_a]++] = static_cast<int32_t>(i);
+    incident[fill[island.elements[i].node_b]++] = static_cast<int32_t>(i);
+  }
+
+  island.reach_net.assign(1, root);
+  island.reach_element.assign(1, -1);
+  std::vector<char> reached(island.net_count, 0);
+  reached[root] = 1;
+  for (size_t head = 0; head < island.reach_net.size(); ++head) {
+    int32_t net = island.reach_net[head];
+    for (int32_t k = start[net]; k < start[net + 1]; ++k) {
+      const Element &e = island.elements[incident[k]];
+      int32_t other = e.node_a == net ? e.node_b : e.node_a;
+      if (reached[other])
+        continue;
+      reached[other] = 1;
+      island.reach_net.push_back(other);
+      island.reach_element.push_back(incident[k]);
+    }
+  }
+}
+
+// Elements on a closed loop through a battery are the ones in a biconnected
+// block of the net graph that holds a battery and more than one element.
+// Blocks are found with Tarjan's algorithm, iteratively.
+void ElectronicsSimulation::markLiveElements(Island &island) {
+  const int32_t nets = island.net_count;
+  std::vector<int32_t> start(nets + 1, 0);
+  for (const Element &e : island.elements) {
+    if (e.node_a != e.node_b) {
+      ++start[e.node_a + 1];
+      ++start[e.node_b + 1];
+    }
+  }
+  for (int32_t net = 0; net < nets; ++net)
+    start[net + 1] += start[net];
+  std::vector<int32_t> to(start.back()), via(start.back());
+  std::vector<int32_t> next(start.begin(), start.end() - 1);
+  for (size_t i = 0; i < island.elements.size(); ++i) {
+    Element &e = island.elements[i];
+    e.live = false;
+    if (e.node_a == e.node_b)
+      continue;
+    to[next[e.node_a]] = e.node_b;
+    via[next[e.node_a]++] = static_cast<int32_t>(i);
+    to[next[e.node_b]] = e.node_a;
+    via[next[e.node_b]++] = static_cast<int32_t>(i);
+  }
+  std::copy(start.begin(), start.end() - 1, next.begin());
+
+  struct Frame {
+    int32_t net;
+    int32_t via; // element it was reached through, -1 for a root
+  };
+  std::vector<int32_t> order(nets, -1), low(nets, 0);
+  std::vector<Frame> path;
+  std::vector<int32_t> block; // elements of the blocks still open
+  int32_t time = 0;
+  for (int32_t root = 0; root < nets; ++root) {
+    if (order[root] >= 0)
+      continue;
+    order[root] = low[root] = time++;
+    path.push_back({root, -1});
+    while (!path.empty()) {
+      const Frame top = path.back();
+      int32_t u = top.net;
+      if (next[u] < start[u + 1]) {
+        int32_t k = next[u]++;
+        int32_t v = to[k];
+        if (via[k] == top.via)
+          continue;
+        if (order[v] < 0) {
+          block.push_back(via[k]);
+          order[v] = low[v] = time++;
+          path.push_back({v, via[k]});
+        } else if (order[v] < order[u]) {
+          block.push_back(via[k]);
+          low[u] = std::min(low[u], order[v]);
+        }
+        continue;
+      }
+
+      path.pop_back();
+      if (path.empty())
+        break;
+      int32_t p = path.back().net;
+      low[p] = std::min(low[p], low[u]);
+      if (low[u] < order[p])
+        continue;
+
+      // `p` cuts off the block closed by the element `u` was reached through
+      size_t begin = block.size();
+      do {
+        --begin;
+      } while (block[begin] != top.via);
+      bool battery = false;
+      for (size_t i = begin; i < block.size(); ++i)
+        battery |= island.elements[block[i]].kind == ComponentLabel::Battery;
+      if (battery && block.size() - begin > 1) {
+        for (size_t i = begin; i < block.size(); ++i)
+          island.elements[block[i]].live = true;
+      }
+      block.resize(begin);
+    }
+  }
+}
+
+void ElectronicsSimulation::orderIslands() {
+  // By first part, as a full build numbers them
+  std::sort(islands.begin(), islands.end(),
+            [](const Island &a, const Island &b) {
+              return a.elements.front().component_id <
+                     b.elements.front().component_id;
+            });
+
+  int32_t first_net = 0;
+  for (size_t i = 0; i < islands.size(); ++i) {
+    Island &island = islands[i];
+    island.first_net = first_net;
+    first_net += island.net_count;
+    for (size_t k = 0; k < island.elements.size(); ++k)
+      element_of[island.elements[k].component_id] =
+          ElementRef{static_cast<int32_t>(i), static_cast<int32_t>(k)};
+  }
+}
+
+void ElectronicsSimulation::reuseIslands(std::vector<Island> &previous) {
+  if (previous.empty())
+    return;
+
+  std::unordered_map<uint64_t, size_t> by_shape;
+  by_shape.reserve(previous.size());
+  for (size_t i = 0; i < previous.size(); ++i)
+    by_shape.emplace(previous[i].shape, i);
+
+  for (Island &island : islands) {
+    auto found = by_shape.find(island.shape);
+    if (found == by_shape.end())
+      continue;
+    Island &old = previous[found->second];
+    by_shape.erase(found);
+    if (old.elements.size() != island.elements.size() ||
+        old.net_count != island.net_count)
+      continue;
+
+    bool same_shape = true;
+    bool same_values = old.solved;
+    for (size_t k = 0; k < island.elements.size() && same_shape; ++k) {
+      const Element &a = old.elements[k];
+      const Element &b = island.elements[k];
+      same_shape = a.component_id == b.component_id && a.kind == b.kind &&
+                   a.node_a == b.node_a && a.node_b == b.node_b;
+      same_values = same_values && a.voltage == b.voltage &&
+                    a.resistance == b.resistance &&
+                    a.rated_current == b.rated_current;
+    }
+    if (!same_shape)
+      continue;
+
+    // Same pattern: keep the matrix and its factorization. Same values too:
+    // keep the results, the island needs no solve.
+    island.matrix = std::move(old.matrix);
+    island.factor = std::move(old.factor);
+    island.iterative = old.iterative;
+    island.krylov = std::move(old.krylov);
+    island.solution = std::move(old.solution);
+    island.rhs = std::move(old.rhs);
+    if (same_values) {
+      island.elements = std::move(old.elements);
+      island.node_voltage = std::move(old.node_voltage);
+      island.iterations = old.iterations;
+      island.residual = old.residual;
+      island.condition = old.condition;
+      island.solved = true;
+    } else {
+      for (size_t k = 0; k < island.elements.size(); ++k) {
+        Element &e = island.elements[k];
+        const Element &o = old.elements[k];
+        e.slot_aa = o.slot_aa;
+        e.slot_bb = o.slot_bb;
+        e.slot_ab = o.slot_ab;
+        e.slot_ba = o.slot_ba;
+      }
+    }
+  }
+}
+
+void ElectronicsSimulation::prepareIslands() {
+  pending.clear();
+  for (size_t i = 0; i < islands.size(); ++i) {
+    if (!islands[i].solved)
+      pending.push_back(static_cast<uint32_t>(i));
+  }
+
+  // Islands found in the cache are done; the rest get their pattern
+  std::atomic<size_t> hits{0};
+  auto prepare = [&](size_t i) {
+    Island &island = islands[pending[i]];
+    if (solution_cache) {
+      canonicalize(island);
+      if (loadCached(island, *solution_cache)) {
+        ++hits;
+        return;
+      }
+    }
+    if (!island.factor.analyzed() && island.matrix.n > 0)
+      buildPattern(island, solver_backend);
+  };
+  if (pending.size() == 1)
+    prepare(0);
+  else if (!pending.empty())
+    threadPool().parallelFor(pending.size(), prepare);
+  last_stats.cache_hits = hits;
+}
+
+// Element labels and the colour refinement rounds at most, which is enough
+// to tell apart the nets of most circuits; nets it leaves tied are ordered
+// as they were built
+static constexpr int CANONICAL_ROUNDS = 4;
+
+// A full 64-bit mix, far cheaper than FNV over the bytes
+static uint64_t mixWords(uint64_t a, uint64_t b) {
+  uint64_t hash = a ^ (b * 0x9e3779b97f4a7c15ull + (a << 6) + (a >> 2));
+  hash ^= hash >> 31;
+  hash *= 0xbf58476d1ce4e5b9ull;
+  hash ^= hash >> 27;
+  hash *= 0x94d049bb133111ebull;
+  return hash ^ (hash >> 31);
+}
+
+static uint32_t floatBits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+// Parts whose pins can be swapped without changing the circuit
+static bool symmetricPart(ComponentLabel kind) {
+  return kind != ComponentLabel::Battery && kind != ComponentLabel::Led;
+}
+
+void ElectronicsSimulation::canonicalize(Island &island) {
+  PROFILE_ZONE("simulation.canonicalize");
+  const size_t count = island.elements.size();
+  const int32_t nets = island.net_count;
+
+  std::vector<uint64_t> label(count);
+  for (size_t i = 0; i < count; ++i) {
+    const Element &e = island.elements[i];
+    uint64_t hash = mixWords(static_cast<uint64_t>(e.kind),
+                             floatBits(e.voltage));
+    hash = mixWords(hash, floatBits(e.resistance));
+    label[i] = mixWords(hash, floatBits(e.rated_current));
+  }
+
+  // Each round a net's colour takes in its parts' labels, the pin they meet
+  // it by and the colour of the net at their other end. The terms are
+  // summed, so their order doesn't matter and nothing needs sorting.
+  std::vector<uint64_t> color(nets, 0), around(nets);
+  std::vector<uint64_t> distinct;
+  size_t classes = 1;
+  for (int round = 0; round < CANONICAL_ROUNDS && classes < size_t(nets);
+       ++round) {
+    std::fill(around.begin(), around.end(), 0);
+    for (size_t i = 0; i < count; ++i) {
+      const Element &e = island.elements[i];
+      bool symmetric = symmetricPart(e.kind);
+      around[e.node_a] +=
+          mixWords(label[i] + (symmetric ? 2 : 0), color[e.node_b]);
+      around[e.node_b] +=
+          mixWords(label[i] + (symmetric ? 2 : 1), color[e.node_a]);
+    }
+    for (int32_t net = 0; net < nets; ++net)
+      color[net] = mixWords(color[net], around[net]);
+
+    distinct = color;
+    std::sort(distinct.begin(), distinct.end());
+    size_t refined = std::unique(distinct.begin(), distinct.end()) -
+                     distinct.begin();
+    if (refined == classes)
+      break;
+    classes = refined;
+  }
+
+  std::vector<int32_t> order(nets);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](int32_t a, int32_t b) {
+    return color[a] != color[b] ? color[a] < color[b] : a < b;
+  });
+  island.canonical_net.assign(nets, 0);
+  for (int32_t k = 0; k < nets; ++k)
+    island.canonical_net[order[k]] = k;
+
+  // Parts by label, then canonical nets, pins of symmetric parts in order
+  auto canonicalPins = [&](const Element &e) {
+    int32_t a = island.canonical_net[e.node_a];
+    int32_t b = island.canonical_net[e.node_b];
+    if (symmetricPart(e.kind) && b < a)
+      std::swap(a, b);
+    return std::make_pair(a, b);
+  };
+  island.canonical_element.resize(count);
+  std::iota(island.canonical_element.begin(), island.canonical_element.end(),
+            0);
+  std::sort(island.canonical_element.begin(), island.canonical_element.end(),
+            [&](int32_t a, int32_t b) {
+              if (label[a] != label[b])
+                return label[a] < label[b];
+              auto pins_a = canonicalPins(island.elements[a]);
+              auto pins_b = canonicalPins(island.elements[b]);
+              return pins_a != pins_b ? pins_a < pins_b : a < b;
+            });
+
+  island.form.clear();
+  island.form.reserve(2 + 6 * count);
+  island.form.push_back(static_cast<uint32_t>(nets));
+  island.form.push_back(static_cast<uint32_t>(count));
+  for (int32_t i : island.canonical_element) {
+    const Element &e = island.elements[i];
+    auto pins = canonicalPins(e);
+    island.form.push_back(static_cast<uint32_t>(e.kind));
+    island.form.push_back(floatBits(e.voltage));
+    island.form.push_back(floatBits(e.resistance));
+    island.form.push_back(floatBits(e.rated_current));
+    island.form.push_back(static_cast<uint32_t>(pins.first));
+    island.form.push_back(static_cast<uint32_t>(pins.second));
+  }
+  island.form_hash = FNV_BASIS;
+  for (uint32_t word : island.form)
+    island.form_hash = mixWords(island.form_hash, word);
+}
+
+bool ElectronicsSimulation::loadCached(Island &island, SolutionCache &cache) {
+  SolutionCache::Entry entry;
+  if (!cache.find(island.form_hash, island.form, entry))
+    return false;
+
+  // Cached voltages are from any reference; the island's own is at 0 V
+  double reference = entry.voltage[island.canonical_net[island.reach_net[0]]];
+  for (int32_t net = 0; net < island.net_count; ++net)
+    island.node_voltage[net] =
+        entry.voltage[island.canonical_net[net]] - reference;
+  for (size_t k = 0; k < island.canonical_element.size(); ++k)
+    island.elements[island.canonical_element[k]].led_on = entry.led_on[k] != 0;
+
+  storeResults(island);
+  island.iterations = 0;
+  island.solved = true;
+  return true;
+}
+
+void ElectronicsSimulation::storeCached(const Island &island,
+                                        SolutionCache &cache) {
+  SolutionCache::Entry entry;
+  entry.form = island.form;
+  entry.voltage.resize(island.net_count);
+  for (int32_t net = 0; net < island.net_count; ++net)
+    entry.voltage[island.canonical_net[net]] = island.node_voltage[net];
+  entry.led_on.reserve(island.canonical_element.size());
+  for (int32_t i : island.canonical_element)
+    entry.led_on.push_back(island.elements[i].led_on);
+  cache.store(island.form_hash, std::move(entry));
+}
+
+void ElectronicsSimulation::buildPattern(Island &island,
+                                         SolverBackend backend) {
+  SparseMatrix &matrix = island.matrix;
+  const int32_t n = matrix.n;
+
+  std::vector<std::pair<int32_t, int32_t>> entries; // (col, row)
+  entries.reserve(n + 2 * island.elements.size());
+  for (int32_t i = 0; i < n; ++i)
+    entries.emplace_back(i, i);
+  for (const Element &e : island.elements) {
+    if (e.live && e.row_a >= 0 && e.row_b >= 0 && e.row_a != e.row_b) {
+      entries.emplace_back(e.row_a, e.row_b);
+      entries.emplace_back(e.row_b, e.row_a);
+    }
+  }
+  std::sort(entries.begin(), entries.end());
+  entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+  matrix.col_ptr.assign(n + 1, 0);
+  matrix.row_idx.resize(entries.size());
+  matrix.values.assign(entries.size(), 0.0);
+  for (size_t k = 0; k < entries.size(); ++k) {
+    ++matrix.col_ptr[entries[k].first + 1];
+    matrix.row_idx[k] = entries[k].second;
+  }
+  for (int32_t c = 0; c < n; ++c)
+    matrix.col_ptr[c + 1] += matrix.col_ptr[c];
 
-  // TODO:
-  // - Solve linear system
-  // - Write voltages / currents back into pins
+  // Resolve every element's stamp positions once per topology
+  for (Element &e : island.elements) {
+    if (!e.live)
+      continue;
+    if (e.row_a >= 0)
+      e.slot_aa = matrix.find(e.row_a, e.row_a);
+    if (e.row_b >= 0)
+      e.slot_bb = matrix.find(e.row_b, e.row_b);
+    if (e.row_a >= 0 && e.row_b >= 0 && e.row_a != e.row_b) {
+      e.slot_ab = matrix.find(e.row_a, e.row_b);
+      e.slot_ba = matrix.find(e.row_b, e.row_a);
+    }
+  }
+
+  island.rhs.assign(n, 0.0);
+  island.iterative = false;
+  if (n == 0)
+    return;
+
+  // The symbolic analysis predicts the fill without allocating it
+  island.factor.analyze(matrix);
+  island.ordering_ms = island.factor.orderingMs();
+  island.symbolic_ms = island.factor.symbolicMs();
+  island.iterative =
+      backend == SolverBackend::Iterative ||
+      (backend == SolverBackend::Automatic &&
+       island.factor.factorNonZeros() >= ITERATIVE_MIN_FILL);
+  if (island.iterative) {
+    island.krylov.analyze(matrix);
+    island.solution.assign(n, 0.0);
+  }
+}
+
+void ElectronicsSimulation::stampMatrix(Island &island) {
+  SparseMatrix &matrix = island.matrix;
+  std::vector<double> &rhs = island.rhs;
+  std::fill(matrix.values.begin(), matrix.values.end(), 0.0);
+  std::fill(rhs.begin(), rhs.end(), 0.0);
+
+  for (const Element &e : island.elements) {
+    if (!e.live)
+      continue; // off every loop, carries no current
+
+    double g, source;
+    elementModel(e.kind, e.voltage, e.resistance, e.led_on, g, source);
+
+    if (e.row_a >= 0) {
+      matrix.values[e.slot_aa] += g;
+      rhs[e.row_a] += source;
+    }
+    if (e.row_b >= 0) {
+      matrix.values[e.slot_bb] += g;
+      rhs[e.row_b] -= source;
+    }
+    if (e.slot_ab >= 0) {
+      matrix.values[e.slot_ab] -= g;
+      matrix.values[e.slot_ba] -= g;
+    }
+  }
 }
 
-void ElectronicsSimulation::fetchPins(
-    const std::vector<std::shared_ptr<ElectronicComponent>> &objects) {
-  for (const auto &obj : objects) {
-    for (auto &pin : obj->pins) {
-      all_pins.push_back(&pin);
+bool ElectronicsSimulation::updateLedStates(Island &island) {
+  bool changed = false;
+  for (Element &e : island.elements) {
+    if (e.kind != ComponentLabel::Led || !e.live)
+      continue;
+
+    bool on = e.led_on;
+    if (on) {
+      on = elementCurrent(island, e) > 0.0;
+    } else {
+      double v = island.node_voltage[e.node_a] - island.node_voltage[e.node_b];
+      on = v > e.voltage;
+    }
+    if (on != e.led_on) {
+      e.led_on = on;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+double ElectronicsSimulation::elementCurrent(const Island &island,
+                                             const Element &e) {
+  if (!e.live)
+    return 0.0;
+
+  double g, source;
+  elementModel(e.kind, e.voltage, e.resistance, e.led_on, g, source);
+  return g * (island.node_voltage[e.node_a] - island.node_voltage[e.node_b]) -
+         source;
+}
+
+void ElectronicsSimulation::spreadVoltages(Island &island) {
+  // Off the loops no current flows, so an element only drops its source
+  // voltage; on a loop it drops what the solve found
+  island.loop_voltage.swap(island.node_voltage);
+  const std::vector<double> &loop = island.loop_voltage;
+  std::vector<double> &voltage = island.node_voltage;
+  voltage.resize(island.net_count);
+  voltage[island.reach_net[0]] = 0.0;
+  for (size_t i = 1; i < island.reach_net.size(); ++i) {
+    const Element &e = island.elements[island.reach_element[i]];
+    double drop = 0.0; // Va - Vb
+    if (e.live)
+      drop = loop[e.node_a] - loop[e.node_b];
+    else if (e.kind == ComponentLabel::Battery)
+      drop = e.voltage;
+    if (island.reach_net[i] == e.node_b)
+      voltage[e.node_b] = voltage[e.node_a] - drop;
+    else
+      voltage[e.node_a] = voltage[e.node_b] + drop;
+  }
+}
+
+void ElectronicsSimulation::storeResults(Island &island) {
+  for (Element &e : island.elements) {
+    e.current = elementCurrent(island, e);
+    e.damaged = false;
+    e.powered = false;
+    if (e.kind == ComponentLabel::Led) {
+      e.damaged = e.led_on && e.current > LED_DAMAGE_FACTOR * e.rated_current;
+      e.powered = e.led_on && !e.damaged && e.current > LED_MIN_CURRENT;
     }
   }
 }
 
-void ElectronicsSimulation::buildNodes(const std::vector<Wire> &node_edges) {}
+void ElectronicsSimulation::applyResults(ElectronicComponent &obj) const {
+  if (dirty || obj.id >= element_of.size() || element_of[obj.id].island < 0)
+    return;
+
+  const ElementRef ref = element_of[obj.id];
+  const Island &island = islands[ref.island];
+  const Element &e = island.elements[ref.index];
+  const int32_t nodes[PINS_PER_ELEMENT] = {e.node_a, e.node_b};
+  for (size_t k = 0; k < obj.pins.size() && k < PINS_PER_ELEMENT; ++k) {
+    Pin &pin = obj.pins[k];
+    pin.setNodeId(island.first_net + nodes[k]);
+    pin.setVoltage(static_cast<float>(island.node_voltage[nodes[k]]));
+    pin.setCurrent(static_cast<float>(k == 0 ? e.current : -e.current));
+  }
+
+  obj.battery_connected = e.live;
+  if (e.kind == ComponentLabel::Led) {
+    obj.damaged = e.damaged;
+    obj.powered = e.powered;
+  }
+}
+
+bool ElectronicsSimulation::setParameter(uint32_t id, float value) {
+  if (dirty || id >= element_of.size() || element_of[id].island < 0)
+    return false;
+
+  Island &island = islands[element_of[id].island];
+  Element &e = island.elements[element_of[id].index];
+  switch (e.kind) {
+  case ComponentLabel::Battery:
+    e.voltage = value;
+    break;
+  case ComponentLabel::Resistor:
+    e.resistance = value;
+    break;
+  default:
+    return false;
+  }
+  island.solved = false;
+  island.form.clear(); // no longer the board's netlist
+  return true;
+}
+
+double ElectronicsSimulation::componentCurrent(uint32_t id) const {
+  if (dirty || id >= element_of.size() || element_of[id].island < 0)
+    return 0.0;
+  return islands[element_of[id].island].elements[element_of[id].index].current;
+}
+
+int32_t ElectronicsSimulation::islandOf(uint32_t id) const {
+  if (dirty || id >= element_of.size())
+    return -1;
+  return element_of[id].island;
+}
+
+bool ElectronicsSimulation::componentPowered(uint32_t id) const {
+  if (dirty || id >= element_of.size() || element_of[id].island < 0)
+    return false;
+  return islands[element_of[id].island].elements[element_of[id].index].powered;
+}
+
+bool ElectronicsSimulation::componentDamaged(uint32_t id) const {
+  if (dirty || id >= element_of.size() || element_of[id].island < 0)
+    return false;
+  return islands[element_of[id].island].elements[element_of[id].index].damaged;
+}
+
+bool ElectronicsSimulation::onClosedLoop(uint32_t id) const {
+  if (dirty || id >= element_of.size() || element_of[id].island < 0)
+    return false;
+  return islands[element_of[id].island].elements[element_of[id].index].live;
+}
+
+size_t ElectronicsSimulation::nodeCount() const {
+  size_t count = 0;
+  for (const Island &island : islands)
+    count += island.net_count;
+  return count;
+}
+
+size_t ElectronicsSimulation::unknownCount() const {
+  size_t count = 0;
+  for (const Island &island : islands)
+    count += island.matrix.n;
+  return count;
+}
 
-void ElectronicsSimulation::stampMatrix() {}
+size_t ElectronicsSimulation::elementCount() const {
+  size_t count = 0;
+  for (const Island &island : islands)
+    count += island.elements.size();
+  return count;
+}
+
+size_t ElectronicsSimulation::matrixNonZeros() const {
+  size_t count = 0;
+  for (const Island &island : islands)
+    count += island.matrix.nonZeros();
+  return count;
+}
+
+// Of the preconditioner for iterative islands
+size_t ElectronicsSimulation::factorNonZeros() const {
+  size_t count = 0;
+  for (const Island &island : islands)
+    count += island.iterative ? island.krylov.preconditionerNonZeros()
+                              : island.factor.factorNonZeros();
+  return count;
+}
+
+size_t ElectronicsSimulation::iterativeIslandCount() const {
+  size_t count = 0;
+  for (const Island &island : islands)
+    count += island.iterative;
+  return count;
+}
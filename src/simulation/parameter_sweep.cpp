@@ -0,0 +1,130 @@
+#include "../../include/simulation/parameter_sweep.hpp"
+#include "../../include/profiler.hpp"
+#include "../../include/thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+
+// Points solved by one task, after one copy of the simulation. Consecutive
+// points also let LED states carry over, so most points converge at once.
+static constexpr size_t MIN_BLOCK_POINTS = 8;
+
+struct ParameterSweep::Job {
+  ElectronicsSimulation base;
+  Result result;
+  size_t block_points = 0;
+  size_t blocks = 0;
+  std::atomic<bool> cancelled{false};
+  std::atomic<size_t> blocks_left{0};
+};
+
+static void prepare(ParameterSweep::Result &result,
+                    ParameterSweep::Spec spec) {
+  spec.points = std::max(spec.points, 1);
+  if (spec.probes.size() > ParameterSweep::MAX_PROBES)
+    spec.probes.resize(ParameterSweep::MAX_PROBES);
+
+  result.spec = std::move(spec);
+  const ParameterSweep::Spec &s = result.spec;
+  result.values.resize(s.points);
+  for (int i = 0; i < s.points; ++i) {
+    float t = s.points > 1 ? static_cast<float>(i) / (s.points - 1) : 0.0f;
+    result.values[i] = s.from + (s.to - s.from) * t;
+  }
+  result.currents.assign(s.probes.size(), std::vector<float>(s.points, 0.0f));
+}
+
+static void solveBlock(const ElectronicsSimulation &base,
+                       ParameterSweep::Result &result, size_t begin,
+                       size_t end, const std::atomic<bool> &cancelled) {
+  if (cancelled)
+    return;
+  PROFILE_ZONE("ParameterSweep::solveBlock");
+  ElectronicsSimulation sim = base;
+  const ParameterSweep::Spec &spec = result.spec;
+  for (size_t i = begin; i < end && !cancelled; ++i) {
+    if (!sim.setParameter(spec.component_id, result.values[i]))
+      return;
+    sim.solve();
+    for (size_t p = 0; p < spec.probes.size(); ++p)
+      result.currents[p][i] =
+          static_cast<float>(sim.componentCurrent(spec.probes[p]));
+  }
+}
+
+static void findRange(ParameterSweep::Result &result) {
+  result.min_current = 0.0f;
+  result.max_current = 0.0f;
+  for (const std::vector<float> &curve : result.currents) {
+    for (float current : curve) {
+      result.min_current = std::min(result.min_current, current);
+      result.max_current = std::max(result.max_current, current);
+    }
+  }
+}
+
+// Enough blocks to keep every thread busy, none smaller than needed to
+// pay for its copy of the simulation
+static size_t blockPoints(size_t points) {
+  size_t threads = threadPool().size() + 1;
+  size_t per_block = (points + 2 * threads - 1) / (2 * threads);
+  return std::max(per_block, MIN_BLOCK_POINTS);
+}
+
+void ParameterSweep::start(const ElectronicsSimulation &sim, Spec spec) {
+  cancel();
+  finished.reset();
+
+  auto next = std::make_shared<Job>();
+  next->base = sim;
+  prepare(next->result, std::move(spec));
+  size_t points = next->result.values.size();
+  next->block_points = blockPoints(points);
+  next->blocks = (points + next->block_points - 1) / next->block_points;
+  next->blocks_left = next->blocks;
+  job = next;
+
+  // Tasks hold the job, so it outlives a cancelled or destroyed sweep
+  for (size_t b = 0; b < next->blocks; ++b) {
+    threadPool().submit([next, b] {
+      size_t begin = b * next->block_points;
+      size_t end = std::min(begin + next->block_points,
+                            next->result.values.size());
+      solveBlock(next->base, next->result, begin, end, next->cancelled);
+      next->blocks_left--; // the last decrement publishes the results
+    });
+  }
+}
+
+void ParameterSweep::cancel() {
+  if (job)
+    job->cancelled = true;
+  job.reset();
+}
+
+bool ParameterSweep::running() const { return job != nullptr; }
+
+const ParameterSweep::Result *ParameterSweep::result() {
+  if (job && job->blocks_left == 0) {
+    finished = std::make_unique<Result>(std::move(job->result));
+    findRange(*finished);
+    job.reset();
+  }
+  return finished.get();
+}
+
+ParameterSweep::Result ParameterSweep::run(const ElectronicsSimulation &sim,
+                                           Spec spec) {
+  Result result;
+  prepare(result, std::move(spec));
+  size_t points = result.values.size();
+  size_t block_points = blockPoints(points);
+  size_t blocks = (points + block_points - 1) / block_points;
+  std::atomic<bool> cancelled{false};
+  threadPool().parallelFor(blocks, [&](size_t b) {
+    size_t begin = b * block_points;
+    solveBlock(sim, result, begin, std::min(begin + block_points, points),
+               cancelled);
+  });
+  findRange(result);
+  return result;
+}
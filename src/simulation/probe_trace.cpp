@@ -0,0 +1,92 @@
+#include "../../include/simulation/probe_trace.hpp"
+
+#include <algorithm>
+#include <limits>
+
+ProbeTrace::ProbeTrace(uint32_t component_id)
+    : component_id(component_id), buckets(LEVELS * CAPACITY) {}
+
+void ProbeTrace::record(float voltage, float current) {
+  Bucket sample;
+  sample.span[static_cast<size_t>(Channel::Voltage)] = {voltage, voltage};
+  sample.span[static_cast<size_t>(Channel::Current)] = {current, current};
+  ++samples;
+  push(0, sample);
+}
+
+void ProbeTrace::push(size_t level, const Bucket &bucket) {
+  Level &here = levels[level];
+  buckets[level * CAPACITY + here.count % CAPACITY] = bucket;
+  ++here.count;
+  if (level + 1 == LEVELS)
+    return;
+
+  Level &up = levels[level + 1];
+  if (up.pending_count == 0) {
+    up.pending = bucket;
+  } else {
+    for (size_t ch = 0; ch < CHANNELS; ++ch) {
+      Span &span = up.pending.span[ch];
+      span.min = std::min(span.min, bucket.span[ch].min);
+      span.max = std::max(span.max, bucket.span[ch].max);
+    }
+  }
+  if (++up.pending_count == DECIMATION) {
+    up.pending_count = 0;
+    push(level + 1, up.pending);
+  }
+}
+
+void ProbeTrace::clear() {
+  for (Level &level : levels)
+    level = Level{};
+  samples = 0;
+}
+
+void ProbeTrace::envelope(Channel channel, uint64_t window, Span *out,
+                          size_t columns) const {
+  constexpr float INF = std::numeric_limits<float>::infinity();
+  for (size_t c = 0; c < columns; ++c)
+    out[c] = {INF, -INF};
+  window = std::min(window, samples);
+  if (window == 0 || columns == 0)
+    return;
+
+  auto oldest = [&](size_t level) {
+    uint64_t count = levels[level].count;
+    return count > CAPACITY ? count - CAPACITY : 0;
+  };
+
+  // The finest level with at most two buckets per column that still holds
+  // the start of the window
+  uint64_t window_start = samples - window;
+  size_t level = 0;
+  uint64_t width = 1; // samples per bucket
+  while (level + 1 < LEVELS && (window / width > 2 * columns ||
+                                window_start < oldest(level) * width)) {
+    ++level;
+    width *= DECIMATION;
+  }
+
+  // Each bucket goes to the column of its middle sample. The newest samples
+  // aren't in a full bucket of `level` yet, so they come from the finer
+  // levels, at most DECIMATION - 1 buckets from each.
+  size_t ch = static_cast<size_t>(channel);
+  uint64_t from = std::max(window_start / width, oldest(level));
+  for (size_t l = level;; --l) {
+    for (uint64_t b = from; b < levels[l].count; ++b) {
+      uint64_t middle = b * width + width / 2;
+      if (middle < window_start)
+        continue;
+      size_t c = std::min<size_t>((middle - window_start) * columns / window,
+                                  columns - 1);
+      const Span &span = bucket(l, b).span[ch];
+      out[c].min = std::min(out[c].min, span.min);
+      out[c].max = std::max(out[c].max, span.max);
+    }
+    if (l == 0)
+      break;
+    from = levels[l].count * DECIMATION;
+    width /= DECIMATION;
+  }
+}
@@ -0,0 +1,78 @@
+#include "../../include/simulation/solution_cache.hpp"
+
+size_t SolutionCache::sizeOf(const Entry &entry) {
+  return sizeof(Slot) + entry.form.size() * sizeof(uint32_t) +
+         entry.voltage.size() * sizeof(double) + entry.led_on.size();
+}
+
+bool SolutionCache::find(uint64_t hash, const std::vector<uint32_t> &form,
+                         Entry &out) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = by_hash.find(hash);
+  if (found == by_hash.end() || found->second->entry.form != form) {
+    ++miss_count;
+    return false;
+  }
+
+  slots.splice(slots.begin(), slots, found->second);
+  const Entry &entry = found->second->entry;
+  out.voltage = entry.voltage;
+  out.led_on = entry.led_on;
+  ++hit_count;
+  return true;
+}
+
+void SolutionCache::store(uint64_t hash, Entry entry) {
+  size_t size = sizeOf(entry);
+  if (size > budget)
+    return;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = by_hash.find(hash);
+  if (found != by_hash.end()) {
+    used -= sizeOf(found->second->entry);
+    slots.erase(found->second);
+    by_hash.erase(found);
+  }
+
+  slots.push_front(Slot{hash, std::move(entry)});
+  by_hash[hash] = slots.begin();
+  used += size;
+  while (used > budget) {
+    used -= sizeOf(slots.back().entry);
+    by_hash.erase(slots.back().hash);
+    slots.pop_back();
+  }
+}
+
+void SolutionCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  slots.clear();
+  by_hash.clear();
+  used = 0;
+}
+
+size_t SolutionCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return slots.size();
+}
+
+size_t SolutionCache::bytes() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return used;
+}
+
+size_t SolutionCache::hits() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return hit_count;
+}
+
+size_t SolutionCache::misses() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return miss_count;
+}
+
+SolutionCache &solutionCache() {
+  static SolutionCache cache;
+  return cache;
+}
@@ -0,0 +1,72 @@
+#include "../../include/simulation/solver_telemetry.hpp"
+#include "../../include/log.hpp"
+#include <nlohmann/json.hpp>
+
+#include <fstream>
+
+void SolverTelemetry::record(const SolveStats &stats) {
+  SolveStats &slot = ring[next];
+  slot = stats;
+  slot.sequence = next_sequence++;
+  next = (next + 1) % CAPACITY;
+  if (count < CAPACITY)
+    ++count;
+}
+
+void SolverTelemetry::clear() {
+  next = 0;
+  count = 0;
+}
+
+const SolveStats &SolverTelemetry::at(size_t i) const {
+  return ring[(next + CAPACITY - count + i) % CAPACITY];
+}
+
+const SolveStats *SolverTelemetry::latest() const {
+  return count > 0 ? &at(count - 1) : nullptr;
+}
+
+std::string SolverTelemetry::toJson() const {
+  nlohmann::json solves = nlohmann::json::array();
+  for (size_t i = 0; i < count; ++i) {
+    const SolveStats &s = at(i);
+    solves.push_back({
+        {"sequence", s.sequence},
+        {"islands", s.islands},
+        {"islands_solved", s.islands_solved},
+        {"cache_hits", s.cache_hits},
+        {"iterative_islands", s.iterative_islands},
+        {"nodes", s.nodes},
+        {"branches", s.branches},
+        {"unknowns", s.unknowns},
+        {"nnz_matrix", s.matrix_nonzeros},
+        {"nnz_factor", s.factor_nonzeros},
+        {"build_ms", s.build_ms},
+        {"ordering_ms", s.ordering_ms},
+        {"symbolic_ms", s.symbolic_ms},
+        {"numeric_ms", s.numeric_ms},
+        {"solve_ms", s.solve_ms},
+        {"total_ms", s.total_ms},
+        {"iterations", s.iterations},
+        {"krylov_iterations", s.krylov_iterations},
+        {"residual", s.residual},
+        {"condition", s.condition},
+    });
+  }
+  return nlohmann::json{{"solves", solves}}.dump(2);
+}
+
+bool SolverTelemetry::exportJson(const std::string &path) const {
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    LOG_ERROR("Failed to open solver telemetry file: %s", path.c_str());
+    return false;
+  }
+  file << toJson() << '\n';
+  return true;
+}
+
+SolverTelemetry &solverTelemetry() {
+  static SolverTelemetry telemetry;
+  return telemetry;
+}
@@ -0,0 +1,130 @@
+#include "../../include/simulation/sparse_cg.hpp"
+#include <cmath>
+
+void SparseCG::analyze(const SparseMatrix &A) {
+  n = A.n;
+  l_ptr.assign(n + 1, 0);
+  l_row.clear();
+  l_source.clear();
+  for (int32_t col = 0; col < n; ++col) {
+    // Rows are sorted, so the diagonal leads the column's lower part
+    for (int32_t q = A.col_ptr[col]; q < A.col_ptr[col + 1]; ++q) {
+      if (A.row_idx[q] < col)
+        continue;
+      l_row.push_back(A.row_idx[q]);
+      l_source.push_back(q);
+    }
+    l_ptr[col + 1] = static_cast<int32_t>(l_row.size());
+  }
+  l_val.resize(l_row.size());
+  where.assign(n, -1);
+  r.resize(n);
+  z.resize(n);
+  p.resize(n);
+  ap.resize(n);
+}
+
+bool SparseCG::factorize(const SparseMatrix &A) {
+  for (size_t k = 0; k < l_val.size(); ++k)
+    l_val[k] = A.values[l_source[k]];
+
+  // Right-looking Cholesky that drops every update outside A's pattern
+  for (int32_t j = 0; j < n; ++j) {
+    int32_t diag = l_ptr[j];
+    int32_t end = l_ptr[j + 1];
+    if (!(l_val[diag] > 0.0))
+      return false;
+    double pivot = std::sqrt(l_val[diag]);
+    l_val[diag] = pivot;
+    for (int32_t q = diag + 1; q < end; ++q)
+      l_val[q] /= pivot;
+
+    for (int32_t q = diag + 1; q < end; ++q) {
+      int32_t k = l_row[q];
+      for (int32_t t = l_ptr[k]; t < l_ptr[k + 1]; ++t)
+        where[l_row[t]] = t;
+      for (int32_t s = q; s < end; ++s) {
+        int32_t at = where[l_row[s]];
+        if (at >= 0)
+          l_val[at] -= l_val[s] * l_val[q];
+      }
+      for (int32_t t = l_ptr[k]; t < l_ptr[k + 1]; ++t)
+        where[l_row[t]] = -1;
+    }
+  }
+  return true;
+}
+
+void SparseCG::precondition(std::vector<double> &v) const {
+  for (int32_t j = 0; j < n; ++j) {
+    double vj = v[j] / l_val[l_ptr[j]];
+    v[j] = vj;
+    for (int32_t q = l_ptr[j] + 1; q < l_ptr[j + 1]; ++q)
+      v[l_row[q]] -= l_val[q] * vj;
+  }
+  for (int32_t j = n - 1; j >= 0; --j) {
+    double vj = v[j];
+    for (int32_t q = l_ptr[j] + 1; q < l_ptr[j + 1]; ++q)
+      vj -= l_val[q] * v[l_row[q]];
+    v[j] = vj / l_val[l_ptr[j]];
+  }
+}
+
+static void multiply(const SparseMatrix &A, const std::vector<double> &x,
+                     std::vector<double> &out) {
+  for (int32_t col = 0; col < A.n; ++col) {
+    double sum = 0.0;
+    // Symmetric: column `col` is also row `col`
+    for (int32_t q = A.col_ptr[col]; q < A.col_ptr[col + 1]; ++q)
+      sum += A.values[q] * x[A.row_idx[q]];
+    out[col] = sum;
+  }
+}
+
+static double dot(const std::vector<double> &a, const std::vector<double> &b) {
+  double sum = 0.0;
+  for (size_t i = 0; i < a.size(); ++i)
+    sum += a[i] * b[i];
+  return sum;
+}
+
+bool SparseCG::solve(const SparseMatrix &A, const std::vector<double> &b,
+                     std::vector<double> &x) {
+  last_iterations = 0;
+  x.resize(n, 0.0);
+  double limit = TOLERANCE * std::sqrt(dot(b, b));
+
+  multiply(A, x, ap);
+  for (int32_t i = 0; i < n; ++i)
+    r[i] = b[i] - ap[i];
+  if (std::sqrt(dot(r, r)) <= limit)
+    return true;
+
+  z = r;
+  precondition(z);
+  p = z;
+  double rz = dot(r, z);
+  for (int iter = 1; iter <= MAX_ITERATIONS; ++iter) {
+    multiply(A, p, ap);
+    double alpha = rz / dot(p, ap);
+    for (int32_t i = 0; i < n; ++i) {
+      x[i] += alpha * p[i];
+      r[i] -= alpha * ap[i];
+    }
+    last_iterations = iter;
+    double r_norm = std::sqrt(dot(r, r));
+    if (r_norm <= limit)
+      return true;
+    if (!std::isfinite(r_norm))
+      return false;
+
+    z = r;
+    precondition(z);
+    double rz_next = dot(r, z);
+    double beta = rz_next / rz;
+    rz = rz_next;
+    for (int32_t i = 0; i < n; ++i)
+      p[i] = z[i] + beta * p[i];
+  }
+  return false;
+}
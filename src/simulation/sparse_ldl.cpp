@@ -0,0 +1,239 @@
+#include "../../include/simulation/sparse_ldl.hpp"
+#include <algorithm>
+#include <chrono>
+
+int32_t SparseMatrix::find(int32_t row, int32_t col) const {
+  auto first = row_idx.begin() + col_ptr[col];
+  auto last = row_idx.begin() + col_ptr[col + 1];
+  auto it = std::lower_bound(first, last, row);
+  if (it == last || *it != row)
+    return -1;
+  return static_cast<int32_t>(it - row_idx.begin());
+}
+
+// Ordering
+
+// Breadth-first search from `start` over unvisited vertices. Returns the
+// depth of the search and leaves the vertices of the deepest level in `last`.
+static int32_t bfsDepth(const SparseMatrix &A, int32_t start,
+                        const std::vector<char> &visited,
+                        std::vector<int32_t> &stamp, int32_t id,
+                        std::vector<int32_t> &last) {
+  std::vector<int32_t> level = {start};
+  std::vector<int32_t> next;
+  stamp[start] = id;
+  int32_t depth = 0;
+
+  while (true) {
+    next.clear();
+    for (int32_t v : level) {
+      for (int32_t p = A.col_ptr[v]; p < A.col_ptr[v + 1]; ++p) {
+        int32_t u = A.row_idx[p];
+        if (visited[u] || stamp[u] == id)
+          continue;
+        stamp[u] = id;
+        next.push_back(u);
+      }
+    }
+    if (next.empty())
+      break;
+    level.swap(next);
+    ++depth;
+  }
+  last = level;
+  return depth;
+}
+
+// Reverse Cuthill-McKee: keeps the factor's fill inside a narrow envelope,
+// which suits the mostly planar, mesh-like boards players build.
+static std::vector<int32_t> reverseCuthillMcKee(const SparseMatrix &A) {
+  const int32_t n = A.n;
+  std::vector<int32_t> degree(n);
+  for (int32_t v = 0; v < n; ++v)
+    degree[v] = A.col_ptr[v + 1] - A.col_ptr[v];
+
+  std::vector<char> visited(n, 0);
+  std::vector<int32_t> stamp(n, -1);
+  std::vector<int32_t> order;
+  order.reserve(n);
+  std::vector<int32_t> last;
+  std::vector<int32_t> neighbours;
+  int32_t search_id = 0;
+
+  for (int32_t seed = 0; seed < n; ++seed) {
+    if (visited[seed])
+      continue;
+
+    // Pseudo-peripheral start vertex for this connected component
+    int32_t start = seed;
+    int32_t depth = bfsDepth(A, start, visited, stamp, search_id++, last);
+    for (int tries = 0; tries < 8; ++tries) {
+      int32_t candidate = *std::min_element(
+          last.begin(), last.end(),
+          [&](int32_t a, int32_t b) { return degree[a] < degree[b]; });
+      int32_t candidate_depth =
+          bfsDepth(A, candidate, visited, stamp, search_id++, last);
+      if (candidate_depth <= depth)
+        break;
+      start = candidate;
+      depth = candidate_depth;
+    }
+
+    // Cuthill-McKee sweep, neighbours in order of increasing degree
+    size_t head = order.size();
+    order.push_back(start);
+    visited[start] = 1;
+    while (head < order.size()) {
+      int32_t v = order[head++];
+      neighbours.clear();
+      for (int32_t p = A.col_ptr[v]; p < A.col_ptr[v + 1]; ++p) {
+        int32_t u = A.row_idx[p];
+        if (!visited[u]) {
+          visited[u] = 1;
+          neighbours.push_back(u);
+        }
+      }
+      std::sort(neighbours.begin(), neighbours.end(),
+                [&](int32_t a, int32_t b) { return degree[a] < degree[b]; });
+      order.insert(order.end(), neighbours.begin(), neighbours.end());
+    }
+  }
+
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+// Factorization
+
+void SparseLDL::analyze(const SparseMatrix &A) {
+  using Clock = std::chrono::steady_clock;
+  const int32_t n = A.n;
+  auto start = Clock::now();
+  auto sym = std::make_shared<LDLSymbolic>();
+  sym->n = n;
+  sym->perm = reverseCuthillMcKee(A);
+  auto ordered = Clock::now();
+  sym->perm_inv.resize(n);
+  for (int32_t k = 0; k < n; ++k)
+    sym->perm_inv[sym->perm[k]] = k;
+
+  // Elimination tree and column counts of L (Davis, LDL)
+  sym->parent.assign(n, -1);
+  sym->col_ptr.assign(n + 1, 0);
+  lnz.assign(n, 0);
+  flag.assign(n, 0);
+
+  for (int32_t k = 0; k < n; ++k) {
+    flag[k] = k;
+    int32_t kk = sym->perm[k];
+    for (int32_t p = A.col_ptr[kk]; p < A.col_ptr[kk + 1]; ++p) {
+      int32_t i = sym->perm_inv[A.row_idx[p]];
+      if (i >= k)
+        continue;
+      for (; flag[i] != k; i = sym->parent[i]) {
+        if (sym->parent[i] == -1)
+          sym->parent[i] = k;
+        ++lnz[i];
+        flag[i] = k;
+      }
+    }
+  }
+  for (int32_t k = 0; k < n; ++k)
+    sym->col_ptr[k + 1] = sym->col_ptr[k] + lnz[k];
+
+  pattern.resize(n);
+  y.assign(n, 0.0);
+  symbolic = std::move(sym);
+
+  auto done = Clock::now();
+  ordering_ms = std::chrono::duration<double, std::milli>(ordered - start)
+                    .count();
+  symbolic_ms = std::chrono::duration<double, std::milli>(done - ordered)
+                    .count();
+}
+
+bool SparseLDL::factorize(const SparseMatrix &A) {
+  if (!symbolic)
+    return false;
+
+  const LDLSymbolic &sym = *symbolic;
+  const int32_t n = sym.n;
+  li.resize(factorNonZeros());
+  lx.resize(factorNonZeros());
+  d.resize(n);
+
+  for (int32_t k = 0; k < n; ++k) {
+    // Scatter column k of the permuted upper triangle into y and find the
+    // nonzero pattern of row k of L by walking the elimination tree.
+    y[k] = 0.0;
+    int32_t top = n;
+    flag[k] = k;
+    lnz[k] = 0;
+    int32_t kk = sym.perm[k];
+    for (int32_t p = A.col_ptr[kk]; p < A.col_ptr[kk + 1]; ++p) {
+      int32_t i = sym.perm_inv[A.row_idx[p]];
+      if (i > k)
+        continue;
+      y[i] += A.values[p];
+      int32_t len = 0;
+      for (; flag[i] != k; i = sym.parent[i]) {
+        pattern[len++] = i;
+        flag[i] = k;
+      }
+      while (len > 0)
+        pattern[--top] = pattern[--len];
+    }
+
+    // Sparse triangular solve for row k of L and the pivot d[k]
+    d[k] = y[k];
+    y[k] = 0.0;
+    for (; top < n; ++top) {
+      int32_t i = pattern[top];
+      double yi = y[i];
+      y[i] = 0.0;
+      int32_t p = sym.col_ptr[i];
+      int32_t p2 = p + lnz[i];
+      for (; p < p2; ++p)
+        y[li[p]] -= lx[p] * yi;
+      double l_ki = yi / d[i];
+      d[k] -= l_ki * yi;
+      li[p] = k;
+      lx[p] = l_ki;
+      ++lnz[i];
+    }
+    if (d[k] == 0.0)
+      return false;
+  }
+  return true;
+}
+
+void SparseLDL::solve(std::vector<double> &b) {
+  const LDLSymbolic &sym = *symbolic;
+  const int32_t n = sym.n;
+
+  for (int32_t k = 0; k < n; ++k)
+    y[k] = b[sym.perm[k]];
+
+  for (int32_t j = 0; j < n; ++j) {
+    double yj = y[j];
+    for (int32_t p = sym.col_ptr[j]; p < sym.col_ptr[j + 1]; ++p)
+      y[li[p]] -= lx[p] * yj;
+  }
+  for (int32_t j = 0; j < n; ++j)
+    y[j] /= d[j];
+  for (int32_t j = n - 1; j >= 0; --j) {
+    double yj = y[j];
+    for (int32_t p = sym.col_ptr[j]; p < sym.col_ptr[j + 1]; ++p)
+      yj -= lx[p] * y[li[p]];
+    y[j] = yj;
+  }
+
+  for (int32_t k = 0; k < n; ++k) {
+    b[sym.perm[k]] = y[k];
+    y[k] = 0.0; // factorize() expects a zeroed workspace
+  }
+}
+
+size_t SparseLDL::factorNonZeros() const {
+  return symbolic ? static_cast<size_t>(symbolic->col_ptr[symbolic->n]) : 0;
+}
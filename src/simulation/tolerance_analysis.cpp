@@ -0,0 +1,124 @@
+#include "../../include/simulation/tolerance_analysis.hpp"
+#include "../../include/profiler.hpp"
+#include "../../include/thread_pool.hpp"
+#include <algorithm>
+#include <random>
+
+// Trials per task. Fixed, so the random streams don't depend on the thread
+// count; large enough to pay for the block's copy of the simulation.
+static constexpr int TRIALS_PER_BLOCK = 32;
+static constexpr float TOLERANCE =
+    static_cast<float>(ElectronicsSimulation::RESISTOR_TOLERANCE);
+
+namespace {
+
+struct LedTally {
+  int powered = 0;
+  int damaged = 0;
+  float min_current = 0.0f;
+  float max_current = 0.0f;
+  double sum_current = 0.0;
+};
+
+struct BlockTally {
+  int trials = 0;
+  int trials_with_damage = 0;
+  int trials_all_powered = 0;
+  std::vector<LedTally> leds;
+};
+
+// Uniform in [-1, 1). mt19937's output is fixed by the standard but the std
+// distributions are not.
+float signedUnitRandom(std::mt19937 &rng) {
+  return static_cast<float>(rng() >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+} // namespace
+
+ToleranceAnalysis::Report
+ToleranceAnalysis::run(const ElectronicsSimulation &sim,
+                       const BoardState &board, const Options &options) {
+  PROFILE_ZONE("ToleranceAnalysis::run");
+  Report report;
+  report.trials = std::max(options.trials, 0);
+
+  std::vector<uint32_t> resistors;
+  for (uint32_t id = 0; id < board.components.size(); ++id) {
+    const ComponentRecord &rec = board.components[id];
+    if (!rec.alive)
+      continue;
+    if (rec.label == ComponentLabel::Resistor) {
+      resistors.push_back(id);
+    } else if (rec.label == ComponentLabel::Led) {
+      LedStats led;
+      led.component_id = id;
+      led.nominal_powered = sim.componentPowered(id);
+      led.nominal_damaged = sim.componentDamaged(id);
+      report.leds.push_back(led);
+    }
+  }
+
+  int blocks = (report.trials + TRIALS_PER_BLOCK - 1) / TRIALS_PER_BLOCK;
+  std::vector<BlockTally> tallies(blocks);
+  threadPool().parallelFor(blocks, [&](size_t block) {
+    PROFILE_ZONE("ToleranceAnalysis::block");
+    BlockTally &tally = tallies[block];
+    tally.trials = std::min(TRIALS_PER_BLOCK,
+                            report.trials - static_cast<int>(block) *
+                                                TRIALS_PER_BLOCK);
+    tally.leds.resize(report.leds.size());
+
+    std::seed_seq seed{options.seed, static_cast<uint32_t>(block)};
+    std::mt19937 rng(seed);
+    ElectronicsSimulation trial = sim;
+    for (int t = 0; t < tally.trials; ++t) {
+      for (uint32_t id : resistors) {
+        float scale = 1.0f + TOLERANCE * signedUnitRandom(rng);
+        trial.setParameter(id, board.components[id].resistance * scale);
+      }
+      trial.solve();
+
+      bool any_damaged = false;
+      bool all_powered = true;
+      for (size_t i = 0; i < report.leds.size(); ++i) {
+        uint32_t id = report.leds[i].component_id;
+        LedTally &led = tally.leds[i];
+        float current = static_cast<float>(trial.componentCurrent(id));
+        bool powered = trial.componentPowered(id);
+        bool damaged = trial.componentDamaged(id);
+        led.powered += powered;
+        led.damaged += damaged;
+        led.min_current = t ? std::min(led.min_current, current) : current;
+        led.max_current = t ? std::max(led.max_current, current) : current;
+        led.sum_current += current;
+        any_damaged |= damaged;
+        all_powered &= powered;
+      }
+      tally.trials_with_damage += any_damaged;
+      tally.trials_all_powered += all_powered;
+    }
+  });
+
+  // Merged in block order, so the sums round the same way every run
+  for (int b = 0; b < blocks; ++b) {
+    const BlockTally &tally = tallies[b];
+    report.trials_with_damage += tally.trials_with_damage;
+    report.trials_all_powered += tally.trials_all_powered;
+    for (size_t i = 0; i < report.leds.size(); ++i) {
+      LedStats &led = report.leds[i];
+      const LedTally &part = tally.leds[i];
+      led.powered += part.powered;
+      led.damaged += part.damaged;
+      led.min_current = b ? std::min(led.min_current, part.min_current)
+                          : part.min_current;
+      led.max_current = b ? std::max(led.max_current, part.max_current)
+                          : part.max_current;
+      led.mean_current += part.sum_current;
+    }
+  }
+  for (LedStats &led : report.leds) {
+    if (report.trials > 0)
+      led.mean_current /= report.trials;
+  }
+  return report;
+}
@@ -0,0 +1,90 @@
+#include "../include/spatial_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void SpatialGrid::clear() {
+  entries.clear();
+  cells.clear();
+  oversized.clear();
+}
+
+SpatialGrid::CellRange SpatialGrid::cellRange(Rectangle bounds) const {
+  return {
+      (int)std::floor(bounds.x / cell_size),
+      (int)std::floor(bounds.y / cell_size),
+      (int)std::floor((bounds.x + bounds.width) / cell_size),
+      (int)std::floor((bounds.y + bounds.height) / cell_size),
+  };
+}
+
+void SpatialGrid::update(uint32_t id, Rectangle bounds) {
+  if (entries.size() <= id)
+    entries.resize(id + 1);
+
+  Entry &entry = entries[id];
+  CellRange range = cellRange(bounds);
+  if (entry.alive && entry.cells == range) {
+    // Moved within the same cells, the common case while dragging
+    entry.bounds = bounds;
+    return;
+  }
+
+  if (entry.alive)
+    unlink(id);
+  entry.bounds = bounds;
+  entry.cells = range;
+  entry.alive = true;
+  link(id);
+}
+
+void SpatialGrid::remove(uint32_t id) {
+  if (!contains(id))
+    return;
+  unlink(id);
+  entries[id].alive = false;
+}
+
+void SpatialGrid::link(uint32_t id) {
+  Entry &entry = entries[id];
+  entry.oversized = entry.cells.count() > OVERSIZED_CELLS;
+  if (entry.oversized) {
+    oversized.push_back(id);
+    return;
+  }
+  for (int y = entry.cells.y0; y <= entry.cells.y1; ++y)
+    for (int x = entry.cells.x0; x <= entry.cells.x1; ++x)
+      cells[cellKey(x, y)].push_back(id);
+}
+
+static void eraseId(std::vector<uint32_t> &ids, uint32_t id) {
+  auto it = std::find(ids.begin(), ids.end(), id);
+  if (it == ids.end())
+    return;
+  *it = ids.back();
+  ids.pop_back();
+}
+
+void SpatialGrid::unlink(uint32_t id) {
+  const Entry &entry = entries[id];
+  if (entry.oversized) {
+    eraseId(oversized, id);
+    return;
+  }
+  for (int y = entry.cells.y0; y <= entry.cells.y1; ++y) {
+    for (int x = entry.cells.x0; x <= entry.cells.x1; ++x) {
+      auto it = cells.find(cellKey(x, y));
+      if (it == cells.end())
+        continue;
+      eraseId(it->second, id);
+      // Empty vectors are kept: the cell is likely to be reused
+    }
+  }
+}
+
+bool SpatialGrid::visit(uint32_t id) const {
+  if (visited[id] == query_stamp)
+    return false;
+  visited[id] = query_stamp;
+  return true;
+}
@@ -0,0 +1,266 @@
+#include "../include/text_renderer.hpp"
+#include "../include/log.hpp"
+#include "../include/profiler.hpp"
+#include "../include/resource_pack.hpp"
+#include "../include/ui_utils.hpp"
+#include "rlgl.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct GlyphQuad {
+  Rectangle src;
+  Rectangle dst;
+};
+
+// Quads relative to the text origin
+struct TextRun {
+  std::vector<GlyphQuad> quads;
+  float width = 0.0f;
+};
+
+struct QueuedQuad {
+  Rectangle src;
+  Rectangle dst;
+  Color color;
+};
+
+struct BakedFont {
+  Font font = {};
+  bool owned = false;         // false for raylib's default font
+  std::array<int, 128> ascii; // codepoint -> glyph index, -1 if missing
+  std::vector<QueuedQuad> queue;
+};
+
+// Raylib's default font is a 10px bitmap font that it scales at draw time
+constexpr int DEFAULT_FONT_SIZE = 10;
+
+std::string font_path;
+bool ttf_failed = false;
+std::unordered_map<int, BakedFont> fonts; // by pixel size, 0 = default font
+// Shaped labels by pixel size, then by text. Keyed by content, not by
+// pointer: menus rebuild their strings on every visit.
+std::unordered_map<int, std::unordered_map<std::string, TextRun>> labels;
+std::string label_key; // reused by labelRun() so lookups don't allocate
+LayoutStamp font_stamp;
+TextRun scratch_run; // reused by Draw() so dynamic text doesn't allocate
+
+void unloadFonts() {
+  for (auto &[size, baked] : fonts) {
+    if (baked.owned)
+      UnloadFont(baked.font);
+  }
+  fonts.clear();
+  labels.clear();
+}
+
+void indexGlyphs(BakedFont &baked) {
+  baked.ascii.fill(-1);
+  for (int i = 0; i < baked.font.glyphCount; ++i) {
+    int cp = baked.font.glyphs[i].value;
+    if (cp >= 0 && cp < (int)baked.ascii.size())
+      baked.ascii[cp] = i;
+  }
+}
+
+// The atlas for `fontSize`, and the scale from atlas pixels to screen
+BakedFont &fontFor(int fontSize, float &scale) {
+  // Atlases are baked for the current screen scale's sizes
+  if (font_stamp.refresh())
+    unloadFonts();
+
+  if (!font_path.empty() && !ttf_failed) {
+    auto it = fonts.find(fontSize);
+    if (it == fonts.end()) {
+      PROFILE_ZONE("TextRenderer::bake");
+      ResourcePack::View packed;
+      Font font = ResourcePack::Find(font_path, packed)
+                      ? LoadFontFromMemory(".ttf", packed.data,
+                                           static_cast<int>(packed.size),
+                                           fontSize, nullptr, 0)
+                      : LoadFontEx(font_path.c_str(), fontSize, nullptr, 0);
+      if (font.texture.id != 0 && font.glyphCount > 0) {
+        SetTextureFilter(font.texture, TEXTURE_FILTER_BILINEAR);
+        BakedFont &baked = fonts[fontSize];
+        baked.font = font;
+        baked.owned = true;
+        indexGlyphs(baked);
+        it = fonts.find(fontSize);
+      } else {
+        LOG_WARN("Failed to bake font %s, using the default font",
+                 font_path.c_str());
+        ttf_failed = true;
+      }
+    }
+    if (it != fonts.end()) {
+      scale = 1.0f;
+      return it->second;
+    }
+  }
+
+  auto it = fonts.find(0);
+  if (it == fonts.end()) {
+    BakedFont &baked = fonts[0];
+    baked.font = GetFontDefault();
+    indexGlyphs(baked);
+    it = fonts.find(0);
+  }
+  scale = (float)std::max(fontSize, DEFAULT_FONT_SIZE) /
+          it->second.font.baseSize;
+  return it->second;
+}
+
+int glyphIndex(const BakedFont &baked, int codepoint) {
+  if (codepoint >= 0 && codepoint < (int)baked.ascii.size() &&
+      baked.ascii[codepoint] >= 0)
+    return baked.ascii[codepoint];
+  return GetGlyphIndex(baked.font, codepoint);
+}
+
+// Same placement as raylib's DrawTextEx()
+void shape(const BakedFont &baked, float scale, int fontSize,
+           const char *text, TextRun &run) {
+  run.quads.clear();
+  run.width = 0.0f;
+  const Font &font = baked.font;
+  if (font.glyphCount == 0)
+    return;
+
+  int size = std::max(fontSize, baked.owned ? 1 : DEFAULT_FONT_SIZE);
+  float spacing = baked.owned ? 0.0f : (float)(size / DEFAULT_FONT_SIZE);
+  float pad = (float)font.glyphPadding;
+  float x = 0.0f;
+  float y = 0.0f;
+
+  for (const char *p = text; *p;) {
+    int bytes = 0;
+    int codepoint = GetCodepointNext(p, &bytes);
+    p += bytes > 0 ? bytes : 1;
+
+    if (codepoint == '\n') {
+      run.width = std::max(run.width, x - spacing);
+      x = 0.0f;
+      y += size + size / 5;
+      continue;
+    }
+
+    int i = glyphIndex(baked, codepoint);
+    const Rectangle &rec = font.recs[i];
+    const GlyphInfo &glyph = font.glyphs[i];
+    if (codepoint != ' ' && codepoint != '\t') {
+      run.quads.push_back({
+          {rec.x - pad, rec.y - pad, rec.width + 2 * pad,
+           rec.height + 2 * pad},
+          {x + (glyph.offsetX - pad) * scale, y + (glyph.offsetY - pad) * scale,
+           (rec.width + 2 * pad) * scale, (rec.height + 2 * pad) * scale},
+      });
+    }
+    float advance = glyph.advanceX ? glyph.advanceX : rec.width;
+    x += advance * scale + spacing;
+  }
+  run.width = std::max(run.width, x - spacing);
+}
+
+void queueRun(BakedFont &baked, const TextRun &run, Vector2 pos,
+              Color color) {
+  for (const GlyphQuad &q : run.quads) {
+    baked.queue.push_back({q.src,
+                           {pos.x + q.dst.x, pos.y + q.dst.y, q.dst.width,
+                            q.dst.height},
+                           color});
+  }
+}
+
+const TextRun &labelRun(const char *text, int fontSize, BakedFont &baked,
+                        float scale) {
+  std::unordered_map<std::string, TextRun> &runs = labels[fontSize];
+  label_key.assign(text);
+  auto it = runs.find(label_key);
+  if (it == runs.end()) {
+    it = runs.emplace(label_key, TextRun{}).first;
+    shape(baked, scale, fontSize, text, it->second);
+  }
+  return it->second;
+}
+
+} // namespace
+
+void TextRenderer::Init(const std::string &fontPath) {
+  unloadFonts();
+  ResourcePack::View packed;
+  bool found = FileExists(fontPath.c_str()) ||
+               ResourcePack::Find(fontPath, packed);
+  font_path = found ? fontPath : std::string();
+  ttf_failed = false;
+}
+
+void TextRenderer::Draw(const char *text, Vector2 pos, int fontSize,
+                        Color color) {
+  float scale;
+  BakedFont &baked = fontFor(fontSize, scale);
+  shape(baked, scale, fontSize, text, scratch_run);
+  queueRun(baked, scratch_run, pos, color);
+}
+
+float TextRenderer::Measure(const char *text, int fontSize) {
+  float scale;
+  BakedFont &baked = fontFor(fontSize, scale);
+  shape(baked, scale, fontSize, text, scratch_run);
+  return scratch_run.width;
+}
+
+void TextRenderer::DrawLabel(const char *text, Vector2 pos, int fontSize,
+                             Color color) {
+  float scale;
+  BakedFont &baked = fontFor(fontSize, scale);
+  queueRun(baked, labelRun(text, fontSize, baked, scale), pos, color);
+}
+
+float TextRenderer::MeasureLabel(const char *text, int fontSize) {
+  float scale;
+  BakedFont &baked = fontFor(fontSize, scale);
+  return labelRun(text, fontSize, baked, scale).width;
+}
+
+void TextRenderer::Flush() {
+  for (auto &[size, baked] : fonts) {
+    if (baked.queue.empty())
+      continue;
+
+    const Texture2D &atlas = baked.font.texture;
+    float invW = 1.0f / atlas.width;
+    float invH = 1.0f / atlas.height;
+
+    // One batch per atlas instead of one DrawTexturePro() per glyph
+    rlSetTexture(atlas.id);
+    rlBegin(RL_QUADS);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    for (const QueuedQuad &q : baked.queue) {
+      float u0 = q.src.x * invW;
+      float v0 = q.src.y * invH;
+      float u1 = (q.src.x + q.src.width) * invW;
+      float v1 = (q.src.y + q.src.height) * invH;
+      rlColor4ub(q.color.r, q.color.g, q.color.b, q.color.a);
+      rlTexCoord2f(u0, v0);
+      rlVertex2f(q.dst.x, q.dst.y);
+      rlTexCoord2f(u0, v1);
+      rlVertex2f(q.dst.x, q.dst.y + q.dst.height);
+      rlTexCoord2f(u1, v1);
+      rlVertex2f(q.dst.x + q.dst.width, q.dst.y + q.dst.height);
+      rlTexCoord2f(u1, v0);
+      rlVertex2f(q.dst.x + q.dst.width, q.dst.y);
+    }
+    rlEnd();
+    rlSetTexture(0);
+
+    baked.queue.clear();
+  }
+}
+
+void TextRenderer::UnloadAll() { unloadFonts(); }
@@ -2,68 +2,87 @@
 #define NANOSVGRAST_IMPLEMENTATION
 
 #include "../include/texture_manager.hpp"
+#include "../include/log.hpp"
+#include "../include/profiler.hpp"
+#include "../include/resource_pack.hpp"
 #include "nanosvg.h"
 #include "nanosvgrast.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <mutex>
 #include <sstream>
-#include <stdio.h>
 #include <vector>
 
 // Textures live for the lifetime of the program and are owned by this.
 static std::unordered_map<std::string, Texture2D> textures;
+static std::unordered_map<std::string, Rectangle> regions; // atlas entries
+// Components are also built on the chunk loader's thread
+static std::mutex registry_mutex;
 
-void TextureManager::LoadSVG(const std::string &name,
-                             const std::string &filePath, float scale) {
-  // Prevent accidental double-loads
-  if (Exists(name)) {
-    printf("ERR:%s Texture already exists\n", name.c_str());
-    return;
-  }
+// What each texture was built from, so hot reload can build it again
+struct TextureSource {
+  std::vector<SVGAtlasEntry> entries; // one entry unless an atlas
+  float scale;
+  bool atlas;
+};
+static std::unordered_map<std::string, TextureSource> sources;
 
+// Transparent gap between atlas entries, so filtering doesn't bleed
+static constexpr int ATLAS_PADDING = 2;
+
+bool TextureManager::RasterizeSVG(const std::string &filePath, float scale,
+                                  SVGRaster &out) {
+  PROFILE_ZONE("RasterizeSVG");
   if (filePath.empty())
-    return;
+    return false;
   if (scale == 0.0f)
     scale = 1.0f;
 
-  std::ifstream file(filePath);
-  if (!file.is_open()) {
-    printf("Failed to open SVG file: %s\n", filePath.c_str());
-    return;
+  // NanoSVG mutates the input buffer, so we must provide a writable copy
+  std::vector<char> svgCopy;
+  ResourcePack::View packed;
+  if (ResourcePack::Find(filePath, packed)) {
+    svgCopy.assign(packed.data, packed.data + packed.size);
+  } else {
+    std::ifstream file(filePath);
+    if (!file.is_open()) {
+      LOG_ERROR("Failed to open SVG file: %s", filePath.c_str());
+      return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string svgContent = buffer.str();
+    svgCopy.assign(svgContent.begin(), svgContent.end());
   }
 
-  std::stringstream buffer;
-  buffer << file.rdbuf();
-  std::string svgContent = buffer.str();
-
-  if (svgContent.empty()) {
-    printf("SVG file is empty: %s\n", filePath.c_str());
-    return;
+  if (svgCopy.empty()) {
+    LOG_ERROR("SVG file is empty: %s", filePath.c_str());
+    return false;
   }
-
-  // NanoSVG mutates the input buffer, so we must provide a writable copy
-  std::vector<char> svgCopy(svgContent.begin(), svgContent.end());
   svgCopy.push_back('\0');
 
   NSVGimage *svg = nsvgParse(svgCopy.data(), "px", 96.0f);
   if (!svg) {
-    printf("Failed to parse SVG: %s\n", filePath.c_str());
-    return;
+    LOG_ERROR("Failed to parse SVG: %s", filePath.c_str());
+    return false;
   }
 
   // Reject malformed SVGs early
   if (svg->width <= 0 || svg->height <= 0) {
-    printf("Invalid SVG dimensions: %fx%f\n", svg->width, svg->height);
+    LOG_ERROR("Invalid SVG dimensions: %fx%f", svg->width, svg->height);
     nsvgDelete(svg);
-    return;
+    return false;
   }
 
   NSVGrasterizer *rast = nsvgCreateRasterizer();
   if (!rast) {
-    printf("Failed to create SVG rasterizer\n");
+    LOG_ERROR("Failed to create SVG rasterizer");
     nsvgDelete(svg);
-    return;
+    return false;
   }
 
   // Final raster size (rounded, clamped)
@@ -76,43 +95,230 @@ void TextureManager::LoadSVG(const std::string &name,
 
   size_t pixelCount = (size_t)w * (size_t)h;
   if (pixelCount > SIZE_MAX / 4) {
-    printf("Invalid buffer size calculation\n");
+    LOG_ERROR("Invalid buffer size calculation");
     nsvgDelete(svg);
     nsvgDeleteRasterizer(rast);
-    return;
+    return false;
   }
 
   // CPU-side RGBA buffer for rasterization
-  std::vector<unsigned char> imgBuffer(pixelCount * 4, 0);
+  out.pixels.assign(pixelCount * 4, 0);
+  out.width = w;
+  out.height = h;
+
+  nsvgRasterize(rast, svg, 0, 0, scale, out.pixels.data(), w, h, w * 4);
+
+  nsvgDelete(svg);
+  nsvgDeleteRasterizer(rast);
+  return true;
+}
 
-  nsvgRasterize(rast, svg, 0, 0, scale, imgBuffer.data(), w, h, w * 4);
+// Pixels of the SVG at `scale`: straight from the resource pack when it
+// holds them pre-rasterized, otherwise rasterized into `scratch`
+static bool rasterFor(const std::string &filePath, float scale,
+                      SVGRaster &scratch, ResourcePack::RasterView &out) {
+  if (ResourcePack::FindRaster(filePath, scale, out))
+    return true;
+  if (!TextureManager::RasterizeSVG(filePath, scale, scratch))
+    return false;
+  out.pixels = scratch.pixels.data();
+  out.width = scratch.width;
+  out.height = scratch.height;
+  return true;
+}
+
+void TextureManager::LoadSVG(const std::string &name,
+                             const std::string &filePath, float scale) {
+  PROFILE_ZONE("LoadSVG");
+  // Prevent accidental double-loads
+  if (Exists(name)) {
+    LOG_WARN("Texture '%s' already exists", name.c_str());
+    return;
+  }
+
+  SVGRaster scratch;
+  ResourcePack::RasterView raster;
+  if (!rasterFor(filePath, scale, scratch, raster))
+    return;
 
   Image rlImage = {};
-  rlImage.data = imgBuffer.data();
-  rlImage.width = w;
-  rlImage.height = h;
+  // Only read by the upload, so mapped pack pages can be passed as is
+  rlImage.data = const_cast<unsigned char *>(raster.pixels);
+  rlImage.width = raster.width;
+  rlImage.height = raster.height;
   rlImage.mipmaps = 1;
   rlImage.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
 
-  // Upload to GPU; after this, imgBuffer is no longer needed
+  // Upload to GPU; after this, the raster is no longer needed
   Texture2D tex = LoadTextureFromImage(rlImage);
   if (tex.id == 0) {
-    printf("Failed to create texture from image\n");
-    nsvgDelete(svg);
-    nsvgDeleteRasterizer(rast);
+    LOG_ERROR("Failed to create texture from image");
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    textures[name] = tex;
+    sources[name] = {{{name, filePath}}, scale, false};
+  }
+
+  LOG_DEBUG("Successfully loaded SVG texture '%s' from %s (%dx%d)",
+            name.c_str(), filePath.c_str(), raster.width, raster.height);
+}
+
+// Rasterizes the entries side by side into `atlas`, top-aligned
+static bool buildAtlas(const std::vector<SVGAtlasEntry> &entries, float scale,
+                       SVGRaster &atlas,
+                       std::vector<std::pair<std::string, Rectangle>> &placed) {
+  std::vector<SVGRaster> scratch(entries.size());
+  std::vector<ResourcePack::RasterView> rasters(entries.size());
+  int width = 0;
+  int height = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (!rasterFor(entries[i].filePath, scale, scratch[i], rasters[i]))
+      return false;
+    width += rasters[i].width + ATLAS_PADDING;
+    height = std::max(height, rasters[i].height);
+  }
+  if (width == 0)
+    return false;
+
+  atlas.pixels.assign((size_t)width * height * 4, 0);
+  atlas.width = width;
+  atlas.height = height;
+  placed.clear();
+  int x = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const ResourcePack::RasterView &r = rasters[i];
+    for (int row = 0; row < r.height; ++row) {
+      std::memcpy(&atlas.pixels[((size_t)row * width + x) * 4],
+                  &r.pixels[(size_t)row * r.width * 4], (size_t)r.width * 4);
+    }
+    placed.push_back({entries[i].name, {(float)x, 0.0f, (float)r.width,
+                                        (float)r.height}});
+    x += r.width + ATLAS_PADDING;
+  }
+  return true;
+}
+
+static Texture2D uploadRaster(const SVGRaster &raster, bool bilinear) {
+  Image rlImage = {};
+  rlImage.data = const_cast<unsigned char *>(raster.pixels.data());
+  rlImage.width = raster.width;
+  rlImage.height = raster.height;
+  rlImage.mipmaps = 1;
+  rlImage.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+
+  Texture2D tex = LoadTextureFromImage(rlImage);
+  if (tex.id != 0 && bilinear)
+    SetTextureFilter(tex, TEXTURE_FILTER_BILINEAR);
+  return tex;
+}
+
+void TextureManager::LoadSVGAtlas(const std::string &name,
+                                  const std::vector<SVGAtlasEntry> &entries,
+                                  float scale) {
+  PROFILE_ZONE("LoadSVGAtlas");
+  if (Exists(name)) {
+    LOG_WARN("Texture '%s' already exists", name.c_str());
+    return;
+  }
+
+  SVGRaster atlas;
+  std::vector<std::pair<std::string, Rectangle>> placed;
+  if (!buildAtlas(entries, scale, atlas, placed))
+    return;
+
+  Texture2D tex = uploadRaster(atlas, true);
+  if (tex.id == 0) {
+    LOG_ERROR("Failed to create atlas texture '%s'", name.c_str());
     return;
   }
 
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (const auto &[entry, rect] : placed)
+    regions[entry] = rect;
   textures[name] = tex;
+  sources[name] = {entries, scale, true};
 
-  printf("Successfully loaded SVG texture '%s' from %s (%dx%d)\n", name.c_str(),
-         filePath.c_str(), w, h);
+  LOG_INFO("Successfully built SVG atlas '%s' (%dx%d, %zu entries)",
+           name.c_str(), atlas.width, atlas.height, entries.size());
+}
 
-  nsvgDelete(svg);
-  nsvgDeleteRasterizer(rast);
+static std::string normalPath(const std::string &path) {
+  return std::filesystem::path(path).lexically_normal().string();
+}
+
+void TextureManager::Rebuild(const std::string &filePath,
+                             std::vector<TextureRebuild> &out) {
+  PROFILE_ZONE("TextureManager::Rebuild");
+  std::string changed = normalPath(filePath);
+  std::vector<std::pair<std::string, TextureSource>> affected;
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto &[name, source] : sources) {
+      for (const SVGAtlasEntry &entry : source.entries) {
+        if (normalPath(entry.filePath) == changed) {
+          affected.push_back({name, source});
+          break;
+        }
+      }
+    }
+  }
+
+  for (const auto &[name, source] : affected) {
+    TextureRebuild rebuild;
+    rebuild.name = name;
+    rebuild.atlas = source.atlas;
+    bool built = source.atlas
+                     ? buildAtlas(source.entries, source.scale, rebuild.raster,
+                                  rebuild.regions)
+                     : RasterizeSVG(source.entries[0].filePath, source.scale,
+                                    rebuild.raster);
+    if (built)
+      out.push_back(std::move(rebuild));
+  }
+}
+
+void TextureManager::Replace(const TextureRebuild &rebuild) {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  auto it = textures.find(rebuild.name);
+  if (it == textures.end())
+    return;
+
+  Texture2D &tex = it->second;
+  const SVGRaster &raster = rebuild.raster;
+  if (tex.id != 0 && tex.width == raster.width &&
+      tex.height == raster.height) {
+    UpdateTexture(tex, raster.pixels.data());
+  } else {
+    Texture2D fresh = uploadRaster(raster, rebuild.atlas);
+    if (fresh.id == 0) {
+      LOG_ERROR("Failed to reload texture '%s'", rebuild.name.c_str());
+      return;
+    }
+    if (tex.id != 0)
+      UnloadTexture(tex);
+    tex = fresh; // in place, so held references see it
+  }
+  for (const auto &[entry, rect] : rebuild.regions)
+    regions[entry] = rect;
+  LOG_INFO("Reloaded texture '%s' (%dx%d)", rebuild.name.c_str(),
+           raster.width, raster.height);
+}
+
+const Rectangle &TextureManager::GetRegion(const std::string &name) {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  auto it = regions.find(name);
+  if (it == regions.end()) {
+    static const Rectangle empty = {0, 0, 0, 0};
+    return empty;
+  }
+  return it->second;
 }
 
 Texture2D &TextureManager::Get(const std::string &name) {
+  std::lock_guard<std::mutex> lock(registry_mutex);
   auto it = textures.find(name);
   if (it == textures.end()) {
     // Safe null texture to avoid crashes at call sites
@@ -123,10 +329,12 @@ Texture2D &TextureManager::Get(const std::string &name) {
 }
 
 bool TextureManager::Exists(const std::string &name) {
+  std::lock_guard<std::mutex> lock(registry_mutex);
   return textures.find(name) != textures.end();
 }
 
 void TextureManager::UnloadAll() {
+  std::lock_guard<std::mutex> lock(registry_mutex);
   // Explicitly free GPU resources
   for (auto &[name, tex] : textures) {
     if (tex.id != 0) {
@@ -134,4 +342,6 @@ void TextureManager::UnloadAll() {
     }
   }
   textures.clear();
+  regions.clear();
+  sources.clear();
 }
@@ -0,0 +1,112 @@
+#include "../include/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+// Set while the thread runs a pool task or a loop body
+static thread_local bool in_pool_work = false;
+
+ThreadPool::ThreadPool(size_t threads) : thread_count(threads) {
+  if (thread_count == 0) {
+    size_t hardware = std::thread::hardware_concurrency();
+    thread_count = std::max<size_t>(hardware, 2) - 1;
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    tasks.clear();
+  }
+  wake.notify_all();
+  for (std::thread &worker : workers)
+    worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(std::move(task));
+    if (workers.empty()) {
+      for (size_t i = 0; i < thread_count; ++i)
+        workers.emplace_back(&ThreadPool::run, this);
+    }
+  }
+  wake.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count,
+                             const std::function<void(size_t)> &fn) {
+  if (count == 0)
+    return;
+
+  // A loop inside a task or another loop runs where it is: the work around
+  // it already keeps the pool busy
+  if (in_pool_work) {
+    for (size_t i = 0; i < count; ++i)
+      fn(i);
+    return;
+  }
+
+  // Helpers may start after the loop is done; they then find no index left
+  // and never touch `fn`
+  struct Loop {
+    std::atomic<size_t> next{0};
+    size_t count = 0;
+    const std::function<void(size_t)> *fn = nullptr;
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t done = 0;
+  };
+  auto loop = std::make_shared<Loop>();
+  loop->count = count;
+  loop->fn = &fn;
+
+  auto work = [loop] {
+    size_t ran = 0;
+    bool nested = in_pool_work;
+    in_pool_work = true;
+    for (size_t i; (i = loop->next++) < loop->count; ++ran)
+      (*loop->fn)(i);
+    in_pool_work = nested;
+    if (ran == 0)
+      return;
+    std::lock_guard<std::mutex> lock(loop->mutex);
+    loop->done += ran;
+    if (loop->done == loop->count)
+      loop->finished.notify_all();
+  };
+
+  // The calling thread works too
+  size_t helpers = std::min(thread_count, count - 1);
+  for (size_t i = 0; i < helpers; ++i)
+    submit(work);
+  work();
+
+  std::unique_lock<std::mutex> lock(loop->mutex);
+  loop->finished.wait(lock, [&] { return loop->done == loop->count; });
+}
+
+void ThreadPool::run() {
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [&] { return stopping || !tasks.empty(); });
+      if (stopping)
+        return;
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    in_pool_work = true;
+    task();
+    in_pool_work = false;
+  }
+}
+
+ThreadPool &threadPool() {
+  static ThreadPool pool;
+  return pool;
+}
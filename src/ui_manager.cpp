@@ -1,6 +1,7 @@
 #include "../include/ui_manager.hpp"
 #include "../include/level_manager.hpp"
 #include "../include/path_utils.hpp"
+#include "../include/text_renderer.hpp"
 #include "../include/texture_manager.hpp"
 #include "../include/ui_utils.hpp"
 #include "raylib.h"
@@ -35,7 +36,7 @@ void drawUIButton(const UIButton &button) {
   }
 
   drawUIRect(12.0f, 0.15f, button.bounds);
-  drawUITextCentered(button.fontSize, button.bounds, button.text,
+  drawUITextCentered(button.fontSize, button.bounds, button.text.c_str(),
                      button.textColor);
 }
 
@@ -52,24 +53,24 @@ void drawImage(const std::string &name, const Rectangle &bounds) {
                  bounds, {0.0f, 0.0f}, 0.0f, WHITE);
 }
 
-void drawUIText(int fontSize, const Vector2 &textPos, const std::string &text,
+void drawUIText(int fontSize, const Vector2 &textPos, const char *text,
                 const Color &textColor) {
   int scaledFontSize = fontSize * safeScreenScale;
-  int textWidth = MeasureText(text.c_str(), scaledFontSize);
-  DrawText(text.c_str(), textPos.x - textWidth / 2.0f, textPos.y,
-           scaledFontSize, textColor);
+  float textWidth = TextRenderer::MeasureLabel(text, scaledFontSize);
+  TextRenderer::DrawLabel(text, {textPos.x - textWidth / 2.0f, textPos.y},
+                          scaledFontSize, textColor);
 }
 
 void drawUITextCentered(int fontSize, const Rectangle &bounds,
-                        const std::string &text, const Color &textColor) {
+                        const char *text, const Color &textColor) {
   int scaledFontSize = fontSize * safeScreenScale;
-  int textWidth = MeasureText(text.c_str(), scaledFontSize);
+  float textWidth = TextRenderer::MeasureLabel(text, scaledFontSize);
 
   Vector2 textPos = {
       bounds.x + (bounds.width - textWidth) / 2.0f,
       bounds.y + (bounds.height - scaledFontSize) / 2.0f,
   };
-  DrawText(text.c_str(), textPos.x, textPos.y, scaledFontSize, textColor);
+  TextRenderer::DrawLabel(text, textPos, scaledFontSize, textColor);
 }
 
 // Input Functions
@@ -1,5 +1,6 @@
 #include "../include/window_manager.hpp"
 #include "../include/settings.hpp"
+#include "../include/ui_utils.hpp"
 #include "raylib.h"
 
 void createWindow() {
@@ -28,3 +29,20 @@ void createWindow() {
   SetExitKey(0); // Disables Escape key from CloseWindow
   SetTargetFPS(globalSettings.refreshRate);
 }
+
+void updateWindowSize() {
+  int width = GetScreenWidth();
+  int height = GetScreenHeight();
+
+  // Minimized windows report a zero size; keep the last layout
+  if (width <= 0 || height <= 0)
+    return;
+  if (width == globalSettings.screenWidth &&
+      height == globalSettings.screenHeight)
+    return;
+
+  // Not saved: the settings file keeps the size the user chose
+  globalSettings.screenWidth = width;
+  globalSettings.screenHeight = height;
+  calculateScreenScale();
+}
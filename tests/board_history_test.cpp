@@ -0,0 +1,128 @@
+#include "board_history.hpp"
+#include "level_manager.hpp"
+#include <cstdio>
+#include <memory>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    ++failures;
+  }
+}
+
+static ComponentRecord part(ComponentLabel label, float x, float y) {
+  ComponentRecord rec;
+  rec.alive = true;
+  rec.label = label;
+  rec.position = {x, y};
+  return rec;
+}
+
+static ConnectionRecord wire(uint32_t a, int16_t pin_a, uint32_t b,
+                             int16_t pin_b) {
+  ConnectionRecord rec;
+  rec.alive = true;
+  rec.component_a = a;
+  rec.pin_a = pin_a;
+  rec.component_b = b;
+  rec.pin_b = pin_b;
+  return rec;
+}
+
+// Every live wire ends on pins of live parts, the ones its record names
+static bool wiresLinked(const ElectronicsLevel &level) {
+  const BoardState &board = level.getBoardState();
+  for (const Connection &c : level.getConnections()) {
+    const ConnectionRecord &rec = board.connections[c.getId()];
+    const Pin *ends[2] = {c.getPin(0), c.getPin(1)};
+    uint32_t owners[2] = {rec.component_a, rec.component_b};
+    int16_t pins[2] = {rec.pin_a, rec.pin_b};
+    for (int e = 0; e < 2; ++e) {
+      bool found = false;
+      for (const auto &obj : level.getObjects())
+        if (obj->id == owners[e] && pins[e] >= 0 &&
+            (size_t)pins[e] < obj->pins.size() &&
+            &obj->pins[pins[e]] == ends[e])
+          found = true;
+      if (!found)
+        return false;
+    }
+  }
+  return true;
+}
+
+static size_t liveWireRecords(const BoardState &board) {
+  size_t n = 0;
+  for (size_t id = 0; id < board.connections.size(); ++id)
+    n += board.connections[id].alive;
+  return n;
+}
+
+// Parts added after a reset get fresh ids, and undoing past the reset
+// brings the old board back with its wires on the recreated parts.
+static void undoAcrossReset() {
+  ElectronicsLevel level;
+  BoardState board;
+  board.components.push_back(part(ComponentLabel::Battery, 0, 0));
+  board.components.push_back(part(ComponentLabel::Led, 200, 0));
+  board.connections.push_back(wire(0, 0, 1, 1));
+  level.loadBoard(board);
+
+  level.resetLevel();
+  check(level.getObjects().empty(), "reset clears the board");
+  check(level.getBoardState().components.size() == 2,
+        "reset keeps ids counting up");
+
+  BoardState after = level.getBoardState();
+  after.components.push_back(part(ComponentLabel::Led, 0, 300));
+  after.components.push_back(part(ComponentLabel::Battery, 200, 300));
+  after.connections.push_back(wire(2, 0, 3, 1));
+  level.applyBoard(after);
+  check(level.getObjects().size() == 2, "new parts after reset");
+  check(level.getObjects()[0]->id >= 2 && level.getObjects()[1]->id >= 2,
+        "new parts don't reuse ids from before the reset");
+
+  level.undo();
+  level.undo();
+  check(level.getObjects().size() == 2, "undo restores both parts");
+  check(level.getConnections().size() == 1, "undo restores the wire");
+  check(wiresLinked(level), "restored wire ends on live pins");
+
+  level.redo();
+  level.redo();
+  check(level.getObjects().size() == 2, "redo restores the new parts");
+  check(level.getConnections().size() ==
+            liveWireRecords(level.getBoardState()),
+        "redo restores the new wire");
+  check(wiresLinked(level), "redone wire ends on live pins");
+}
+
+// A part that changes kind is made anew; its unchanged wires must follow.
+static void undoRelinksRecreatedParts() {
+  ElectronicsLevel level;
+  BoardState board;
+  board.components.push_back(part(ComponentLabel::Battery, 0, 0));
+  board.components.push_back(part(ComponentLabel::Led, 200, 0));
+  board.connections.push_back(wire(0, 0, 1, 1));
+  level.loadBoard(board);
+
+  BoardState swapped = board;
+  swapped.components.set(0, part(ComponentLabel::Led, 0, 0));
+  level.applyBoard(swapped);
+  check(level.getConnections().size() == 1, "wire kept across a swap");
+  check(wiresLinked(level), "swapped part's wire ends on live pins");
+
+  level.undo();
+  check(level.getConnections().size() == 1, "wire kept across undo");
+  check(wiresLinked(level), "undone part's wire ends on live pins");
+}
+
+int main() {
+  undoAcrossReset();
+  undoRelinksRecreatedParts();
+  if (failures == 0)
+    printf("board_history_test: all passed\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+#include "board_history.hpp"
+#include "circuit_generator.hpp"
+#include "simulation/electronics_simulation.hpp"
+#include "simulation/solution_cache.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+    ++failures;
+  }
+}
+
+static bool near(double a, double b, double tolerance) {
+  return std::fabs(a - b) <= tolerance * std::max(1.0, std::fabs(b));
+}
+
+// Pin voltages, current and LED state of every live part agree within
+// `tolerance` (relative, absolute below 1)
+static bool sameResults(const BoardState &board,
+                        const ElectronicsSimulation &a,
+                        const ElectronicsSimulation &b, double tolerance) {
+  for (size_t id = 0; id < board.components.size(); ++id) {
+    const ComponentRecord &rec = board.components[id];
+    if (!rec.alive)
+      continue;
+    uint32_t part = static_cast<uint32_t>(id);
+    auto x = makeComponentFromRecord(rec, part);
+    auto y = makeComponentFromRecord(rec, part);
+    if (!x || !y)
+      continue;
+    a.applyResults(*x);
+    b.applyResults(*y);
+    for (size_t k = 0; k < x->pins.size(); ++k) {
+      if (!near(x->pins[k].getVoltage(), y->pins[k].getVoltage(), tolerance))
+        return false;
+    }
+    if (!near(a.componentCurrent(part), b.componentCurrent(part), tolerance) ||
+        a.componentPowered(part) != b.componentPowered(part) ||
+        a.componentDamaged(part) != b.componentDamaged(part))
+      return false;
+  }
+  return true;
+}
+
+static void solveFresh(ElectronicsSimulation &sim, const BoardState &board) {
+  sim.build(board);
+  sim.solve();
+}
+
+// `count` separate circuits on one board, so that an edit leaves most of
+// its islands as they were
+static BoardState severalCircuits(CircuitTopology topology, int count,
+                                  uint32_t seed) {
+  BoardState board;
+  for (int c = 0; c < count; ++c) {
+    CircuitGeneratorOptions options;
+    options.topology = topology;
+    options.parts = 40;
+    options.seed = seed * 100 + c;
+    BoardState circuit = generateCircuit(options);
+    uint32_t first = static_cast<uint32_t>(board.components.size());
+    for (size_t id = 0; id < circuit.components.size(); ++id) {
+      ComponentRecord rec = circuit.components[id];
+      rec.position.x += 5000.0f * c;
+      board.components.push_back(rec);
+    }
+    for (size_t id = 0; id < circuit.connections.size(); ++id) {
+      ConnectionRecord rec = circuit.connections[id];
+      rec.component_a += first;
+      rec.component_b += first;
+      board.connections.push_back(rec);
+    }
+  }
+  return board;
+}
+
+// One random edit of the kind the editor makes: a value, a part or a wire
+static void randomEdit(BoardState &board, std::mt19937 &rng) {
+  auto pick = [&](size_t n) { return static_cast<uint32_t>(rng() % n); };
+  uint32_t id = pick(board.components.size());
+  ComponentRecord rec = board.components[id];
+  switch (rng() % 4) {
+  case 0:
+    rec.resistance = 0.1f + static_cast<float>(rng() % 100);
+    rec.voltage = 1.0f + static_cast<float>(rng() % 12);
+    board.components.set(id, rec);
+    break;
+  case 1:
+    rec.alive = !rec.alive;
+    board.components.set(id, rec);
+    break;
+  case 2:
+    if (board.connections.size() > 0)
+      board.connections.set(pick(board.connections.size()),
+                            ConnectionRecord{});
+    break;
+  default: {
+    ConnectionRecord wire;
+    wire.alive = true;
+    wire.component_a = id;
+    wire.pin_a = static_cast<int16_t>(rng() % 2);
+    wire.component_b = pick(board.components.size());
+    wire.pin_b = static_cast<int16_t>(rng() % 2);
+    board.connections.push_back(wire);
+    break;
+  }
+  }
+}
+
+// Building on top of the last solve, as the game does after every edit,
+// gives what a simulation that never saw the earlier boards does.
+static void incrementalMatchesFresh() {
+  int partial_solves = 0; // builds that kept some islands' last solve
+  const CircuitTopology topologies[] = {CircuitTopology::RandomPlanar,
+                                        CircuitTopology::LedArray,
+                                        CircuitTopology::ResistorMesh};
+  for (CircuitTopology topology : topologies) {
+    for (uint32_t seed = 1; seed <= 3; ++seed) {
+      BoardState board = severalCircuits(topology, 4, seed);
+      std::mt19937 rng(seed);
+      std::vector<BoardState> undo;
+      ElectronicsSimulation live;
+      for (int step = 0; step < 40; ++step) {
+        if (!undo.empty() && rng() % 3 == 0) {
+          board = undo.back();
+          undo.pop_back();
+        } else {
+          undo.push_back(board);
+          randomEdit(board, rng);
+        }
+        live.build(board);
+        live.solve();
+        partial_solves += live.lastSolvedIslands() < live.islandCount();
+
+        ElectronicsSimulation fresh;
+        solveFresh(fresh, board);
+        char what[96];
+        snprintf(what, sizeof(what), "%s seed %u step %d: incremental solve",
+                 circuitTopologyName(topology), seed, step);
+        check(sameResults(board, live, fresh, 1e-9), what);
+      }
+    }
+  }
+  check(partial_solves > 0, "edits leave other islands unsolved");
+}
+
+// An island taken from the solution cache carries the results of solving it
+static void cacheHitMatchesColdSolve() {
+  BoardState board = severalCircuits(CircuitTopology::RandomPlanar, 4, 7);
+
+  SolutionCache cache;
+  ElectronicsSimulation first;
+  first.setSolutionCache(&cache);
+  solveFresh(first, board);
+
+  ElectronicsSimulation cached;
+  cached.setSolutionCache(&cache);
+  cached.build(board);
+  check(cached.lastCacheHits() == cached.islandCount(),
+        "every island is a cache hit");
+  cached.solve();
+
+  ElectronicsSimulation cold;
+  solveFresh(cold, board);
+  check(sameResults(board, cached, cold, 1e-12), "cache hit results");
+}
+
+// Conjugate gradients converge on what the direct factorization gives
+static void iterativeMatchesDirect() {
+  CircuitGeneratorOptions options;
+  options.topology = CircuitTopology::ResistorMesh;
+  options.parts = 400;
+  BoardState board = generateCircuit(options);
+
+  ElectronicsSimulation direct;
+  direct.setSolverBackend(ElectronicsSimulation::SolverBackend::Direct);
+  solveFresh(direct, board);
+
+  ElectronicsSimulation iterative;
+  iterative.setSolverBackend(ElectronicsSimulation::SolverBackend::Iterative);
+  solveFresh(iterative, board);
+  check(iterative.iterativeIslandCount() == iterative.islandCount(),
+        "mesh solved iteratively");
+  check(sameResults(board, iterative, direct, 1e-6),
+        "iterative mesh results");
+}
+
+int main() {
+  incrementalMatchesFresh();
+  cacheHitMatchesColdSolve();
+  iterativeMatchesDirect();
+  if (failures == 0)
+    printf("simulation_test: all passed\n");
+  return failures == 0 ? 0 : 1;
+}
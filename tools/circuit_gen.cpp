@@ -0,0 +1,118 @@
+// voltquest_gen: writes a procedurally generated board as a level file.
+//
+//   voltquest_gen --topology mesh --parts 10000 --density 0.5 --seed 7
+//                 --out resources/levels/stress_mesh.json
+
+#include "circuit_generator.hpp"
+#include "level_file.hpp"
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+static void printUsage() {
+  fprintf(stderr,
+          "usage: voltquest_gen [--topology <name>] [--parts <n>]\n"
+          "                     [--density <0..1>] [--seed <n>]\n"
+          "                     [--voltage <volts>] [--out <file.json>]\n"
+          "topologies: ladder, mesh, led-array, series-parallel, "
+          "random-planar\n");
+}
+
+// Whole-string parses; false on trailing garbage or a value out of range
+static bool parseInteger(const char *text, long long min, long long max,
+                         long long &out) {
+  char *end = nullptr;
+  errno = 0;
+  long long value = std::strtoll(text, &end, 10);
+  if (end == text || *end != '\0' || errno == ERANGE || value < min ||
+      value > max)
+    return false;
+  out = value;
+  return true;
+}
+
+static bool parseFloat(const char *text, float min, float max, float &out) {
+  char *end = nullptr;
+  errno = 0;
+  float value = std::strtof(text, &end);
+  if (end == text || *end != '\0' || errno == ERANGE ||
+      !std::isfinite(value) || value < min || value > max)
+    return false;
+  out = value;
+  return true;
+}
+
+static constexpr long long MAX_PARTS = 1000000;
+
+int main(int argc, char **argv) {
+  CircuitGeneratorOptions options;
+  std::string outPath;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--topology" && hasValue) {
+      if (!parseCircuitTopology(argv[++i], options.topology)) {
+        fprintf(stderr, "Unknown topology: %s\n", argv[i]);
+        printUsage();
+        return 1;
+      }
+    } else if (arg == "--parts" && hasValue) {
+      long long parts = 0;
+      if (!parseInteger(argv[++i], 1, MAX_PARTS, parts)) {
+        fprintf(stderr, "--parts takes a count from 1 to %lld: %s\n",
+                MAX_PARTS, argv[i]);
+        printUsage();
+        return 1;
+      }
+      options.parts = static_cast<int>(parts);
+    } else if (arg == "--density" && hasValue) {
+      if (!parseFloat(argv[++i], 0.0f, 1.0f, options.wire_density)) {
+        fprintf(stderr, "--density takes a value from 0 to 1: %s\n",
+                argv[i]);
+        printUsage();
+        return 1;
+      }
+    } else if (arg == "--seed" && hasValue) {
+      long long seed = 0;
+      if (!parseInteger(argv[++i], 0, UINT32_MAX, seed)) {
+        fprintf(stderr, "--seed takes an unsigned 32-bit number: %s\n",
+                argv[i]);
+        printUsage();
+        return 1;
+      }
+      options.seed = static_cast<uint32_t>(seed);
+    } else if (arg == "--voltage" && hasValue) {
+      if (!parseFloat(argv[++i], 0.0f, 1e6f, options.battery_voltage) ||
+          options.battery_voltage <= 0.0f) {
+        fprintf(stderr, "--voltage takes a positive number of volts: %s\n",
+                argv[i]);
+        printUsage();
+        return 1;
+      }
+    } else if (arg == "--out" && hasValue) {
+      outPath = argv[++i];
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  BoardState board = generateCircuit(options);
+
+  if (outPath.empty()) {
+    std::cout << serializeBoard(board) << '\n';
+    return 0;
+  }
+  if (!saveLevelFile(outPath, board))
+    return 1;
+
+  fprintf(stderr, "Wrote %s board (%zu parts, %zu wires) to %s\n",
+          circuitTopologyName(options.topology), board.components.size(),
+          board.connections.size(), outPath.c_str());
+  return 0;
+}
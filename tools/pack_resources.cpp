@@ -0,0 +1,116 @@
+// voltquest_pack: packs the resources folder into one archive that the game
+// maps at startup, with every SVG also pre-rasterized at common scales.
+//
+//   voltquest_pack --root resources --out build/resources.vqpack
+//                  [--scales 0.5,1,1.333,2]
+
+#include "resource_pack.hpp"
+#include "texture_manager.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// The screen scales of 720p, 768p, 1080p, 1440p and 2160p, and half of
+// each for the impostor atlas
+static const char *DEFAULT_SCALES =
+    "0.333,0.356,0.5,0.667,0.711,1,1.333,2";
+
+static void printUsage() {
+  fprintf(stderr, "usage: voltquest_pack --root <resources dir> "
+                  "--out <file.vqpack>\n"
+                  "                      [--scales <s1,s2,...>]\n");
+}
+
+static std::vector<float> parseScales(const std::string &list) {
+  std::vector<float> scales;
+  size_t start = 0;
+  while (start < list.size()) {
+    size_t end = list.find(',', start);
+    if (end == std::string::npos)
+      end = list.size();
+    float scale = static_cast<float>(
+        std::atof(list.substr(start, end - start).c_str()));
+    if (scale > 0.0f)
+      scales.push_back(scale);
+    start = end + 1;
+  }
+  return scales;
+}
+
+int main(int argc, char **argv) {
+  std::string root;
+  std::string outPath;
+  std::string scaleList = DEFAULT_SCALES;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--root" && hasValue) {
+      root = argv[++i];
+    } else if (arg == "--out" && hasValue) {
+      outPath = argv[++i];
+    } else if (arg == "--scales" && hasValue) {
+      scaleList = argv[++i];
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (root.empty() || outPath.empty()) {
+    printUsage();
+    return 1;
+  }
+
+  std::error_code error;
+  fs::recursive_directory_iterator it(root, error);
+  if (error) {
+    fprintf(stderr, "Failed to read %s: %s\n", root.c_str(),
+            error.message().c_str());
+    return 1;
+  }
+
+  std::vector<float> scales = parseScales(scaleList);
+  ResourcePackWriter pack;
+  size_t files = 0;
+  for (const fs::directory_entry &entry : it) {
+    if (!entry.is_regular_file())
+      continue;
+    const fs::path &path = entry.path();
+    if (path.filename().string().front() == '.')
+      continue; // .placeholder and friends
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)),
+                                     std::istreambuf_iterator<char>());
+    if (!file.good() && !file.eof()) {
+      fprintf(stderr, "Failed to read %s\n", path.string().c_str());
+      return 1;
+    }
+    // Names are relative to the root, with forward slashes
+    std::string name = path.lexically_relative(root).generic_string();
+    pack.addFile(name, std::move(bytes));
+    ++files;
+
+    if (path.extension() != ".svg")
+      continue;
+    for (float scale : scales) {
+      SVGRaster raster;
+      if (!TextureManager::RasterizeSVG(path.string(), scale, raster))
+        return 1;
+      pack.addRaster(name, scale, raster.width, raster.height,
+                     std::move(raster.pixels));
+    }
+  }
+
+  if (!pack.write(outPath))
+    return 1;
+  fprintf(stderr, "Packed %zu files (%zu entries) into %s\n", files,
+          pack.entryCount(), outPath.c_str());
+  return 0;
+}
@@ -0,0 +1,186 @@
+// voltquest_replay: replays a recorded level session (voltquest --record)
+// at an unlocked frame rate and reports per-frame timings as JSON.
+//
+//   voltquest_replay session.vqinput --out timings.json
+//   voltquest_replay session.vqinput --headless --final-board board.json
+//
+// By default frames are drawn into a hidden window, so rendering is timed
+// too; --headless runs input, edits and simulation only.
+
+#include "frame_arena.hpp"
+#include "input_manager.hpp"
+#include "input_recording.hpp"
+#include "level_file.hpp"
+#include "level_manager.hpp"
+#include "profiler.hpp"
+#include "settings.hpp"
+#include "ui_utils.hpp"
+#include "raylib.h"
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void printUsage() {
+  fprintf(stderr,
+          "usage: voltquest_replay <recording> [--headless] [--out <file>]\n"
+          "                        [--final-board <file>] [--trace <file>]\n");
+}
+
+// FNV-1a, so digests compare across machines and runs
+static uint64_t digest(const std::string &text) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : text) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+static double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty())
+    return 0.0;
+  size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+  return sorted[i];
+}
+
+int main(int argc, char **argv) {
+  std::string recordingPath, outPath, boardPath, tracePath;
+  bool headless = false;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--headless") {
+      headless = true;
+    } else if (arg == "--out" && hasValue) {
+      outPath = argv[++i];
+    } else if (arg == "--final-board" && hasValue) {
+      boardPath = argv[++i];
+    } else if (arg == "--trace" && hasValue) {
+      tracePath = argv[++i];
+    } else if (recordingPath.empty() && arg[0] != '-') {
+      recordingPath = arg;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (recordingPath.empty()) {
+    printUsage();
+    return 1;
+  }
+
+  InputRecording recording;
+  if (!loadInputRecording(recordingPath, recording))
+    return 1;
+
+  // Layout and snapping scale with the window, so match the recording
+  globalSettings.screenWidth = recording.screen_width;
+  globalSettings.screenHeight = recording.screen_height;
+  calculateScreenScale();
+
+  if (!headless) {
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(recording.screen_width, recording.screen_height,
+               "VoltQuest replay");
+    SetTargetFPS(0);
+  }
+
+  std::vector<double> frameMs;
+  std::vector<uint64_t> frameAllocs;
+  frameMs.reserve(recording.frames.size());
+  frameAllocs.reserve(recording.frames.size());
+  BoardState finalBoard;
+  {
+    ElectronicsLevel level;
+    if (!headless)
+      level.loadTextures(); // components keep a reference to their texture
+    level.setStreaming(recording.streaming);
+    level.loadBoard(recording.initial_board);
+    level.setCamera(recording.camera);
+
+    using Clock = std::chrono::steady_clock;
+    for (const InputFrame &frame : recording.frames) {
+      frameArena().reset();
+      InputManager::beginFrame(frame);
+      auto start = Clock::now();
+      if (headless)
+        level.stepLevel();
+      else
+        level.processLevel();
+      auto end = Clock::now();
+      frameMs.push_back(
+          std::chrono::duration<double, std::milli>(end - start).count());
+      PROFILE_FRAME();
+      frameAllocs.push_back(Profiler::lastFrameAllocations());
+    }
+    finalBoard = level.getBoardState();
+  }
+
+  if (!headless)
+    CloseWindow();
+
+  std::vector<double> sorted = frameMs;
+  std::sort(sorted.begin(), sorted.end());
+  double total = 0.0;
+  for (double ms : frameMs)
+    total += ms;
+
+  std::string board = serializeBoard(finalBoard);
+  char digestHex[17];
+  snprintf(digestHex, sizeof(digestHex), "%016llx",
+           static_cast<unsigned long long>(digest(board)));
+
+  nlohmann::json report = {
+      {"recording", recordingPath},
+      {"mode", headless ? "headless" : "offscreen"},
+      {"screen", {recording.screen_width, recording.screen_height}},
+      {"frames", frameMs.size()},
+      {"summary",
+       {
+           {"total_ms", total},
+           {"mean_ms", frameMs.empty() ? 0.0 : total / frameMs.size()},
+           {"min_ms", percentile(sorted, 0.0)},
+           {"median_ms", percentile(sorted, 0.5)},
+           {"p95_ms", percentile(sorted, 0.95)},
+           {"p99_ms", percentile(sorted, 0.99)},
+           {"max_ms", percentile(sorted, 1.0)},
+       }},
+      // Identical across runs of the same recording; a change means the
+      // replay diverged, not just got slower
+      {"final_board", {{"digest", digestHex}}},
+      {"frame_ms", frameMs},
+  };
+#ifdef VOLTQUEST_PROFILER
+  // Heap allocations per frame; steady-state frames should have none
+  report["frame_allocations"] = frameAllocs;
+#endif
+
+  if (!boardPath.empty() && !saveLevelFile(boardPath, finalBoard))
+    return 1;
+  if (!tracePath.empty() && !Profiler::exportTrace(tracePath))
+    fprintf(stderr, "Trace export needs a VOLTQUEST_PROFILER build\n");
+
+  fprintf(stderr, "%zu frames, median %.3f ms, p95 %.3f ms, board %s\n",
+          frameMs.size(), percentile(sorted, 0.5), percentile(sorted, 0.95),
+          digestHex);
+
+  if (outPath.empty()) {
+    std::cout << report.dump(2) << '\n';
+    return 0;
+  }
+  std::ofstream out(outPath);
+  if (!out.is_open()) {
+    fprintf(stderr, "Failed to open %s\n", outPath.c_str());
+    return 1;
+  }
+  out << report.dump(2) << '\n';
+  return 0;
+}
@@ -0,0 +1,179 @@
+// voltquest_tolerance: Monte Carlo tolerance analysis of level files.
+// Solves each level many times with resistors drawn within their tolerance
+// and reports how often each LED ends up lit or damaged, as JSON.
+//
+//   voltquest_tolerance resources/levels/*.json --trials 2000
+//   voltquest_tolerance level.json --max-damage-rate 0 --out report.json
+//
+// With --max-damage-rate the exit status is 1 when any level damages an LED
+// in a larger share of trials.
+
+#include "level_file.hpp"
+#include "simulation/electronics_simulation.hpp"
+#include "simulation/tolerance_analysis.hpp"
+#include "thread_pool.hpp"
+#include <nlohmann/json.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void printUsage() {
+  fprintf(stderr,
+          "usage: voltquest_tolerance <level.json>... [--trials <n>]\n"
+          "                           [--seed <n>] [--max-damage-rate <0..1>]\n"
+          "                           [--out <file.json>]\n");
+}
+
+// Whole-string parses; false on trailing garbage or a value out of range
+static bool parseInteger(const char *text, long long min, long long max,
+                         long long &out) {
+  char *end = nullptr;
+  errno = 0;
+  long long value = std::strtoll(text, &end, 10);
+  if (end == text || *end != '\0' || errno == ERANGE || value < min ||
+      value > max)
+    return false;
+  out = value;
+  return true;
+}
+
+static bool parseDouble(const char *text, double min, double max,
+                        double &out) {
+  char *end = nullptr;
+  errno = 0;
+  double value = std::strtod(text, &end);
+  if (end == text || *end != '\0' || errno == ERANGE ||
+      !std::isfinite(value) || value < min || value > max)
+    return false;
+  out = value;
+  return true;
+}
+
+static constexpr long long MAX_TRIALS = 100000000;
+
+int main(int argc, char **argv) {
+  ToleranceAnalysis::Options options;
+  std::vector<std::string> levels;
+  std::string outPath;
+  double maxDamageRate = -1.0; // no limit
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--trials" && hasValue) {
+      long long trials = 0;
+      if (!parseInteger(argv[++i], 1, MAX_TRIALS, trials)) {
+        fprintf(stderr, "--trials takes a count from 1 to %lld: %s\n",
+                MAX_TRIALS, argv[i]);
+        printUsage();
+        return 1;
+      }
+      options.trials = static_cast<int>(trials);
+    } else if (arg == "--seed" && hasValue) {
+      long long seed = 0;
+      if (!parseInteger(argv[++i], 0, UINT32_MAX, seed)) {
+        fprintf(stderr, "--seed takes an unsigned 32-bit number: %s\n",
+                argv[i]);
+        printUsage();
+        return 1;
+      }
+      options.seed = static_cast<uint32_t>(seed);
+    } else if (arg == "--max-damage-rate" && hasValue) {
+      if (!parseDouble(argv[++i], 0.0, 1.0, maxDamageRate)) {
+        fprintf(stderr, "--max-damage-rate takes a share from 0 to 1: %s\n",
+                argv[i]);
+        printUsage();
+        return 1;
+      }
+    } else if (arg == "--out" && hasValue) {
+      outPath = argv[++i];
+    } else if (!arg.empty() && arg[0] != '-') {
+      levels.push_back(arg);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (levels.empty()) {
+    printUsage();
+    return 1;
+  }
+
+  nlohmann::json results = nlohmann::json::array();
+  bool failed = false;
+  for (const std::string &path : levels) {
+    BoardState board;
+    if (!loadLevelFile(path, board)) {
+      failed = true;
+      continue;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ElectronicsSimulation sim;
+    sim.build(board);
+    sim.solve();
+    ToleranceAnalysis::Report report =
+        ToleranceAnalysis::run(sim, board, options);
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    nlohmann::json leds = nlohmann::json::array();
+    for (const ToleranceAnalysis::LedStats &led : report.leds) {
+      leds.push_back({
+          {"id", led.component_id},
+          {"nominal_powered", led.nominal_powered},
+          {"nominal_damaged", led.nominal_damaged},
+          {"powered", led.powered},
+          {"damaged", led.damaged},
+          {"min_current_a", led.min_current},
+          {"mean_current_a", led.mean_current},
+          {"max_current_a", led.max_current},
+      });
+    }
+    double damageRate =
+        report.trials > 0
+            ? static_cast<double>(report.trials_with_damage) / report.trials
+            : 0.0;
+    results.push_back({
+        {"level", path},
+        {"trials", report.trials},
+        {"trials_with_damage", report.trials_with_damage},
+        {"trials_all_powered", report.trials_all_powered},
+        {"damage_rate", damageRate},
+        {"seconds", seconds},
+        {"leds", leds},
+    });
+
+    fprintf(stderr, "%s: %d trials, LED damaged in %d, all lit in %d\n",
+            path.c_str(), report.trials, report.trials_with_damage,
+            report.trials_all_powered);
+    if (maxDamageRate >= 0.0 && damageRate > maxDamageRate)
+      failed = true;
+  }
+
+  nlohmann::json output = {
+      {"seed", options.seed},
+      {"threads", threadPool().size() + 1},
+      {"levels", results},
+  };
+  if (outPath.empty()) {
+    std::cout << output.dump(2) << '\n';
+  } else {
+    std::ofstream out(outPath);
+    if (!out.is_open()) {
+      fprintf(stderr, "Failed to open %s\n", outPath.c_str());
+      return 1;
+    }
+    out << output.dump(2) << '\n';
+  }
+  return failed ? 1 : 0;
+}